@@ -43,7 +43,7 @@ int main() {
     // Test 2: Get employee by ID
     {
         std::string id = "1";
-        Employee* emp = api.getEmployeeById(id);
+        std::optional<Employee> emp = api.getEmployeeById(id);
         json response;
         
         if (emp) {
@@ -130,7 +130,7 @@ int main() {
     // Test 5: Update employee
     {
         std::string id = "2";
-        Employee* emp = api.getEmployeeById(id);
+        std::optional<Employee> emp = api.getEmployeeById(id);
         json response;
         
         if (emp) {
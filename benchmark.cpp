@@ -0,0 +1,795 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "employee.h"
+#include "employee_api.h"
+#include "employee_id.h"
+#include "employee_table.h"
+#include "flat_hash_index.h"
+#include "logger.h"
+#include "snapshot.h"
+#include "substring_search.h"
+#include "work_stealing_pool.h"
+#include "server/httplib.h"
+
+// Synthetic employee i, shaped like the records in common/employees.json
+static Employee makeEmployee(size_t i) {
+    static const char* titles[] = {"Software Engineer", "Accountant", "Sales Assistant", "Senior SDE",
+                                   "Financial Advisor", "Documentation Engineer", "Technical Author"};
+    std::string id = std::to_string(i + 1);
+    return Employee(id, "Employee Number " + id, std::to_string(40000 + (i * 7919) % 400000),
+                    std::to_string(18 + i % 50), titles[i % 7], "employee" + id + "@company.com");
+}
+
+static double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void removeStoreFiles(const std::string& path) {
+    for (const char* suffix : {"", ".journal", ".journal.old", ".tmp"}) {
+        std::filesystem::remove(path + suffix);
+    }
+}
+
+// Read a "Key:   123 kB" line from /proc/self/status
+static long readStatusKb(const char* key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    std::string prefix = std::string(key) + ":";
+    while (std::getline(status, line)) {
+        if (line.compare(0, prefix.size(), prefix) == 0) {
+            return std::stol(line.substr(prefix.size()));
+        }
+    }
+    return -1;
+}
+
+struct StartupResult {
+    double millis;
+    size_t loaded;
+    long peakKb;    // VmHWM growth during the load
+    long finalKb;   // VmRSS growth once loaded
+};
+
+// Load path in a fresh child so peak RSS reflects only this load
+static bool measureStartup(const std::string& path, StartupResult& result) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        std::ofstream("/proc/self/clear_refs") << "5";  // reset VmHWM
+        long baseKb = readStatusKb("VmRSS");
+
+        StartupResult child{};
+        auto start = std::chrono::steady_clock::now();
+        auto api = std::make_unique<EmployeeAPI>(path);
+        child.millis = millisSince(start);
+        child.peakKb = readStatusKb("VmHWM") - baseKb;
+        child.finalKb = readStatusKb("VmRSS") - baseKb;
+        child.loaded = api->getAllEmployees().size();
+        ssize_t ignored = write(fds[1], &child, sizeof(child));
+        (void)ignored;
+        _exit(0);
+    }
+
+    close(fds[1]);
+    bool ok = pid > 0 && read(fds[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+    close(fds[0]);
+    if (pid > 0) {
+        waitpid(pid, nullptr, 0);
+    }
+    return ok;
+}
+
+// Time EmployeeAPI startup from each snapshot format
+static void benchmarkStartup(size_t count) {
+    std::cout << "== startup: " << count << " employees ==\n";
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+
+    for (const char* extension : {".json", ".jsonl", ".bin"}) {
+        std::string path = (dir / ("benchmark_startup" + std::string(extension))).string();
+        removeStoreFiles(path);
+
+        std::string error;
+        bool written = Snapshot::write(path, count, [count](const EmployeeVisitor& visit) {
+            for (size_t i = 0; i < count; i++) {
+                visit(makeEmployee(i));
+            }
+        }, error);
+        if (!written) {
+            std::cerr << "Could not write " << path << ": " << error << std::endl;
+            continue;
+        }
+
+        StartupResult result;
+        if (!measureStartup(path, result)) {
+            std::cerr << "Could not measure startup from " << path << std::endl;
+            removeStoreFiles(path);
+            continue;
+        }
+
+        std::cout << std::left << std::setw(8) << extension << std::right << std::setw(12)
+                  << std::filesystem::file_size(path) << " bytes " << std::setw(10) << std::fixed
+                  << std::setprecision(1) << result.millis << " ms  peak +" << result.peakKb / 1024
+                  << " MiB, final +" << result.finalKb / 1024 << " MiB  (" << result.loaded << " loaded)\n";
+        removeStoreFiles(path);
+    }
+}
+
+// Time the aggregate queries over a store of count employees
+static void benchmarkQueries(size_t count) {
+    std::cout << "== queries: " << count << " employees ==\n";
+    std::string path = (std::filesystem::temp_directory_path() / "benchmark_queries.bin").string();
+    removeStoreFiles(path);
+
+    std::string error;
+    bool written = Snapshot::write(path, count, [count](const EmployeeVisitor& visit) {
+        for (size_t i = 0; i < count; i++) {
+            visit(makeEmployee(i));
+        }
+    }, error);
+    if (!written) {
+        std::cerr << "Could not write " << path << ": " << error << std::endl;
+        return;
+    }
+
+    EmployeeAPI api(path);
+    const int iterations = 20;
+    auto report = [](const char* name, double totalMillis) {
+        std::cout << std::left << std::setw(24) << name << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(3) << totalMillis / iterations << " ms/query\n";
+    };
+
+    int highest = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        highest = std::max(highest, api.getHighestSalaryOfEmployees());
+    }
+    report("highest salary", millisSince(start));
+
+    size_t top = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        top += api.getTop10HighestEarningEmployees().size();
+    }
+    report("top 10 earners", millisSince(start));
+
+    size_t topK = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        topK += api.getTopEarners(1000).size();
+    }
+    report("top 1000 earners", millisSince(start));
+
+    std::uint64_t ranks = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        auto rank = api.getSalaryRank(std::to_string(1 + (i * 7919) % count));
+        ranks += rank ? rank->rank : 0;
+    }
+    report("salary rank", millisSince(start));
+
+    std::int64_t median = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        median += api.getSalaryAtPercentile(50).value_or(0);
+    }
+    report("salary percentile", millisSince(start));
+
+    // A page of 100 from the ordered indexes, and the count of the whole range
+    std::uint64_t inRange = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        inRange += api.getEmployeesInRange("salary", 100000 + i * 1000, 200000, 100)->total;
+    }
+    report("salary range (100)", millisSince(start));
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        inRange += api.getEmployeesInRange("age", 30, 40, 100)->total;
+    }
+    report("age range (100)", millisSince(start));
+
+    // One probe of the unique email index per shard
+    size_t byEmail = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        byEmail += api.getEmployeeByEmail("EMPLOYEE" + std::to_string(1 + (i * 7919) % count) + "@company.com") ? 1 : 0;
+    }
+    report("email lookup", millisSince(start));
+
+    // Autocomplete walks the name and email prefix indexes of every shard
+    size_t completed = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        completed += api.getCompletions("employee number " + std::to_string(1 + i % 9), 10).size();
+    }
+    report("autocomplete (10)", millisSince(start));
+
+    // Three or more characters go through the name trigram index; shorter
+    // needles still scan every name
+    size_t named = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        named += api.getEmployeesByName("NUMBER 77777").size();
+    }
+    report("name search (trigrams)", millisSince(start));
+
+    size_t shortNamed = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        shortNamed += api.getEmployeesByName("77").size();
+    }
+    report("name search (2 chars)", millisSince(start));
+
+    // Fuzzy search runs a Levenshtein automaton over each shard's name words.
+    // The generated names are mostly distinct numbers, whose short digit
+    // prefixes rarely rule a word out, so this is a pessimistic case; words
+    // every name has are counted, not expanded
+    size_t fuzzy = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        fuzzy += api.getEmployeesByNameFuzzy("77787", 1).size();
+    }
+    report("fuzzy name (1 word)", millisSince(start));
+
+    size_t fuzzyAll = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        fuzzyAll += api.getEmployeesByNameFuzzy("Employe Numbr 77787", 2).size();
+    }
+    report("fuzzy name (3 words)", millisSince(start));
+
+    size_t titled = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        titled += api.getEmployeesByTitle("engineer").size();
+    }
+    report("title search", millisSince(start));
+
+    // The reporting query, driven by the salary index, and the same three
+    // predicates under a double negation, which the planner can only scan
+    auto reportFilter = nlohmann::json::parse(R"({"and": [{"field": "title", "op": "contains", "value": "engineer"},
+                                                     {"field": "salary", "op": ">", "value": 400000},
+                                                     {"field": "age", "op": "<", "value": 40}]})");
+    auto planned = Filter::fromJson(reportFilter, error);
+    auto scannedOnly = Filter::fromJson(nlohmann::json{{"not", {{"not", reportFilter}}}}, error);
+    std::uint64_t queried = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        queried += api.query(*planned, 100).total;
+    }
+    report("query (planned)", millisSince(start));
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        queried += api.query(*scannedOnly, 100).total;
+    }
+    report("query (full scan)", millisSince(start));
+
+    // Raw scan speed of the packed folded names, without building results: a
+    // two-character needle that starts with a common letter but never
+    // matches, through the table and through each kernel over the same text
+    // as one buffer
+    EmployeeTable table;
+    for (const auto& employee : api.getAllEmployees()) {
+        table.upsert(employee);
+    }
+    std::string packed;
+    for (size_t row = 0; row < table.size(); row++) {
+        packed += table.foldedNameColumn()[row];
+    }
+    auto reportScan = [&packed](const std::string& name, double totalMillis) {
+        std::cout << std::left << std::setw(24) << name << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(3) << totalMillis / iterations << " ms/query  " << std::setprecision(1)
+                  << packed.size() * iterations / (totalMillis / 1000) / 1e9 << " GB/s\n";
+    };
+    size_t scanned = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        scanned += table.rowsWithNameContaining("ez").size();
+    }
+    reportScan("name scan (no match)", millisSince(start));
+    for (SearchKernel kernel : {SearchKernel::Scalar, SearchKernel::Sse2, SearchKernel::Avx2}) {
+        if (!searchKernelSupported(kernel)) {
+            continue;
+        }
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            scanned += findSubstring(kernel, packed, "ez") != std::string_view::npos;
+        }
+        reportScan(std::string("  ") + searchKernelName(kernel) + " kernel", millisSince(start));
+    }
+
+    std::cout << "(highest " << highest << ", " << top / iterations << " and " << topK / iterations
+              << " top earners, mean rank " << ranks / iterations << ", median " << median / iterations << ", "
+              << inRange / (2 * iterations) << " in range, " << byEmail << " by email, " << completed / iterations << " completions, "
+              << titled / iterations << " engineers, " << queried / (2 * iterations) << " queried, " << named / iterations << " and "
+              << shortNamed / iterations << " name matches, " << fuzzy / iterations << " and "
+              << fuzzyAll / iterations << " fuzzy matches, " << scanned << " scanned)\n";
+    removeStoreFiles(path);
+}
+
+static std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Deterministic UUID-shaped ids like the ones the upstream API issues
+static std::vector<std::string> makeUuidKeys(size_t count, std::uint64_t seed) {
+    static const char* hex = "0123456789abcdef";
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        std::uint64_t parts[2] = {splitmix64(seed), splitmix64(seed)};
+        std::string key(36, '-');
+        for (size_t pos = 0, nibble = 0; pos < key.size(); pos++) {
+            if (pos == 8 || pos == 13 || pos == 18 || pos == 23) {
+                continue;
+            }
+            key[pos] = hex[(parts[nibble / 16] >> (4 * (nibble % 16))) & 0xF];
+            nibble++;
+        }
+        keys.push_back(std::move(key));
+    }
+    return keys;
+}
+
+static void reportIndex(const char* name, double buildMillis, double hitMillis, double missMillis, size_t probes,
+                        size_t count, size_t bytes) {
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << buildMillis * 1e6 / count << " ns/insert" << std::setw(9)
+              << hitMillis * 1e6 / probes << " ns/hit" << std::setw(9) << missMillis * 1e6 / probes
+              << " ns/miss" << std::setw(9) << static_cast<double>(bytes) / count << " B/entry\n";
+}
+
+// FlatHashIndex against std::unordered_map<std::string, row> on UUID keys,
+// probing in random order. Map lookups build a std::string from the view
+// first, as the request path used to. Reported bytes leave out key text: the map additionally owns a
+// copy of every key, the index refers to the caller's strings.
+static void benchmarkIndexSize(size_t count) {
+    std::cout << "== index: " << count << " UUID keys ==\n";
+    std::vector<std::string> keys = makeUuidKeys(count, 1);
+    std::vector<std::string> missing = makeUuidKeys(std::min<size_t>(count, 1000000), 2);
+    std::vector<std::uint32_t> order(std::min<size_t>(count, 1000000));
+    std::uint64_t seed = 3;
+    for (auto& row : order) {
+        row = static_cast<std::uint32_t>(splitmix64(seed) % count);
+    }
+    // Probe text sits in one contiguous buffer, as it would in a request
+    std::string probeText;
+    probeText.reserve(order.size() * 2 * 36);
+    for (size_t i = 0; i < order.size(); i++) {
+        probeText += keys[order[i]];
+        probeText += missing[i];
+    }
+    std::vector<std::string_view> hits, misses;
+    for (size_t i = 0, offset = 0; i < order.size(); i++) {
+        size_t hitLength = keys[order[i]].size();
+        hits.emplace_back(probeText.data() + offset, hitLength);
+        misses.emplace_back(probeText.data() + offset + hitLength, missing[i].size());
+        offset += hitLength + missing[i].size();
+    }
+
+    size_t found = 0;
+    {
+        std::unordered_map<std::string, std::uint32_t> map;
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint32_t row = 0; row < count; row++) {
+            map.emplace(keys[row], row);
+        }
+        double build = millisSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (std::string_view key : hits) {
+            found += map.find(std::string(key)) != map.end();
+        }
+        double hit = millisSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (std::string_view key : misses) {
+            found += map.find(std::string(key)) != map.end();
+        }
+        double miss = millisSince(start);
+
+        // Node: next pointer, key, row and cached hash; plus one bucket pointer each
+        size_t bytes = map.size() * (sizeof(void*) + sizeof(std::pair<const std::string, std::uint32_t>) + sizeof(size_t))
+                       + map.bucket_count() * sizeof(void*);
+        reportIndex("unordered_map", build, hit, miss, hits.size(), count, bytes);
+    }
+    {
+        FlatHashIndex index;
+        auto matches = [&keys](std::string_view key) {
+            return [&keys, key](std::uint32_t row) { return keys[row] == key; };
+        };
+        auto hashOf = [](std::string_view key) { return std::hash<std::string_view>()(key); };
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint32_t row = 0; row < count; row++) {
+            index.insert(hashOf(keys[row]), row, matches(keys[row]));
+        }
+        double build = millisSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (std::string_view key : hits) {
+            found += index.find(hashOf(key), matches(key)).has_value();
+        }
+        double hit = millisSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (std::string_view key : misses) {
+            found += index.find(hashOf(key), matches(key)).has_value();
+        }
+        double miss = millisSince(start);
+        reportIndex("FlatHashIndex", build, hit, miss, hits.size(), count, index.memoryBytes());
+    }
+    {
+        // Same index over compact keys; probes parse the request text first
+        std::vector<EmployeeId> ids;
+        ids.reserve(count);
+        for (const auto& key : keys) {
+            ids.push_back(EmployeeId::parse(key));
+        }
+        FlatHashIndex index;
+        auto matches = [&ids](const EmployeeId& id) {
+            return [&ids, &id](std::uint32_t row) { return ids[row] == id; };
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint32_t row = 0; row < count; row++) {
+            index.insert(ids[row].hash(), row, matches(ids[row]));
+        }
+        double build = millisSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (std::string_view key : hits) {
+            EmployeeId id = EmployeeId::borrow(key);
+            found += index.find(id.hash(), matches(id)).has_value();
+        }
+        double hit = millisSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (std::string_view key : misses) {
+            EmployeeId id = EmployeeId::borrow(key);
+            found += index.find(id.hash(), matches(id)).has_value();
+        }
+        double miss = millisSince(start);
+        reportIndex("+ EmployeeId", build, hit, miss, hits.size(), count, index.memoryBytes());
+        std::cout << "key storage: std::string " << sizeof(std::string) << " B + heap text, EmployeeId "
+                  << sizeof(EmployeeId) << " B\n";
+    }
+    if (found != 3 * hits.size()) {
+        std::cerr << "Lookup mismatch: " << found << " hits" << std::endl;
+    }
+}
+
+static void benchmarkIndex(size_t count) {
+    if (count > 0) {
+        benchmarkIndexSize(count);
+        return;
+    }
+    for (size_t size : {10000UL, 1000000UL, 10000000UL}) {
+        benchmarkIndexSize(size);
+    }
+}
+
+// Parse the same JSONL snapshot into a map with an increasing number of threads
+static void benchmarkJsonLines(size_t count) {
+    std::cout << "== jsonl load scaling: " << count << " employees ==\n";
+    std::string path = (std::filesystem::temp_directory_path() / "benchmark_scaling.jsonl").string();
+    removeStoreFiles(path);
+
+    std::string error;
+    bool written = Snapshot::write(path, count, [count](const EmployeeVisitor& visit) {
+        for (size_t i = 0; i < count; i++) {
+            visit(makeEmployee(i));
+        }
+    }, error);
+    if (!written) {
+        std::cerr << "Could not write " << path << ": " << error << std::endl;
+        return;
+    }
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    double baseline = 0;
+    for (unsigned threads = 1; threads <= cores; threads *= 2) {
+        std::unordered_map<std::string, Employee> employees;
+        employees.reserve(count);
+        auto start = std::chrono::steady_clock::now();
+        Snapshot::readJsonLines(path, [&employees](const Employee& emp) {
+            employees[emp.getId()] = emp;
+        }, error, threads);
+        double millis = millisSince(start);
+        baseline = threads == 1 ? millis : baseline;
+
+        std::cout << std::setw(3) << threads << " threads " << std::setw(10) << std::fixed << std::setprecision(1)
+                  << millis << " ms  x" << std::setprecision(2) << baseline / millis << "  ("
+                  << employees.size() << " loaded)\n";
+    }
+    removeStoreFiles(path);
+}
+
+// Reader throughput against the versioned store while one writer keeps
+// publishing new versions
+static void benchmarkReaders(size_t count) {
+    std::cout << "== concurrent readers: " << count << " employees, one writer ==\n";
+    std::string path = (std::filesystem::temp_directory_path() / "benchmark_readers.bin").string();
+    removeStoreFiles(path);
+
+    std::string error;
+    bool written = Snapshot::write(path, count, [count](const EmployeeVisitor& visit) {
+        for (size_t i = 0; i < count; i++) {
+            visit(makeEmployee(i));
+        }
+    }, error);
+    if (!written) {
+        std::cerr << "Could not write " << path << ": " << error << std::endl;
+        return;
+    }
+
+    PersistenceOptions options;
+    options.durability = DurabilityMode::Async;
+    EmployeeAPI api(path, options);
+    const auto duration = std::chrono::milliseconds(1000);
+
+    // What pinning a view costs one reader, against the shared_ptr atomics it
+    // replaced, which take a global lock pool and bump one shared count
+    const size_t pins = 10000000;
+    EmployeeStore store(kDefaultShardCount);
+    auto pinStart = std::chrono::steady_clock::now();
+    size_t pinned = 0;
+    for (size_t i = 0; i < pins; i++) {
+        pinned += store.view()->shards.size();
+    }
+    double pinNanos = millisSince(pinStart) * 1e6 / pins;
+    std::shared_ptr<const StoreView> shared = store.sharedView();
+    auto loadStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pins; i++) {
+        pinned += std::atomic_load(&shared)->shards.size();
+    }
+    double loadNanos = millisSince(loadStart) * 1e6 / pins;
+    std::cout << "pin view " << std::fixed << std::setprecision(1) << pinNanos << " ns, std::atomic_load(shared_ptr) "
+              << loadNanos << " ns" << (pinned == 0 ? " (no shards)" : "") << "\n";
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= 2 * cores; threads *= 2) {
+        std::atomic<bool> running(true);
+        std::atomic<std::uint64_t> reads(0);
+        std::uint64_t writes = 0;
+
+        std::vector<std::thread> readers;
+        for (unsigned t = 0; t < threads; t++) {
+            readers.emplace_back([&api, &running, &reads, count, t]() {
+                std::uint64_t local = 0;
+                size_t next = t;
+                while (running.load(std::memory_order_relaxed)) {
+                    api.getEmployeeById(std::to_string(next % count + 1));
+                    next += 7919;
+                    local++;
+                }
+                reads += local;
+            });
+        }
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < duration) {
+            Employee emp = makeEmployee(writes % count);
+            emp.setName("Renamed " + std::to_string(writes));
+            api.updateEmployee(emp);
+            writes++;
+        }
+        running.store(false);
+        for (auto& t : readers) {
+            t.join();
+        }
+        double seconds = millisSince(start) / 1000;
+
+        std::cout << std::setw(3) << threads << " readers " << std::setw(12) << std::fixed << std::setprecision(0)
+                  << reads.load() / seconds << " reads/s " << std::setw(8) << writes / seconds << " writes/s\n";
+    }
+    removeStoreFiles(path);
+}
+
+// Write throughput with 1 to 32 writer threads, for one shard (a single
+// global writer lock) against the default shard count
+static void benchmarkWriters(size_t count) {
+    std::cout << "== concurrent writers: " << count << " employees ==\n";
+    std::string path = (std::filesystem::temp_directory_path() / "benchmark_writers.bin").string();
+    const auto duration = std::chrono::milliseconds(1000);
+
+    for (size_t shards : {size_t(1), kDefaultShardCount}) {
+        for (unsigned threads = 1; threads <= 32; threads *= 2) {
+            removeStoreFiles(path);
+            std::string error;
+            bool written = Snapshot::write(path, count, [count](const EmployeeVisitor& visit) {
+                for (size_t i = 0; i < count; i++) {
+                    visit(makeEmployee(i));
+                }
+            }, error);
+            if (!written) {
+                std::cerr << "Could not write " << path << ": " << error << std::endl;
+                return;
+            }
+
+            PersistenceOptions options;
+            options.durability = DurabilityMode::Async;
+            options.compactionThresholdBytes = UINTMAX_MAX;
+            EmployeeAPI api(path, options, shards);
+
+            std::atomic<bool> running(true);
+            std::atomic<std::uint64_t> writes(0);
+            std::vector<std::thread> writers;
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned t = 0; t < threads; t++) {
+                writers.emplace_back([&api, &running, &writes, count, t, threads]() {
+                    std::uint64_t local = 0;
+                    for (size_t i = t; running.load(std::memory_order_relaxed); i += threads) {
+                        Employee emp = makeEmployee(i % count);
+                        emp.setName("Renamed " + std::to_string(i));
+                        api.updateEmployee(emp);
+                        local++;
+                    }
+                    writes += local;
+                });
+            }
+            std::this_thread::sleep_for(duration);
+            running.store(false);
+            for (auto& t : writers) {
+                t.join();
+            }
+            double seconds = millisSince(start) / 1000;
+
+            MutationStats stats = api.getMutationStats();
+            std::cout << std::setw(3) << shards << " shards " << std::setw(3) << threads << " writers "
+                      << std::setw(10) << std::fixed << std::setprecision(0) << writes.load() / seconds
+                      << " writes/s  avg batch " << std::setprecision(1)
+                      << (stats.batches ? static_cast<double>(stats.mutations) / stats.batches : 0.0) << "\n";
+        }
+    }
+    removeStoreFiles(path);
+}
+
+// One writer renames employees one at a time in tables of growing size. Each
+// write publishes a new table version, so the time per write shows whether
+// that copy grows with the table.
+static void benchmarkWriteCost(size_t largest) {
+    std::cout << "== write cost: up to " << largest << " employees ==\n";
+    std::string path = (std::filesystem::temp_directory_path() / "benchmark_writecost.bin").string();
+    const int writes = 300;
+
+    for (size_t count = 10000; count <= largest; count *= 10) {
+        removeStoreFiles(path);
+        std::string error;
+        bool written = Snapshot::write(path, count, [count](const EmployeeVisitor& visit) {
+            for (size_t i = 0; i < count; i++) {
+                visit(makeEmployee(i));
+            }
+        }, error);
+        if (!written) {
+            std::cerr << "Could not write " << path << ": " << error << std::endl;
+            return;
+        }
+
+        PersistenceOptions options;
+        options.durability = DurabilityMode::Async;
+        options.compactionThresholdBytes = UINTMAX_MAX;
+        EmployeeAPI api(path, options);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < writes; i++) {
+            Employee emp = makeEmployee((i * 7919) % count);
+            emp.setName("Renamed " + std::to_string(i));
+            api.updateEmployee(emp);
+        }
+        double millis = millisSince(start);
+        std::cout << std::setw(9) << count << " employees " << std::setw(10) << std::fixed
+                  << std::setprecision(1) << millis * 1000 / writes << " us/write\n";
+    }
+    removeStoreFiles(path);
+}
+
+// Percentile of a sorted sample, in microseconds
+static double percentileMicros(const std::vector<std::int64_t>& sortedNanos, double fraction) {
+    size_t index = std::min(sortedNanos.size() - 1, static_cast<size_t>(fraction * sortedNanos.size()));
+    return sortedNanos[index] / 1000.0;
+}
+
+// One submitter queues tiny tasks, as the server's accept loop queues
+// connections, into httplib's pool and into the work-stealing pool
+static void benchmarkTaskQueues(size_t tasks) {
+    std::cout << "== task queues: " << tasks << " tasks ==\n";
+    using Clock = std::chrono::steady_clock;
+
+    for (size_t workers : {size_t(2), size_t(8), size_t(32)}) {
+        for (bool stealing : {false, true}) {
+            std::unique_ptr<httplib::TaskQueue> threadPool;
+            std::unique_ptr<WorkStealingPool> stealingPool;
+            if (stealing) {
+                stealingPool = std::make_unique<WorkStealingPool>(workers, tasks);
+            } else {
+                threadPool = std::make_unique<httplib::ThreadPool>(workers);
+            }
+
+            std::vector<std::int64_t> enqueueNanos(tasks);
+            std::vector<std::int64_t> waitNanos(tasks);
+            auto start = Clock::now();
+            for (size_t i = 0; i < tasks; i++) {
+                auto queuedAt = Clock::now();
+                auto task = [&waitNanos, i, queuedAt]() {
+                    waitNanos[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - queuedAt).count();
+                };
+                if (stealing) {
+                    stealingPool->enqueue(task);
+                } else {
+                    threadPool->enqueue(task);
+                }
+                enqueueNanos[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - queuedAt).count();
+            }
+            if (stealing) {
+                stealingPool->shutdown();
+            } else {
+                threadPool->shutdown();
+            }
+            double seconds = millisSince(start) / 1000;
+
+            std::sort(enqueueNanos.begin(), enqueueNanos.end());
+            std::sort(waitNanos.begin(), waitNanos.end());
+            std::cout << std::setw(14) << (stealing ? "work-stealing" : "httplib pool") << std::setw(3) << workers
+                      << " workers " << std::setw(10) << std::fixed << std::setprecision(0) << tasks / seconds
+                      << " tasks/s  enqueue p99 " << std::setprecision(1) << percentileMicros(enqueueNanos, 0.99)
+                      << " us  wait p50 " << percentileMicros(waitNanos, 0.5)
+                      << " us  p99 " << percentileMicros(waitNanos, 0.99) << " us";
+            if (stealing) {
+                std::cout << "  steals " << stealingPool->stats().steals;
+            }
+            std::cout << "\n";
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Logger::get()->set_level(spdlog::level::warn);
+
+    std::string suite = argc > 1 ? argv[1] : "startup";
+    if (suite == "startup") {
+        benchmarkStartup(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    } else if (suite == "queries") {
+        benchmarkQueries(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    } else if (suite == "index") {
+        benchmarkIndex(argc > 2 ? std::stoul(argv[2]) : 0);
+    } else if (suite == "jsonl") {
+        benchmarkJsonLines(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    } else if (suite == "readers") {
+        benchmarkReaders(argc > 2 ? std::stoul(argv[2]) : 100000);
+    } else if (suite == "writers") {
+        benchmarkWriters(argc > 2 ? std::stoul(argv[2]) : 100000);
+    } else if (suite == "writecost") {
+        benchmarkWriteCost(argc > 2 ? std::stoul(argv[2]) : 1000000);
+    } else if (suite == "tasks") {
+        benchmarkTaskQueues(argc > 2 ? std::stoul(argv[2]) : 200000);
+    } else {
+        std::cerr << "Usage: " << argv[0] << " startup|queries|index|jsonl|readers|writers|writecost|tasks [count]\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <limits>
+#include <optional>
 #include "employee_api.h"
 
 // Function to display a single employee's information
@@ -86,8 +88,8 @@ int main() {
                 std::cout << "Enter employee ID: ";
                 std::cin >> id;
                 
-                Employee* emp = api.getEmployeeById(id);
-                if (emp != nullptr) {
+                std::optional<Employee> emp = api.getEmployeeById(id);
+                if (emp) {
                     std::cout << "\nEmployee found:\n";
                     displayEmployee(*emp);
                 } else {
@@ -165,8 +167,8 @@ int main() {
                 std::cout << "Enter employee ID to update: ";
                 std::cin >> id;
                 
-                Employee* emp = api.getEmployeeById(id);
-                if (emp == nullptr) {
+                std::optional<Employee> emp = api.getEmployeeById(id);
+                if (!emp) {
                     std::cout << "Employee with ID " << id << " not found.\n";
                     break;
                 }
@@ -214,8 +216,8 @@ int main() {
                 std::cout << "Enter employee ID to delete: ";
                 std::cin >> id;
                 
-                Employee* emp = api.getEmployeeById(id);
-                if (emp == nullptr) {
+                std::optional<Employee> emp = api.getEmployeeById(id);
+                if (!emp) {
                     std::cout << "Employee with ID " << id << " not found.\n";
                     break;
                 }
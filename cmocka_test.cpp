@@ -1,11 +1,29 @@
 #include <string>
 #include <vector>
 #include <algorithm>  // for std::transform
+#include <array>
+#include <atomic>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 #include "common/employee.h"
 #include "common/employee_api.h"
+#include "common/employee_id.h"
+#include "common/employee_table.h"
+#include "common/flat_hash_index.h"
+#include "common/folded_text_column.h"
+#include "common/text_column.h"
+#include "common/journal_writer.h"
+#include "common/snapshot.h"
 #include "common/logger.h"
+#include "common/request_lanes.h"
+#include "common/substring_search.h"
 #include "common/timer.h"
+#include "common/work_stealing_pool.h"
+#include "server/api_formatter.h"
 
 // CMocka includes - with extern "C" for C++ compatibility
 extern "C" {
@@ -74,13 +92,13 @@ static void test_get_all_employees(void **state) {
 static void test_get_employee_by_id(void **state) {
     (void) state;
     // Test with a valid ID (assuming ID 1 exists)
-    Employee* emp = api->getEmployeeById("1");
-    assert_non_null(emp);
+    std::optional<Employee> emp = api->getEmployeeById("1");
+    assert_true(emp.has_value());
     assert_string_equal(emp->getId().c_str(), "1");
     
     // Test with an invalid ID
     emp = api->getEmployeeById("999999");
-    assert_null(emp);
+    assert_false(emp.has_value());
 }
 
 // Test function: getEmployeesByName
@@ -125,8 +143,8 @@ static void test_add_and_delete_employee(void **state) {
     assert_true(addResult);
     
     // Verify the employee was added
-    Employee* addedEmp = api->getEmployeeById("test_id_12345");
-    assert_non_null(addedEmp);
+    std::optional<Employee> addedEmp = api->getEmployeeById("test_id_12345");
+    assert_true(addedEmp.has_value());
     assert_string_equal(addedEmp->getName().c_str(), "Test Employee");
     
     // Delete the employee
@@ -135,7 +153,7 @@ static void test_add_and_delete_employee(void **state) {
     
     // Verify the employee was deleted
     addedEmp = api->getEmployeeById("test_id_12345");
-    assert_null(addedEmp);
+    assert_false(addedEmp.has_value());
 }
 
 // Test function: updateEmployee
@@ -153,8 +171,8 @@ static void test_update_employee(void **state) {
     api->addEmployee(testEmp);
     
     // Get the employee and modify it
-    Employee* emp = api->getEmployeeById("update_test_123");
-    assert_non_null(emp);
+    std::optional<Employee> emp = api->getEmployeeById("update_test_123");
+    assert_true(emp.has_value());
     
     emp->setSalary("85000");
     emp->setTitle("Senior Test Position");
@@ -164,8 +182,8 @@ static void test_update_employee(void **state) {
     assert_true(updateResult);
     
     // Verify the update worked
-    Employee* updatedEmp = api->getEmployeeById("update_test_123");
-    assert_non_null(updatedEmp);
+    std::optional<Employee> updatedEmp = api->getEmployeeById("update_test_123");
+    assert_true(updatedEmp.has_value());
     assert_string_equal(updatedEmp->getSalary().c_str(), "85000");
     assert_string_equal(updatedEmp->getTitle().c_str(), "Senior Test Position");
     
@@ -273,6 +291,1503 @@ static void test_employees_by_title(void **state) {
     assert_int_equal(employees.size(), 0);
 }
 
+// Create a scratch data file holding a single employee
+static std::string makeScratchDataFile(const std::string& name) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path.string() + ".journal");
+    std::filesystem::remove(path.string() + ".journal.old");
+    std::ofstream file(path);
+    file << R"({"data": [{"id": "1", "employee_name": "Tiger Nixon", "employee_salary": "320800",)"
+         << R"( "employee_age": "61", "employee_title": "Architect", "employee_email": "tnixon@company.com"}]})";
+    return path.string();
+}
+
+// Test function: the columnar table parses numbers once and keeps rows dense
+static void test_employee_table(void **state) {
+    (void) state;
+    EmployeeTable table;
+    table.upsert(Employee("a", "Alpha", "500", "30", "SDE", "a@company.com"));
+    table.upsert(Employee("b", "Beta", "twdikwc", "054", "SDE", "b@company.com"));
+    table.upsert(Employee("c", "Gamma", "900", "41", "Lead", "c@company.com"));
+
+    assert_int_equal(table.size(), 3);
+    assert_int_equal(table.salaryColumn()[1], kNotNumeric);
+    assert_int_equal(table.ageColumn()[1], 54);
+
+    // Non-canonical text survives the round trip through the columns
+    Employee beta = table.row(*table.findRow("b"));
+    assert_string_equal(beta.getSalary().c_str(), "twdikwc");
+    assert_string_equal(beta.getAge().c_str(), "054");
+
+    // Replacing keeps the row; erasing moves the last row into the hole
+    table.upsert(Employee("a", "Alpha", "700", "30", "SDE", "a@company.com"));
+    assert_int_equal(*table.findRow("a"), 0);
+    assert_int_equal(table.salaryColumn()[0], 700);
+    assert_true(table.erase("a"));
+    assert_false(table.erase("a"));
+    assert_int_equal(table.size(), 2);
+    assert_int_equal(*table.findRow("c"), 0);
+    assert_string_equal(table.row(0).getName().c_str(), "Gamma");
+    assert_false(table.contains("a"));
+
+    // Copies share string chunks but writes to one never show in the other
+    for (int i = 0; i < 3000; i++) {
+        std::string id = "bulk" + std::to_string(i);
+        table.upsert(Employee(id, "Bulk " + id, "1", "2", "SDE", id + "@company.com"));
+    }
+    EmployeeTable copy = table;
+    copy.upsert(Employee("c", "Renamed", "900", "41", "Lead", "c@company.com"));
+    assert_true(copy.erase("bulk5"));
+    assert_true(copy.erase("bulk2500"));
+    assert_string_equal(table.row(*table.findRow("c")).getName().c_str(), "Gamma");
+    assert_string_equal(copy.row(*copy.findRow("c")).getName().c_str(), "Renamed");
+    assert_int_equal(table.size(), copy.size() + 2);
+    assert_string_equal(table.row(*table.findRow("bulk2999")).getEmail().c_str(), "bulk2999@company.com");
+    assert_string_equal(copy.row(*copy.findRow("bulk2999")).getEmail().c_str(), "bulk2999@company.com");
+}
+
+// Test function: titles are interned once and searched through their postings
+// Rows whose name contains needle, found by comparing every row
+static std::vector<size_t> scanNames(const EmployeeTable& table, const std::string& needle) {
+    std::string lowered = needle;
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+    std::vector<size_t> rows;
+    for (size_t row = 0; row < table.size(); row++) {
+        std::string name = table.row(row).getName();
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (name.find(lowered) != std::string::npos) {
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
+
+static void test_trigram_name_search(void **state) {
+    (void) state;
+    // Enough rows that the posting lists of common trigrams span several blocks
+    EmployeeTable table;
+    const char* names[] = {"Kunal", "Dakshit", "Anna Banana", "ANNABELLE", "Hannah", "abcXbcd", "Li", "Ann"};
+    for (size_t i = 0; i < 3000; i++) {
+        std::string id = std::to_string(i);
+        table.upsert(Employee(id, std::string(names[i % 8]) + " " + id, "1", "2", "SDE", id + "@x.com"));
+    }
+
+    const std::vector<std::string> needles = {"ann", "ANNA", "nan", "bcd", "abcd", "Li ", "xyz", "an", "", "1 ", "na 3"};
+    for (const auto& needle : needles) {
+        assert_true(table.rowsWithNameContaining(needle) == scanNames(table, needle));
+    }
+    // Every trigram of "abcd" occurs in "abcXbcd", but not next to each other
+    assert_true(table.rowsWithNameContaining("abcd").empty());
+
+    // Renames and erases (which move rows) keep the index in step, and a copy
+    // keeps answering for its own version
+    EmployeeTable before = table;
+    for (size_t i = 0; i < 3000; i += 3) {
+        table.upsert(Employee(std::to_string(i), "Renamed " + std::to_string(i), "1", "2", "SDE", "r@x.com"));
+    }
+    for (size_t i = 1; i < 3000; i += 7) {
+        assert_true(table.erase(std::to_string(i)));
+    }
+    for (const auto& needle : needles) {
+        assert_true(table.rowsWithNameContaining(needle) == scanNames(table, needle));
+        assert_true(before.rowsWithNameContaining(needle) == scanNames(before, needle));
+    }
+    assert_int_equal(table.rowsWithNameContaining("renamed").size(), scanNames(table, "renamed").size());
+    assert_true(before.rowsWithNameContaining("renamed").empty());
+}
+
+static void test_substring_search(void **state) {
+    (void) state;
+    // Every kernel the CPU has finds what std::string_view::find finds, from
+    // every start, including matches in the tail after the last full block
+    std::string text;
+    std::uint64_t seed = 7;
+    for (int i = 0; i < 700; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        text.push_back("abcab"[(seed >> 33) % 5]);
+    }
+    const std::vector<std::string> needles = {"a", "ab", "abc", "cabca", "bbbb", "abcabcabcabcabcabca", "z", ""};
+    for (SearchKernel kernel : {SearchKernel::Scalar, SearchKernel::Sse2, SearchKernel::Avx2}) {
+        if (!searchKernelSupported(kernel)) {
+            continue;
+        }
+        for (const auto& needle : needles) {
+            for (size_t from = 0; from <= text.size() + 1; from += 13) {
+                assert_int_equal(findSubstring(kernel, text, needle, from), std::string_view(text).find(needle, from));
+            }
+        }
+        assert_int_equal(findSubstring(kernel, text.substr(0, 40) + "zq", "zq"), 40);
+    }
+
+    // Packed rows: matches must lie inside one row, and copies keep their version
+    FoldedTextColumn column;
+    const char* values[] = {"Ab", "CD", "", "xABCDx", "abab"};
+    for (int i = 0; i < 2100; i++) {
+        column.push_back(values[i % 5]);
+    }
+    assert_true(column[3] == "xabcdx");
+    auto rowsWith = [](const FoldedTextColumn& text, std::string_view needle) {
+        std::vector<size_t> rows;
+        text.forEachContaining(needle, [&rows](size_t row) { rows.push_back(row); });
+        return rows;
+    };
+    auto bc = rowsWith(column, "bc");  // "Ab" then "CD" does not count
+    assert_int_equal(bc.size(), 420);
+    assert_true(std::all_of(bc.begin(), bc.end(), [](size_t row) { return row % 5 == 3; }));
+    assert_int_equal(rowsWith(column, "ab").size(), 3 * 420);
+    assert_int_equal(rowsWith(column, "").size(), 2100);
+
+    FoldedTextColumn before = column;
+    column.set(1, "BC");
+    column.set(2047, "a much longer value, BC");
+    column.pop_back();
+    assert_int_equal(column.size(), 2099);
+    assert_true(column[2] == "");
+    assert_int_equal(rowsWith(column, "bc").size(), 422);
+    assert_int_equal(rowsWith(before, "bc").size(), 420);
+
+    // Unfolded rows, set from another row of the same chunk as an erase does
+    TextColumn packed;
+    for (int i = 0; i < 1500; i++) {
+        packed.push_back(values[i % 5]);
+    }
+    TextColumn shared = packed;
+    packed.set(0, packed[1003]);
+    packed.set(1499, "");
+    assert_true(packed[0] == "xABCDx");
+    assert_true(packed[1] == "CD");
+    assert_true(packed[1499] == "");
+    assert_true(shared[0] == "Ab");
+    assert_true(shared[1499] == "abab");
+    assert_int_equal(packed.textBytes(), shared.textBytes());  // four bytes longer, four shorter
+}
+
+static void test_title_dictionary(void **state) {
+    (void) state;
+    EmployeeTable table;
+    for (int i = 0; i < 6; i++) {
+        std::string id = std::to_string(i);
+        table.upsert(Employee(id, "Name " + id, "100", "30", i % 2 ? "Software Engineer" : "Accountant", id + "@x.com"));
+    }
+    assert_int_equal(table.titles().distinctCount(), 2);
+    assert_int_equal(table.titleCodeColumn()[0], table.titleCodeColumn()[2]);
+    assert_int_equal(table.titles().rowsContaining("ENGINEER").size(), 3);
+
+    // Retitling and erasing keep the postings in step with the rows
+    table.upsert(Employee("1", "Name 1", "100", "30", "Documentation Engineer", "1@x.com"));
+    assert_int_equal(table.titles().distinctCount(), 3);
+    assert_true(table.erase("0"));
+    assert_true(table.erase("2"));
+    assert_true(table.erase("4"));
+    assert_int_equal(table.titles().distinctCount(), 2);
+    assert_int_equal(table.titles().rowsContaining("accountant").size(), 0);
+
+    auto rows = table.titles().rowsContaining("engineer");
+    assert_int_equal(rows.size(), 3);
+    for (std::uint32_t row : rows) {
+        assert_true(table.row(row).getTitle().find("Engineer") != std::string::npos);
+    }
+}
+
+// Test function: the flat index survives growth, tombstones and full collisions
+static void test_flat_hash_index(void **state) {
+    (void) state;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 5000; i++) {
+        keys.push_back("key-" + std::to_string(i));
+    }
+    auto matches = [&keys](std::string_view key) {
+        return [&keys, key](std::uint32_t row) { return keys[row] == key; };
+    };
+    auto hashOf = [](std::string_view key) { return std::hash<std::string_view>()(key); };
+
+    FlatHashIndex index;
+    for (std::uint32_t row = 0; row < keys.size(); row++) {
+        assert_true(index.insert(hashOf(keys[row]), row, matches(keys[row])));
+    }
+    assert_false(index.insert(hashOf(keys[7]), 7, matches(keys[7])));
+    assert_int_equal(index.size(), keys.size());
+
+    // Erase every other key, then churn the freed slots
+    for (std::uint32_t row = 0; row < keys.size(); row += 2) {
+        assert_true(index.erase(hashOf(keys[row]), matches(keys[row])));
+    }
+    for (int round = 0; round < 3; round++) {
+        for (std::uint32_t row = 0; row < keys.size(); row += 2) {
+            assert_true(index.insert(hashOf(keys[row]), row, matches(keys[row])));
+            assert_true(index.erase(hashOf(keys[row]), matches(keys[row])));
+        }
+    }
+    for (std::uint32_t row = 0; row < keys.size(); row++) {
+        auto found = index.find(hashOf(keys[row]), matches(keys[row]));
+        assert_int_equal(found.has_value(), row % 2 == 1);
+    }
+    assert_false(index.find(hashOf("missing"), matches("missing")).has_value());
+
+    // Every key on one hash: probing has to walk several groups
+    FlatHashIndex colliding;
+    for (std::uint32_t row = 0; row < 100; row++) {
+        assert_true(colliding.insert(42, row, matches(keys[row])));
+    }
+    assert_true(colliding.erase(42, matches(keys[3])));
+    assert_true(colliding.relocate(42, 3, matches(keys[99])));
+    assert_int_equal(*colliding.find(42, [&keys](std::uint32_t row) { return row == 3; }), 3);
+    assert_int_equal(*colliding.find(42, matches(keys[98])), 98);
+    assert_false(colliding.find(42, matches(keys[200])).has_value());
+}
+
+// Test function: ids parse into compact keys and format back to the same text
+static void test_employee_id(void **state) {
+    (void) state;
+    assert_int_equal(sizeof(EmployeeId), 24);
+
+    const char* uuid = "4a3a170b-22cd-4ac2-aad1-9bb5b34a1507";
+    assert_true(EmployeeId::parse(uuid).kind() == EmployeeId::Kind::Uuid);
+    assert_true(EmployeeId::parse("42").kind() == EmployeeId::Kind::Number);
+    assert_int_equal(EmployeeId::parse("42").number(), 42);
+
+    // Non-canonical spellings stay text so the original is kept verbatim
+    for (const char* text : {"042", "-1", "4A3A170B-22CD-4AC2-AAD1-9BB5B34A1507", "test_id_12345", "",
+                             "a-rather-long-employee-identifier", "99999999999999999999"}) {
+        EmployeeId id = EmployeeId::parse(text);
+        assert_true(id.kind() == EmployeeId::Kind::Text);
+        assert_string_equal(id.toString().c_str(), text);
+    }
+    assert_string_equal(EmployeeId::parse(uuid).toString().c_str(), uuid);
+    assert_string_equal(EmployeeId::fromNumber(7).toString().c_str(), "7");
+
+    // Borrowed probes compare and hash like owned ids; copies own their text
+    std::string longText = "a-rather-long-employee-identifier";
+    EmployeeId owned = EmployeeId::parse(longText);
+    EmployeeId probe = EmployeeId::borrow(longText);
+    assert_true(owned == probe);
+    assert_true(owned.hash() == probe.hash());
+    EmployeeId copy = probe;
+    longText[0] = 'b';
+    assert_true(copy == owned);
+    assert_false(probe == owned);
+    EmployeeId moved = std::move(copy);
+    assert_true(moved == owned);
+    assert_false(EmployeeId::parse("42") == EmployeeId::parse("042"));
+
+    // The table hands out numeric ids above every numeric id it has seen
+    EmployeeTable table;
+    assert_int_equal(table.nextNumericId(), 1);
+    table.upsert(Employee(uuid, "Uuid", "1", "2", "SDE", "u@x.com"));
+    table.upsert(Employee("12", "Twelve", "1", "2", "SDE", "t@x.com"));
+    table.upsert(Employee("3", "Three", "1", "2", "SDE", "3@x.com"));
+    assert_int_equal(table.nextNumericId(), 13);
+    assert_true(table.erase("12"));
+    assert_int_equal(table.nextNumericId(), 13);
+    assert_true(table.contains(uuid));
+    assert_string_equal(table.row(*table.findRow(uuid)).getId().c_str(), uuid);
+}
+
+// Test function: handles follow records as rows move and go stale once erased
+static void test_employee_handles(void **state) {
+    (void) state;
+    EmployeeTable table;
+    for (int i = 0; i < 4; i++) {
+        std::string id = std::to_string(i);
+        table.upsert(Employee(id, "Name " + id, "100", "30", "SDE", id + "@x.com"));
+    }
+    EmployeeHandle first = table.handleAt(*table.findRow("0"));
+    EmployeeHandle last = table.handleAt(*table.findRow("3"));
+
+    // Erasing row 0 moves the last row into it; its handle follows
+    assert_true(table.erase("0"));
+    assert_false(table.rowOf(first).has_value());
+    assert_int_equal(*table.rowOf(last), 0);
+    assert_string_equal(table.row(*table.rowOf(last)).getId().c_str(), "3");
+
+    // A new record reusing the slot gets a different generation
+    table.upsert(Employee("9", "Nine", "100", "30", "SDE", "9@x.com"));
+    EmployeeHandle reused = table.handleAt(*table.findRow("9"));
+    assert_int_equal(reused.slot, first.slot);
+    assert_true(reused != first);
+    assert_false(table.rowOf(first).has_value());
+    table.clear();
+    assert_false(table.rowOf(last).has_value());
+
+    // The API refuses to write through a handle whose record was deleted
+    std::string path = makeScratchDataFile("cmocka_handles.json");
+    {
+        EmployeeAPI store(path);
+        auto handle = store.findEmployee("1");
+        assert_true(handle.has_value());
+        Employee tiger = *store.getEmployee(*handle);
+        assert_false(store.updateEmployee(*handle, Employee("2", "Other", "1", "2", "SDE", "o@x.com")));
+        assert_true(store.deleteEmployee("1"));
+        assert_false(store.getEmployee(*handle).has_value());
+        assert_false(store.updateEmployee(*handle, tiger));
+        assert_false(store.deleteEmployee(*handle));
+        assert_false(store.getEmployeeById("1").has_value());
+    }
+    std::filesystem::remove(path + ".journal");
+}
+
+// Test function: mutations are journaled and replayed on top of the snapshot
+static void test_journal_replay(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_journal_replay.json");
+    auto snapshotSize = std::filesystem::file_size(path);
+
+    {
+        EmployeeAPI store(path);
+        assert_true(store.addEmployee(Employee("2", "Journal Add", "1000", "30", "Tester", "add@example.com")));
+        assert_true(store.updateEmployee(Employee("1", "Tiger Nixon", "400000", "61", "Architect", "tnixon@company.com")));
+        assert_true(store.deleteEmployee("2"));
+    }
+
+    // Writes append to the journal instead of rewriting the snapshot
+    assert_int_equal(std::filesystem::file_size(path), snapshotSize);
+    assert_true(std::filesystem::file_size(path + ".journal") > 0);
+
+    EmployeeAPI reloaded(path);
+    assert_int_equal(reloaded.getAllEmployees().size(), 1);
+    std::optional<Employee> emp = reloaded.getEmployeeById("1");
+    assert_true(emp.has_value());
+    assert_string_equal(emp->getSalary().c_str(), "400000");
+}
+
+// Test function: crossing the size threshold folds the journal into the snapshot
+static void test_journal_compaction(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_journal_compaction.json");
+    auto snapshotSize = std::filesystem::file_size(path);
+
+    PersistenceOptions options;
+    options.compactionThresholdBytes = 512;
+    {
+        EmployeeAPI store(path, options);
+        for (int i = 2; i <= 20; i++) {
+            std::string id = std::to_string(i);
+            assert_true(store.addEmployee(Employee(id, "Employee " + id, "50000", "30", "Tester", id + "@example.com")));
+        }
+    }
+
+    assert_true(std::filesystem::file_size(path) > snapshotSize);
+    assert_false(std::filesystem::exists(path + ".journal.old"));
+
+    // The snapshot alone now holds everything that was compacted
+    std::filesystem::remove(path + ".journal");
+    EmployeeAPI reloaded(path);
+    assert_true(reloaded.getAllEmployees().size() > 1);
+}
+
+// Test function: a background save forks a child and reports its outcome
+static void test_forked_snapshot(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_forked_snapshot.json");
+
+    {
+        EmployeeAPI store(path);
+        assert_true(store.addEmployee(Employee("2", "Forked Save", "1000", "30", "Tester", "fork@example.com")));
+        assert_true(store.compactJournal());
+
+        SnapshotStats stats = store.getSnapshotStats();
+        while (stats.running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            stats = store.getSnapshotStats();
+        }
+        assert_int_equal(stats.completed, 1);
+        assert_int_equal(stats.failed, 0);
+        assert_true(stats.lastSuccessUnix > 0);
+    }
+
+    assert_false(std::filesystem::exists(path + ".journal.old"));
+    std::filesystem::remove(path + ".journal");
+    EmployeeAPI reloaded(path);
+    assert_int_equal(reloaded.getAllEmployees().size(), 2);
+}
+
+// Test function: binary snapshots round-trip every field and reject corruption
+static void test_binary_snapshot(void **state) {
+    (void) state;
+    std::string path = (std::filesystem::temp_directory_path() / "cmocka_snapshot.bin").string();
+    std::vector<Employee> written = {
+        Employee("1", "Tiger Nixon", "320800", "61", "Architect", "tnixon@company.com"),
+        Employee("4a3a170b-22cd-4ac2-aad1-9bb5b34a1507", "Kunal", "twdikwc", "054", "SDE", "sde@gmail.com")};
+
+    std::string error;
+    assert_true(Snapshot::write(path, written.size(), [&written](const EmployeeVisitor& visit) {
+        for (const auto& emp : written) {
+            visit(emp);
+        }
+    }, error));
+
+    std::vector<Employee> read;
+    assert_true(Snapshot::read(path, [&read](const Employee& emp) { read.push_back(emp); }, error));
+    assert_int_equal(read.size(), 2);
+    assert_string_equal(read[0].getSalary().c_str(), "320800");
+    assert_string_equal(read[1].getId().c_str(), "4a3a170b-22cd-4ac2-aad1-9bb5b34a1507");
+    assert_string_equal(read[1].getSalary().c_str(), "twdikwc");
+    assert_string_equal(read[1].getAge().c_str(), "054");
+    assert_string_equal(read[1].getEmail().c_str(), "sde@gmail.com");
+
+    // Flip a byte in the string heap; the checksum must catch it
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-3, std::ios::end);
+        file.put('#');
+    }
+    assert_false(Snapshot::read(path, [](const Employee&) {}, error));
+}
+
+// Test function: the streaming JSON loader skips bad records and keeps going
+static void test_streaming_json_load(void **state) {
+    (void) state;
+    std::string path = (std::filesystem::temp_directory_path() / "cmocka_streaming.json").string();
+    {
+        std::ofstream file(path);
+        file << R"({"status": "ok", "data": [)"
+             << R"({"id": "1", "employee_name": "Numeric", "employee_salary": 320800, "employee_age": 61,)"
+             << R"( "employee_title": "Architect", "employee_email": "n@company.com", "extra": {"nested": [1]}},)"
+             << R"({"id": "2", "employee_name": "No Email", "employee_salary": "1", "employee_age": "2",)"
+             << R"( "employee_title": "SDE"},)"
+             << R"({"id": 3, "employee_name": "Numeric Id", "employee_salary": "1", "employee_age": "2",)"
+             << R"( "employee_title": "SDE", "employee_email": "id@company.com"},)"
+             << R"({"id": "4", "employee_name": "Last", "employee_salary": "10", "employee_age": "20",)"
+             << R"( "employee_title": "SDE", "employee_email": "last@company.com"}]})";
+    }
+
+    std::string error;
+    std::vector<Employee> read;
+    assert_true(Snapshot::readJson(path, [&read](const Employee& emp) { read.push_back(emp); }, error));
+    assert_int_equal(read.size(), 2);
+    assert_string_equal(read[0].getSalary().c_str(), "320800");
+    assert_string_equal(read[0].getAge().c_str(), "61");
+    assert_string_equal(read[1].getId().c_str(), "4");
+
+    // A truncated document is an error, not a partial load
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    assert_false(Snapshot::readJson(path, [](const Employee&) {}, error));
+    assert_false(error.empty());
+}
+
+// Test function: JSONL snapshots split into ranges still load every line in order
+static void test_parallel_jsonl_load(void **state) {
+    (void) state;
+    std::string path = (std::filesystem::temp_directory_path() / "cmocka_parallel.jsonl").string();
+    const size_t count = 8000;
+    std::string error;
+    assert_true(Snapshot::write(path, count, [](const EmployeeVisitor& visit) {
+        for (size_t i = 0; i < count; i++) {
+            std::string id = std::to_string(i);
+            visit(Employee(id, "Employee " + id + std::string(150, 'x'), "1000", "30", "SDE", id + "@company.com"));
+        }
+    }, error));
+    {
+        std::ofstream file(path, std::ios::app);
+        file << "not json\n";
+        file << R"({"id":"2","employee_name":"b"})" << "\n";
+        file << R"({"id": "0", "employee_name": "Replaced", "employee_salary": 5, "employee_age": 6,)"
+             << R"( "employee_title": "SDE", "employee_email": "0@company.com"})" << "\n";
+    }
+    assert_true(std::filesystem::file_size(path) > 4 * 256 * 1024);
+
+    for (unsigned threads : {1u, 4u}) {
+        std::vector<Employee> read;
+        assert_true(Snapshot::readJsonLines(path, [&read](const Employee& emp) { read.push_back(emp); }, error, threads));
+        assert_int_equal(read.size(), count + 1);
+        for (size_t i = 0; i < count; i++) {
+            assert_string_equal(read[i].getId().c_str(), std::to_string(i).c_str());
+        }
+        assert_string_equal(read[count].getName().c_str(), "Replaced");
+    }
+
+    // A record missing a field is reported the way the SAX loader reports it
+    std::string message;
+    try {
+        Snapshot::employeeFromJson(nlohmann::json::parse(R"({"id":"2","employee_name":"b"})"));
+    } catch (const std::exception& e) {
+        message = e.what();
+    }
+    assert_string_equal(message.c_str(), "missing field 'employee_salary'");
+}
+
+// Test function: concurrent writers share one journal commit per batch window
+static void test_group_commit_batches(void **state) {
+    (void) state;
+    std::string path = (std::filesystem::temp_directory_path() / "cmocka_group_commit.journal").string();
+    std::filesystem::remove(path);
+
+    Journal journal(path);
+    assert_true(journal.open());
+    {
+        JournalWriter writer(journal, DurabilityMode::Group, std::chrono::milliseconds(50),
+                             std::chrono::milliseconds(10), 1024);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; i++) {
+            threads.emplace_back([&writer, i]() {
+                assert_true(writer.append("{\"op\":\"delete\",\"id\":\"" + std::to_string(i) + "\"}"));
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        PersistenceStats stats = writer.stats();
+        assert_int_equal(stats.records, 8);
+        assert_true(stats.batches < 8);
+        assert_true(stats.maxBatchSize > 1);
+    }
+
+    long lines = Journal::replay(path, [](const std::string&) {});
+    assert_int_equal(lines, 8);
+}
+
+// Test function: readers see whole versions while writers publish new ones
+static void test_concurrent_readers_and_writers(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_concurrent.json");
+    PersistenceOptions options;
+    options.durability = DurabilityMode::Async;
+    EmployeeAPI store(path, options);
+
+    // One writer adds w0, w1, ... in order, so every version holds a prefix
+    const int writes = 200;
+    std::atomic<bool> writing(true);
+    std::atomic<int> tornViews(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&]() {
+            while (writing.load()) {
+                int count = 0;
+                int highest = -1;
+                for (const auto& emp : store.getAllEmployees()) {
+                    if (emp.getId()[0] == 'w') {
+                        count++;
+                        highest = std::max(highest, std::stoi(emp.getId().substr(1)));
+                    }
+                }
+                if (highest + 1 != count) {
+                    tornViews++;
+                }
+            }
+        });
+    }
+    std::thread writer([&]() {
+        for (int i = 0; i < writes; i++) {
+            std::string id = "w" + std::to_string(i);
+            store.addEmployee(Employee(id, "Writer " + id, "1000", "30", "Tester", id + "@x.com"));
+        }
+        writing.store(false);
+    });
+    writer.join();
+    for (auto& t : readers) {
+        t.join();
+    }
+    assert_int_equal(tornViews.load(), 0);
+    assert_int_equal(store.getAllEmployees().size(), writes + 1);
+
+    // Concurrent adds without an id each get a distinct one
+    std::vector<std::thread> adders;
+    std::vector<std::string> ids(8);
+    for (int i = 0; i < 8; i++) {
+        adders.emplace_back([&store, &ids, i]() {
+            Employee emp("", "Adder", "1", "2", "Tester", "adder" + std::to_string(i) + "@x.com");
+            if (store.addEmployeeWithNextId(emp)) {
+                ids[i] = emp.getId();
+            }
+        });
+    }
+    for (auto& t : adders) {
+        t.join();
+    }
+    std::sort(ids.begin(), ids.end());
+    assert_true(std::unique(ids.begin(), ids.end()) == ids.end());
+    assert_false(ids[0].empty());
+    assert_int_equal(store.getAllEmployees().size(), writes + 9);
+    std::filesystem::remove(path + ".journal");
+
+    // A replaced view lives while any thread has it pinned, and is freed by
+    // the next publish after the last pin is dropped
+    EmployeeStore views(2);
+    auto emptyTables = []() {
+        return std::vector<std::shared_ptr<const EmployeeTable>>{std::make_shared<const EmployeeTable>(),
+                                                                 std::make_shared<const EmployeeTable>()};
+    };
+    std::weak_ptr<const StoreView> first = views.sharedView();
+    {
+        auto pinned = views.view();
+        std::atomic<bool> otherPinned(false);
+        std::atomic<bool> release(false);
+        std::thread other([&]() {
+            auto alsoPinned = views.view();
+            otherPinned.store(true);
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+        });
+        while (!otherPinned.load()) {
+            std::this_thread::yield();
+        }
+        views.publishAll(emptyTables());
+        views.publishAll(emptyTables());
+        assert_false(first.expired());
+        assert_true(&*pinned == first.lock().get());
+        assert_true(&*views.view() != &*pinned);
+        release.store(true);
+        other.join();
+        views.publishAll(emptyTables());
+        assert_false(first.expired());
+    }
+    views.publishAll(emptyTables());
+    assert_true(first.expired());
+}
+
+// Test function: writers on many shards run at once and replay into any shard count
+static void test_sharded_writers(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_sharded.json");
+    PersistenceOptions options;
+    options.durability = DurabilityMode::Group;
+    {
+        EmployeeAPI store(path, options, 8);
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 8; t++) {
+            writers.emplace_back([&store, t]() {
+                for (int i = 0; i < 50; i++) {
+                    std::string id = "s" + std::to_string(t) + "-" + std::to_string(i);
+                    store.addEmployee(Employee(id, "Sharded " + id, std::to_string(1000 + i), "30", "Tester",
+                                               id + "@x.com"));
+                }
+                store.deleteEmployee("s" + std::to_string(t) + "-0");
+            });
+        }
+        for (auto& t : writers) {
+            t.join();
+        }
+        assert_int_equal(store.getAllEmployees().size(), 1 + 8 * 49);
+        assert_int_equal(store.getEmployeesByTitle("tester").size(), 8 * 49);
+        assert_int_equal(store.getHighestSalaryOfEmployees(), 320800);
+
+        // Top earners merge across shards: Tiger, then the eight 1049s
+        auto top = store.getTop10HighestEarningEmployees();
+        assert_int_equal(top.size(), 10);
+        assert_string_equal(top[0].getId().c_str(), "1");
+        assert_string_equal(top[1].getSalary().c_str(), "1049");
+        assert_string_equal(top[9].getSalary().c_str(), "1048");
+
+        auto handle = store.findEmployee("s3-7");
+        assert_true(handle.has_value());
+        assert_string_equal(store.getEmployee(*handle)->getName().c_str(), "Sharded s3-7");
+    }
+
+    // The journal does not depend on the shard count it was written with
+    EmployeeAPI reloaded(path, options, 3);
+    assert_int_equal(reloaded.getAllEmployees().size(), 1 + 8 * 49);
+    assert_false(reloaded.getEmployeeById("s5-0").has_value());
+    assert_true(reloaded.getEmployeeById("s5-49").has_value());
+    std::filesystem::remove(path + ".journal");
+}
+
+// Test function: declared secondary indexes of every kind stay in step with
+// the rows through updates, moves, copies and bulk loads
+static void test_secondary_indexes(void **state) {
+    (void) state;
+    using AgeHash = HashIndex<AgeField>;
+    using AgeOrder = OrderedIndex<AgeField>;
+    using UniqueEmail = UniqueIndex<EmailField>;
+
+    EmployeeTable table;
+    auto person = [](int i, int age) {
+        std::string id = std::to_string(i);
+        return Employee(id, "Person " + id, "100", std::to_string(age), "SDE", "p" + id + "@x.com");
+    };
+    for (int i = 0; i < 1500; i++) {
+        table.upsert(person(i, 20 + i % 45));
+    }
+    // Declared after rows exist, so built from them
+    table.declareIndex<AgeHash>();
+    table.declareIndex<AgeOrder>();
+    table.declareIndex<UniqueEmail>();
+    for (int i = 1500; i < 3000; i++) {
+        table.upsert(person(i, 20 + i % 45));
+    }
+    EmployeeTable before = table;
+    for (int i = 0; i < 3000; i += 4) {
+        table.upsert(person(i, 70 + i % 3));
+    }
+    for (int i = 1; i < 3000; i += 5) {
+        assert_true(table.erase(std::to_string(i)));
+    }
+
+    auto rowsAged = [](const EmployeeTable& t, int age) {
+        std::vector<size_t> rows;
+        t.index<AgeHash>()->entries().forEach(age, [&](std::uint32_t slot) { rows.push_back(t.rowOfSlot(slot)); });
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    };
+    auto scanAged = [](const EmployeeTable& t, int low, int high) {
+        std::vector<size_t> rows;
+        for (size_t row = 0; row < t.size(); row++) {
+            if (t.ageColumn()[row] >= low && t.ageColumn()[row] <= high) {
+                rows.push_back(row);
+            }
+        }
+        return rows;
+    };
+    for (const EmployeeTable* t : {&table, &before}) {
+        for (int age : {20, 33, 64, 70, 72, 99}) {
+            assert_true(rowsAged(*t, age) == scanAged(*t, age, age));
+        }
+
+        // Range walk in key order over the ordered index
+        const auto& ages = t->index<AgeOrder>()->entries();
+        std::vector<size_t> ranged;
+        int previous = 0;
+        for (auto walk = ages.ascendingFrom(30); !walk.done() && walk.key() <= 40; walk.next()) {
+            assert_true(walk.key() >= previous);
+            previous = walk.key();
+            ranged.push_back(t->rowOfSlot(walk.slot()));
+        }
+        std::sort(ranged.begin(), ranged.end());
+        assert_true(ranged == scanAged(*t, 30, 40));
+        assert_int_equal(ages.countUpTo(40) - ages.countBefore(30), ranged.size());
+        assert_int_equal(ages.size(), t->size());
+    }
+
+    // A unique index refuses another employee's key, not the holder's own
+    Employee clash("2", "Clash", "1", "1", "SDE", "p8@x.com");
+    const SecondaryIndexBase* conflict = table.uniqueConflict(clash);
+    assert_non_null(conflict);
+    assert_string_equal(conflict->name(), "email");
+    assert_null(table.uniqueConflict(person(8, 50)));
+    assert_null(table.uniqueConflict(Employee("2", "Free", "1", "1", "SDE", "p1@x.com")));  // p1 was erased
+
+    // Bulk loads build every index at the end; duplicates are left out of unique ones
+    EmployeeTable loaded;
+    loaded.declareIndex<UniqueEmail>();
+    loaded.beginBulkLoad();
+    for (int i = 0; i < 100; i++) {
+        loaded.upsert(Employee(std::to_string(i), "L", std::to_string(i), "30", "SDE", i % 10 ? "same@x.com" : "own" + std::to_string(i) + "@x.com"));
+    }
+    assert_int_equal(loaded.endBulkLoad(), 89);
+    assert_int_equal(loaded.index<UniqueEmail>()->size(), 11);
+    assert_int_equal(loaded.index<SalaryIndex>()->size(), 100);
+    assert_int_equal(*loaded.index<SalaryIndex>()->entries().keyAt(42), 42);
+}
+
+// Test function: range queries over the ordered salary and age indexes match
+// a sorted scan
+static void test_range_queries(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_ranges.json");
+    PersistenceOptions options;
+    options.durability = DurabilityMode::Async;
+    {
+        EmployeeAPI store(path, options, 4);
+        for (int i = 0; i < 400; i++) {
+            std::string id = "r" + std::to_string(i);
+            std::string age = i % 40 == 0 ? "unknown" : std::to_string(20 + (i * 13) % 45);
+            store.addEmployee(Employee(id, "Ranged " + id, std::to_string(50000 + (i * 7919) % 90000), age,
+                                       "Tester", id + "@x.com"));
+        }
+        for (int i = 0; i < 400; i += 7) {
+            store.deleteEmployee("r" + std::to_string(i));
+        }
+        for (int i = 3; i < 400; i += 11) {
+            if (i % 7 != 0) {
+                store.updateEmployee(Employee("r" + std::to_string(i), "Moved", "60000", "35", "Tester", "m@x.com"));
+            }
+        }
+
+        auto scan = [&store](bool salary, int min, int max) {
+            std::vector<int> keys;
+            for (const auto& employee : store.getAllEmployees()) {
+                const std::string& text = salary ? employee.getSalary() : employee.getAge();
+                if (text != "unknown" && std::stoi(text) >= min && std::stoi(text) <= max) {
+                    keys.push_back(std::stoi(text));
+                }
+            }
+            std::sort(keys.begin(), keys.end());
+            return keys;
+        };
+        struct Case {
+            const char* field;
+            int min;
+            int max;
+            size_t limit;
+        };
+        for (const Case& c : {Case{"age", 30, 40, 1000}, Case{"age", 35, 35, 5}, Case{"age", 65, 90, 10},
+                              Case{"salary", 60000, 100000, 25}, Case{"salary", 0, 1000000, 1000}}) {
+            bool salary = std::string(c.field) == "salary";
+            auto expected = scan(salary, c.min, c.max);
+            auto result = store.getEmployeesInRange(c.field, c.min, c.max, c.limit);
+            assert_true(result.has_value());
+            assert_int_equal(result->total, expected.size());
+            assert_int_equal(result->employees.size(), std::min(c.limit, expected.size()));
+            for (size_t i = 0; i < result->employees.size(); i++) {
+                const Employee& employee = result->employees[i];
+                assert_int_equal(std::stoi(salary ? employee.getSalary() : employee.getAge()), expected[i]);
+            }
+        }
+        assert_int_equal(store.getEmployeesInRange("age", 70, 80, 10)->total, 0);
+        assert_false(store.getEmployeesInRange("name", 0, 1, 10).has_value());
+    }
+    std::filesystem::remove(path + ".journal");
+}
+
+// Test function: autocomplete returns the same names and emails, in the same
+// order, as folding and sorting every one of them would, before and after a
+// reload (which builds the prefix indexes in one pass)
+static void test_autocomplete(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_autocomplete.json");
+    PersistenceOptions options;
+    options.durability = DurabilityMode::Async;
+    const char* names[] = {"Anna Smith", "ANNABELLE Jones", "Andrew Ng", "Bob Anders", "annika", "Zoe"};
+
+    auto expected = [](EmployeeAPI& store, const std::string& prefix, size_t limit) {
+        std::string folded = TrigramIndex::fold(prefix);
+        std::vector<std::string> values;
+        for (const auto& employee : store.getAllEmployees()) {
+            for (const std::string& value : {employee.getName(), employee.getEmail()}) {
+                if (TrigramIndex::fold(value).compare(0, folded.size(), folded) == 0) {
+                    values.push_back(TrigramIndex::fold(value));
+                }
+            }
+        }
+        std::sort(values.begin(), values.end());
+        values.resize(std::min(limit, values.size()));
+        return values;
+    };
+    auto check = [&expected](EmployeeAPI& store) {
+        for (const std::string prefix : {"an", "ANNA", "anna smith 1", "a", "zoe", "b", "nobody", "e5"}) {
+            for (size_t limit : {1, 7, 500}) {
+                auto completions = store.getCompletions(prefix, limit);
+                auto values = expected(store, prefix, limit);
+                assert_int_equal(completions.size(), values.size());
+                for (size_t i = 0; i < completions.size(); i++) {
+                    assert_true(TrigramIndex::fold(completions[i].value) == values[i]);
+                    auto employee = store.getEmployeeById(completions[i].id);
+                    assert_true(employee.has_value());
+                    const std::string field = completions[i].field;
+                    assert_true(completions[i].value == (field == "name" ? employee->getName() : employee->getEmail()));
+                }
+            }
+        }
+    };
+
+    {
+        EmployeeAPI store(path, options, 4);
+        for (int i = 0; i < 600; i++) {
+            std::string id = std::to_string(i);
+            store.addEmployee(Employee(id, std::string(names[i % 6]) + " " + id, "1000", "30", "Tester",
+                                       "e" + id + "@Example.com"));
+        }
+        for (int i = 0; i < 600; i += 7) {
+            store.deleteEmployee(std::to_string(i));
+        }
+        for (int i = 2; i < 600; i += 9) {
+            if (i % 7 != 0) {
+                store.updateEmployee(Employee(std::to_string(i), "Zoe Renamed " + std::to_string(i), "1000", "30",
+                                              "Tester", "a" + std::to_string(i) + "@example.com"));
+            }
+        }
+        check(store);
+        assert_int_equal(store.getCompletions("anna", 1000).size(), expected(store, "anna", 1000).size());
+        assert_true(store.getCompletions("nobody", 10).empty());
+    }
+    {
+        EmployeeAPI reloaded(path, options, 4);
+        check(reloaded);
+    }
+    std::filesystem::remove(path + ".journal");
+}
+
+// Test function: fuzzy name search finds the same employees with the same
+// edit counts as comparing every query word with every name word would, and
+// ranks them by edits. Common words span several index blocks.
+static void test_fuzzy_name_search(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_fuzzy.json");
+    PersistenceOptions options;
+    options.durability = DurabilityMode::Async;
+    const char* firsts[] = {"John", "Jon", "Joan", "Johanna", "Sean", "Shawn", "Anna", "Ann-Marie"};
+    const char* lasts[] = {"Smith", "Smyth", "Schmidt", "Nixon", "Dixon", "O'Brien", "Obrien", "Li"};
+
+    auto editDistance = [](const std::string& a, const std::string& b) {
+        std::vector<size_t> row(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); j++) {
+            row[j] = j;
+        }
+        for (size_t i = 1; i <= a.size(); i++) {
+            size_t diagonal = row[0];
+            row[0] = i;
+            for (size_t j = 1; j <= b.size(); j++) {
+                size_t above = row[j];
+                row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+                diagonal = above;
+            }
+        }
+        return static_cast<int>(row[b.size()]);
+    };
+    auto expected = [&editDistance](EmployeeAPI& store, const std::string& query, int maxEdits) {
+        std::vector<std::pair<int, std::string>> matches;
+        auto words = NameTermsField::termsOf(query);
+        for (const auto& employee : store.getAllEmployees()) {
+            auto terms = NameTermsField::termsOf(employee.getName());
+            int total = 0;
+            for (const auto& word : words) {
+                int best = maxEdits + 1;
+                for (const auto& term : terms) {
+                    best = std::min(best, editDistance(word, term));
+                }
+                total = best > maxEdits ? -1 : total + best;
+                if (total < 0) {
+                    break;
+                }
+            }
+            if (!words.empty() && total >= 0) {
+                matches.emplace_back(total, employee.getId());
+            }
+        }
+        std::sort(matches.begin(), matches.end());
+        return matches;
+    };
+    auto check = [&expected](EmployeeAPI& store) {
+        for (const std::string query : {"jon", "SMTH", "jhon smiht", "sean nixon", "obrien", "an", "zzzzzz", "ann marie"}) {
+            for (int maxEdits = 0; maxEdits <= 2; maxEdits++) {
+                auto matches = store.getEmployeesByNameFuzzy(query, maxEdits);
+                auto values = expected(store, query, maxEdits);
+                assert_int_equal(matches.size(), values.size());
+                std::vector<std::pair<int, std::string>> found;
+                for (size_t i = 0; i < matches.size(); i++) {
+                    assert_true(i == 0 || matches[i - 1].edits <= matches[i].edits);
+                    found.emplace_back(matches[i].edits, matches[i].employee.getId());
+                }
+                std::sort(found.begin(), found.end());
+                assert_true(found == values);
+            }
+        }
+    };
+
+    {
+        EmployeeAPI store(path, options, 4);
+        for (int i = 0; i < 3000; i++) {
+            std::string id = std::to_string(i);
+            store.addEmployee(Employee(id, std::string(firsts[i % 8]) + " " + lasts[(i / 8) % 8], "1000", "30",
+                                       "Tester", "e" + id + "@example.com"));
+        }
+        for (int i = 0; i < 3000; i += 11) {
+            store.deleteEmployee(std::to_string(i));
+        }
+        for (int i = 3; i < 3000; i += 13) {
+            if (i % 11 != 0) {
+                store.updateEmployee(Employee(std::to_string(i), "Shaun Smith-Nixon", "1000", "30", "Tester",
+                                              "e" + std::to_string(i) + "@example.com"));
+            }
+        }
+        check(store);
+        auto exact = store.getEmployeesByNameFuzzy("john smith", 2);
+        assert_false(exact.empty());
+        assert_int_equal(exact.front().edits, 0);
+        assert_true(store.getEmployeesByNameFuzzy("  ", 2).empty());
+    }
+    {
+        EmployeeAPI reloaded(path, options, 4);
+        check(reloaded);
+    }
+    std::filesystem::remove(path + ".journal");
+}
+
+// Test function: emails are unique ignoring case across shards and within a
+// batch, and looked up by email, before and after a reload
+static void test_email_index(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_email_index.json");
+    PersistenceOptions options;
+    options.durability = DurabilityMode::Async;
+    {
+        EmployeeAPI store(path, options, 4);
+        for (int i = 0; i < 200; i++) {
+            std::string id = "m" + std::to_string(i);
+            assert_true(store.addEmployee(Employee(id, "Mail " + id, "1000", "30", "Tester", "Mail" + std::to_string(i) + "@X.com")));
+        }
+
+        auto found = store.getEmployeeByEmail("MAIL17@x.COM");
+        assert_true(found.has_value());
+        assert_string_equal(found->getId().c_str(), "m17");
+        assert_false(store.getEmployeeByEmail("nobody@x.com").has_value());
+
+        // Another employee's email, in any case, on add or update
+        MutationResult added = store.submit(Mutation::add(Employee("new", "New", "1", "2", "Tester", "mail5@x.com"))).get();
+        assert_true(added.status == MutationStatus::Conflict);
+        assert_string_equal(added.conflict.c_str(), "email");
+        MutationResult updated = store.submit(Mutation::update(Employee("m6", "Mail m6", "1", "2", "Tester", "MAIL7@X.COM"))).get();
+        assert_true(updated.status == MutationStatus::Conflict);
+        assert_false(store.getEmployeeById("new").has_value());
+        assert_string_equal(store.getEmployeeById("m6")->getEmail().c_str(), "Mail6@X.com");
+
+        // An employee keeps its own email, and frees it on change or delete
+        assert_true(store.updateEmployee(Employee("m8", "Renamed", "1", "2", "Tester", "mail8@x.com")));
+        assert_true(store.updateEmployee(Employee("m9", "Mail m9", "1", "2", "Tester", "moved9@x.com")));
+        assert_true(store.deleteEmployee("m10"));
+        assert_true(store.addEmployee(Employee("n9", "New 9", "1", "2", "Tester", "MAIL9@x.com")));
+        assert_true(store.addEmployee(Employee("n10", "New 10", "1", "2", "Tester", "mail10@x.com")));
+        assert_string_equal(store.getEmployeeByEmail("mail8@X.com")->getName().c_str(), "Renamed");
+        assert_string_equal(store.getEmployeeByEmail("mail9@x.com")->getId().c_str(), "n9");
+
+        // The first of two adds with one email in a batch wins
+        std::vector<std::future<MutationResult>> results;
+        results.push_back(store.submit(Mutation::add(Employee("b1", "B", "1", "2", "Tester", "batch@x.com"))));
+        results.push_back(store.submit(Mutation::add(Employee("b2", "B", "1", "2", "Tester", "Batch@x.com"))));
+        assert_true(results[0].get().status == MutationStatus::Ok);
+        assert_true(results[1].get().status == MutationStatus::Conflict);
+    }
+    {
+        EmployeeAPI reloaded(path, options, 8);
+        assert_string_equal(reloaded.getEmployeeByEmail("MAIL10@X.COM")->getId().c_str(), "n10");
+        assert_string_equal(reloaded.getEmployeeByEmail("moved9@x.com")->getId().c_str(), "m9");
+        assert_string_equal(reloaded.getEmployeeByEmail("batch@x.com")->getId().c_str(), "b1");
+        assert_true(reloaded.submit(Mutation::add(Employee("late", "L", "1", "2", "Tester", "mail100@x.com"))).get().status ==
+                    MutationStatus::Conflict);
+    }
+    std::filesystem::remove(path + ".journal");
+
+    // Duplicates already in a data file land in several shards; only one of
+    // them is indexed across all of them, whatever the shard count
+    std::string error;
+    assert_true(Snapshot::write(path, 40, [](const EmployeeVisitor& visit) {
+        for (int i = 0; i < 40; i++) {
+            visit(Employee("d" + std::to_string(i), "Dup", "1", "2", "Tester", i % 2 ? "DUP@x.com" : "dup@x.com"));
+        }
+    }, error));
+    std::string filterError;
+    auto byEmail = Filter::fromJson(nlohmann::json::parse(R"({"field": "email", "op": "=", "value": "dup@x.com"})"), filterError);
+    for (size_t shards : {size_t(1), size_t(8)}) {
+        EmployeeAPI duplicated(path, options, shards);
+        QueryResult indexed = duplicated.query(*byEmail, 100);
+        assert_true(indexed.plan.driver.path == AccessPath::EmailLookup);
+        assert_int_equal(indexed.total, 1);
+        assert_true(duplicated.getEmployeeByEmail("dup@x.com").has_value());
+        assert_true(duplicated.submit(Mutation::add(Employee("d40", "Dup", "1", "2", "Tester", "dup@X.com"))).get().status ==
+                    MutationStatus::Conflict);
+    }
+    std::filesystem::remove(path + ".journal");
+}
+
+// Test function: composite queries return what checking every employee
+// would, whichever index or scan the planner drives them from, and explain
+// the plan it chose
+static void test_composite_query(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_composite_query.json");
+    PersistenceOptions options;
+    options.durability = DurabilityMode::Async;
+    EmployeeAPI store(path, options, 4);
+    const char* firstNames[] = {"Ada", "Grace", "Alan", "Edsger", "Barbara", "Donald", "Frances"};
+    const char* lastNames[] = {"Lovelace", "Hopper", "Turing", "Dijkstra", "Liskov", "Knuth", "Allen", "Ritchie", "Thompson", "Kay", "Hoare"};
+    const char* titles[] = {"Software Engineer", "Senior Engineer", "Manager", "Designer", "Analyst"};
+    for (int i = 0; i < 2000; i++) {
+        std::string salary = i % 100 == 0 ? "n/a" : std::to_string(50000 + (i * 7919) % 150000);
+        assert_true(store.addEmployee(Employee("q" + std::to_string(i), std::string(firstNames[i % 7]) + " " + lastNames[i % 11],
+                                               salary, std::to_string(20 + i % 45), titles[i % 5],
+                                               "q" + std::to_string(i) + "@corp.com")));
+    }
+    auto all = store.getAllEmployees();
+
+    auto run = [&store](const char* filterText, size_t limit = 5000) {
+        std::string error;
+        auto filter = Filter::fromJson(nlohmann::json::parse(filterText), error);
+        assert_true(filter.has_value());
+        return store.query(*filter, limit);
+    };
+    auto numeric = [](const std::string& text) { return text == "n/a" ? -1 : std::stoi(text); };
+    auto expectMatches = [&all](const QueryResult& result, const std::function<bool(const Employee&)>& accept) {
+        std::vector<std::string> expected;
+        for (const auto& employee : all) {
+            if (accept(employee)) {
+                expected.push_back(employee.getId());
+            }
+        }
+        std::vector<std::string> actual;
+        for (const auto& employee : result.employees) {
+            actual.push_back(employee.getId());
+        }
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        assert_int_equal(result.total, expected.size());
+        assert_true(actual == expected);
+    };
+
+    // The reporting query: the narrowest of the three indexes drives it
+    auto report = run(R"({"and": [{"field": "title", "op": "contains", "value": "ENGINEER"},
+                                  {"field": "salary", "op": ">", "value": 190000},
+                                  {"field": "age", "op": "<", "value": "40"}]})");
+    expectMatches(report, [&](const Employee& e) {
+        return e.getTitle().find("Engineer") != std::string::npos && numeric(e.getSalary()) > 190000 &&
+               std::stoi(e.getAge()) < 40;
+    });
+    assert_true(report.plan.driver.path == AccessPath::SalaryRange);
+    assert_int_equal(report.rowsExamined, report.plan.driver.estimatedRows);
+    assert_int_equal(report.plan.residual.conjuncts().size(), 2);
+    assert_true(report.rowsExamined < all.size());
+    json explain = ApiFormatter::formatQueryPlan(report);
+    assert_string_equal(explain["driver"]["access"].get<std::string>().c_str(), accessPathName(AccessPath::SalaryRange));
+    assert_int_equal(explain["driver"]["estimated_rows"].get<std::uint64_t>(), report.plan.driver.estimatedRows);
+    assert_int_equal(explain["rows_examined"].get<std::uint64_t>(), report.rowsExamined);
+    assert_int_equal(explain["rows_matched"].get<std::uint64_t>(), report.total);
+
+    // Point lookups are exact and examine one row
+    auto byId = run(R"({"and": [{"field": "id", "op": "=", "value": "q17"}, {"field": "age", "op": ">=", "value": 20}]})");
+    assert_true(byId.plan.driver.path == AccessPath::IdLookup);
+    assert_int_equal(byId.rowsExamined, 1);
+    assert_int_equal(byId.total, 1);
+    auto byEmail = run(R"({"field": "email", "op": "=", "value": "Q42@CORP.COM"})");
+    assert_true(byEmail.plan.driver.path == AccessPath::EmailLookup);
+    assert_string_equal(byEmail.employees.at(0).getId().c_str(), "q42");
+
+    // Name prefixes and substrings, with a residual not
+    auto names = run(R"({"and": [{"field": "name", "op": "prefix", "value": "grace h"},
+                                 {"not": {"field": "title", "op": "=", "value": "manager"}}]})");
+    expectMatches(names, [](const Employee& e) { return e.getName().rfind("Grace H", 0) == 0 && e.getTitle() != "Manager"; });
+    assert_true(names.plan.driver.path == AccessPath::NamePrefix);
+    auto substring = run(R"({"field": "name", "op": "contains", "value": "jkst"})");
+    expectMatches(substring, [](const Employee& e) { return e.getName().find("Dijkstra") != std::string::npos; });
+    assert_true(substring.plan.driver.path == AccessPath::NameTrigrams);
+
+    // An or, and a predicate matching most rows, scan
+    auto either = run(R"({"or": [{"field": "title", "op": "=", "value": "Designer"},
+                                 {"field": "age", "op": "=", "value": 33}]})");
+    expectMatches(either, [](const Employee& e) { return e.getTitle() == "Designer" || e.getAge() == "33"; });
+    assert_true(either.plan.driver.path == AccessPath::FullScan);
+    assert_int_equal(either.rowsExamined, all.size());
+    auto broad = run(R"({"and": [{"field": "age", "op": ">", "value": 21}, {"field": "salary", "op": "!=", "value": 60000}]})");
+    expectMatches(broad, [&](const Employee& e) {
+        return std::stoi(e.getAge()) > 21 && numeric(e.getSalary()) >= 0 && numeric(e.getSalary()) != 60000;
+    });
+    assert_true(broad.plan.driver.path == AccessPath::FullScan);
+
+    // An empty range drives the query without examining anything
+    auto none = run(R"({"and": [{"field": "salary", "op": "<", "value": -5}, {"field": "name", "op": "!=", "value": "x"}]})");
+    assert_int_equal(none.total, 0);
+    assert_int_equal(none.rowsExamined, 0);
+
+    // The limit caps the employees returned, not the total
+    auto limited = run(R"({"field": "title", "op": "contains", "value": "engineer"})", 10);
+    assert_int_equal(limited.employees.size(), 10);
+    assert_int_equal(limited.total, 800);
+
+    // Malformed filters are rejected with a reason
+    std::string error;
+    for (const char* bad : {R"({"field": "height", "op": "=", "value": 1})", R"({"field": "name", "op": "<", "value": "a"})",
+                            R"({"field": "salary", "op": ">", "value": "lots"})", R"({"and": {"field": "id"}})", R"([1])"}) {
+        error.clear();
+        assert_false(Filter::fromJson(nlohmann::json::parse(bad), error).has_value());
+        assert_false(error.empty());
+    }
+    std::string deep = R"({"field": "age", "op": "=", "value": 1})";
+    for (int i = 0; i < 40; i++) {
+        deep = R"({"not": )" + deep + "}";
+    }
+    assert_false(Filter::fromJson(nlohmann::json::parse(deep), error).has_value());
+
+    // Every access path returns what a forced scan does, including for empty
+    // names and emails, which the indexes leave out
+    assert_true(store.addEmployee(Employee("blank1", "", "70000", "30", "Manager", "")));
+    assert_true(store.addEmployee(Employee("blank2", "", "80000", "41", "Analyst", "blank2@corp.com")));
+    assert_true(store.addEmployee(Employee("blank3", "Ada Byron", "90000", "52", "Designer", "")));
+    for (const char* predicate : {R"({"field": "id", "op": "=", "value": "q17"})",
+                                  R"({"field": "email", "op": "=", "value": "q42@corp.com"})",
+                                  R"({"field": "email", "op": "=", "value": ""})",
+                                  R"({"field": "email", "op": "prefix", "value": "q1"})",
+                                  R"({"field": "email", "op": "prefix", "value": ""})",
+                                  R"({"field": "name", "op": "=", "value": "ada lovelace"})",
+                                  R"({"field": "name", "op": "=", "value": ""})",
+                                  R"({"field": "name", "op": "prefix", "value": "Ada"})",
+                                  R"({"field": "name", "op": "prefix", "value": ""})",
+                                  R"({"field": "name", "op": "contains", "value": "jkst"})",
+                                  R"({"field": "title", "op": "contains", "value": "engineer"})",
+                                  R"({"field": "salary", "op": ">", "value": 190000})",
+                                  R"({"field": "age", "op": "<=", "value": 25})"}) {
+        auto planned = run(predicate);
+        auto scanned = run(("{\"not\": {\"not\": " + std::string(predicate) + "}}").c_str());
+        assert_true(scanned.plan.driver.path == AccessPath::FullScan);
+        std::vector<std::string> plannedIds;
+        std::vector<std::string> scannedIds;
+        for (const auto& employee : planned.employees) {
+            plannedIds.push_back(employee.getId());
+        }
+        for (const auto& employee : scanned.employees) {
+            scannedIds.push_back(employee.getId());
+        }
+        std::sort(plannedIds.begin(), plannedIds.end());
+        std::sort(scannedIds.begin(), scannedIds.end());
+        assert_int_equal(planned.total, scanned.total);
+        assert_true(plannedIds == scannedIds);
+        assert_true(planned.total > 0);
+    }
+}
+
+// Test function: the salary index answers top-K, rank and percentile queries
+// the same way sorting every salary would
+static void test_salary_ranks(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_salaries.json");
+    PersistenceOptions options;
+    options.durability = DurabilityMode::Async;
+    std::vector<int> salaries;
+    std::uint64_t p2Rank = 0;
+    std::int32_t median = 0;
+    {
+        EmployeeAPI store(path, options, 4);
+        for (int i = 0; i < 600; i++) {
+            std::string id = "p" + std::to_string(i);
+            std::string salary = i % 50 == 0 ? "n/a" : std::to_string(1000 + (i * 37) % 211);
+            assert_true(store.addEmployee(Employee(id, "Paid " + id, salary, "30", "Tester", id + "@x.com")));
+        }
+        for (int i = 0; i < 600; i += 9) {
+            assert_true(store.deleteEmployee("p" + std::to_string(i)));
+        }
+        for (int i = 1; i < 600; i += 10) {
+            bool updated = store.updateEmployee(Employee("p" + std::to_string(i), "Raised", std::to_string(5000 + i % 3),
+                                                         "30", "Tester", "r" + std::to_string(i) + "@x.com"));
+            assert_true(updated == (i % 9 != 0));
+        }
+
+        for (const auto& employee : store.getAllEmployees()) {
+            if (employee.getSalary() != "n/a") {
+                salaries.push_back(std::stoi(employee.getSalary()));
+            }
+        }
+        std::sort(salaries.rbegin(), salaries.rend());
+        assert_int_equal(store.getHighestSalaryOfEmployees(), salaries.front());
+
+        auto top = store.getTopEarners(40);
+        assert_int_equal(top.size(), 40);
+        for (size_t i = 0; i < top.size(); i++) {
+            assert_int_equal(std::stoi(top[i].getSalary()), salaries[i]);
+        }
+        assert_int_equal(store.getTopEarners(100000).size(), salaries.size());
+        assert_int_equal(store.getTop10HighestEarningEmployees().size(), 10);
+
+        auto rank = store.getSalaryRank("p2");
+        assert_true(rank.has_value());
+        assert_int_equal(rank->total, salaries.size());
+        auto above = std::count_if(salaries.begin(), salaries.end(), [&](int s) { return s > rank->salary; });
+        assert_int_equal(rank->rank, above + 1);
+        assert_int_equal(store.getSalaryRank("1")->rank, 1);
+        assert_false(store.getSalaryRank("p50").has_value());   // not numeric
+        assert_false(store.getSalaryRank("p9").has_value());    // deleted
+
+        std::vector<int> ascending(salaries.rbegin(), salaries.rend());
+        for (double percentile : {0.0, 1.0, 25.0, 50.0, 90.0, 99.5, 100.0}) {
+            auto nearest = std::max<size_t>(1, static_cast<size_t>(std::ceil(percentile / 100 * ascending.size())));
+            assert_int_equal(*store.getSalaryAtPercentile(percentile), ascending[nearest - 1]);
+        }
+        p2Rank = rank->rank;
+        median = *store.getSalaryAtPercentile(50);
+    }
+
+    // Loading builds the index in one pass; it must agree with the incremental one
+    {
+        EmployeeAPI reloaded(path, options, 4);
+        auto reloadedTop = reloaded.getTopEarners(100000);
+        assert_int_equal(reloadedTop.size(), salaries.size());
+        for (size_t i = 0; i < reloadedTop.size(); i++) {
+            assert_int_equal(std::stoi(reloadedTop[i].getSalary()), salaries[i]);
+        }
+        assert_int_equal(reloaded.getSalaryRank("p2")->rank, p2Rank);
+        assert_int_equal(*reloaded.getSalaryAtPercentile(50), median);
+    }
+    std::filesystem::remove(path + ".journal");
+
+    // A copied table keeps the index of its own version
+    EmployeeTable table;
+    table.upsert(Employee("a", "A", "300", "30", "T", "a@x.com"));
+    table.upsert(Employee("b", "B", "100", "30", "T", "b@x.com"));
+    EmployeeTable before = table;
+    table.upsert(Employee("b", "B", "900", "30", "T", "b@x.com"));
+    assert_true(table.erase("a"));
+    const auto& salariesAfter = table.index<SalaryIndex>()->entries();
+    const auto& salariesBefore = before.index<SalaryIndex>()->entries();
+    assert_int_equal(salariesAfter.size(), 1);
+    assert_int_equal(*salariesAfter.last(), 900);
+    assert_int_equal(salariesBefore.size(), 2);
+    assert_int_equal(*salariesBefore.last(), 300);
+    assert_int_equal(*salariesBefore.keyAt(0), 100);
+}
+
+// Test function: the writer thread applies queued mutations in batches
+static void test_mutation_batches(void **state) {
+    (void) state;
+    std::string path = makeScratchDataFile("cmocka_mutation_batches.json");
+    PersistenceOptions options;
+    options.groupCommitWindow = std::chrono::milliseconds(20);
+    {
+        EmployeeAPI store(path, options);
+
+        // Queue everything before waiting, as concurrent handlers would
+        std::vector<std::future<MutationResult>> results;
+        for (int i = 0; i < 100; i++) {
+            results.push_back(store.submit(Mutation::addWithNextId(Employee("", "Batch", "1", "2", "Tester", "b" + std::to_string(i) + "@x.com"))));
+        }
+        results.push_back(store.submit(Mutation::add(Employee("1", "Duplicate", "1", "2", "Tester", "d@x.com"))));
+        results.push_back(store.submit(Mutation::remove("missing")));
+        results.push_back(store.submit(Mutation::remove("2")));
+
+        std::vector<std::string> ids;
+        for (int i = 0; i < 100; i++) {
+            MutationResult result = results[i].get();
+            assert_true(result.status == MutationStatus::Ok);
+            ids.push_back(result.id);
+        }
+        std::sort(ids.begin(), ids.end());
+        assert_true(std::unique(ids.begin(), ids.end()) == ids.end());
+        assert_true(results[100].get().status == MutationStatus::AlreadyExists);
+        assert_true(results[101].get().status == MutationStatus::NotFound);
+        assert_true(results[102].get().status == MutationStatus::Ok);
+
+        MutationStats stats = store.getMutationStats();
+        assert_int_equal(stats.mutations, 103);
+        assert_true(stats.batches < stats.mutations);
+        assert_true(store.getPersistenceStats().batches < 100);
+        assert_int_equal(store.getAllEmployees().size(), 100);
+    }
+
+    EmployeeAPI reloaded(path, options);
+    assert_int_equal(reloaded.getAllEmployees().size(), 100);
+    assert_false(reloaded.getEmployeeById("2").has_value());
+    std::filesystem::remove(path + ".journal");
+}
+
+static void test_work_stealing_pool(void **state) {
+    (void) state;
+    {
+        WorkStealingPool pool(4, 64);
+        std::atomic<int> ran{0};
+        int accepted = 0;
+        for (int i = 0; i < 10000; i++) {
+            // Retry while the deques are full rather than counting on the workers to keep up
+            while (!pool.enqueue([&ran]() { ran++; })) {
+                std::this_thread::yield();
+            }
+            accepted++;
+        }
+        pool.shutdown();
+        assert_int_equal(ran.load(), accepted);
+        TaskPoolStats stats = pool.stats();
+        assert_int_equal(stats.workers, 4);
+        assert_int_equal(stats.enqueued, 10000);
+        assert_int_equal(stats.completed, 10000);
+        assert_int_equal(stats.depth, 0);
+        assert_false(pool.enqueue([]() {}));
+    }
+
+    // While one worker is stuck, the other must steal the tasks queued on its deque
+    {
+        WorkStealingPool pool(2, 4);
+        std::atomic<bool> blocked{false};
+        std::atomic<bool> release{false};
+        std::atomic<int> ran{0};
+        assert_true(pool.enqueue([&]() {
+            blocked = true;
+            while (!release) {
+                std::this_thread::yield();
+            }
+        }));
+        while (!blocked) {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < 4; i++) {
+            assert_true(pool.enqueue([&ran]() { ran++; }));
+        }
+        while (ran < 4) {
+            std::this_thread::yield();
+        }
+        assert_true(pool.stats().steals >= 2);
+        release = true;
+    }
+
+    // With its only worker busy, a full deque rejects new tasks
+    {
+        WorkStealingPool pool(1, 4);
+        std::atomic<bool> blocked{false};
+        std::atomic<bool> release{false};
+        assert_true(pool.enqueue([&]() {
+            blocked = true;
+            while (!release) {
+                std::this_thread::yield();
+            }
+        }));
+        while (!blocked) {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < 4; i++) {
+            assert_true(pool.enqueue([]() {}));
+        }
+        assert_false(pool.enqueue([]() {}));
+        TaskPoolStats stats = pool.stats();
+        assert_int_equal(stats.depth, 4);
+        assert_int_equal(stats.rejected, 1);
+        release = true;
+    }
+}
+
+static void test_request_lanes(void **state) {
+    (void) state;
+    LatencyHistogram histogram;
+    for (std::uint64_t micros = 1; micros <= 100; micros++) {
+        histogram.record(micros);
+    }
+    assert_int_equal(histogram.count(), 100);
+    assert_in_range(histogram.percentile(0.5), 50, 62);
+    assert_int_equal(histogram.percentile(0.99), 100);
+
+    std::array<LaneOptions, kLaneCount> options;
+    options[static_cast<size_t>(Lane::Scan)].workers = 1;
+    options[static_cast<size_t>(Lane::Scan)].queueCapacity = 1;
+    RequestLanes lanes(options);
+
+    bool ran = false;
+    assert_true(lanes.run(Lane::PointRead, [&ran]() { ran = true; }));
+    assert_true(ran);
+    bool rethrown = false;
+    try {
+        lanes.run(Lane::Mutation, []() { throw std::runtime_error("handler failed"); });
+    } catch (const std::runtime_error&) {
+        rethrown = true;
+    }
+    assert_true(rethrown);
+
+    // Occupy the scan worker and its one queue slot
+    std::atomic<bool> blocked{false};
+    std::atomic<bool> release{false};
+    std::thread slowScan([&]() {
+        lanes.run(Lane::Scan, [&]() {
+            blocked = true;
+            while (!release) {
+                std::this_thread::yield();
+            }
+        });
+    });
+    while (!blocked) {
+        std::this_thread::yield();
+    }
+    std::thread queuedScan([&]() { lanes.run(Lane::Scan, []() {}); });
+    while (lanes.stats(Lane::Scan).depth < 1) {
+        std::this_thread::yield();
+    }
+
+    // A full scan lane refuses more scans but not point reads
+    assert_false(lanes.run(Lane::Scan, []() {}));
+    assert_true(lanes.run(Lane::PointRead, []() {}));
+    release = true;
+    slowScan.join();
+    queuedScan.join();
+
+    LaneStats scan = lanes.stats(Lane::Scan);
+    assert_int_equal(scan.completed, 2);
+    assert_int_equal(scan.rejected, 1);
+    assert_int_equal(scan.depth, 0);
+    assert_true(scan.maxMicros >= scan.serviceP50Micros);
+    assert_int_equal(lanes.stats(Lane::PointRead).completed, 2);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_get_all_employees),
@@ -283,6 +1798,32 @@ int main() {
         cmocka_unit_test(test_highest_salary),
         cmocka_unit_test(test_top_earners),
         cmocka_unit_test(test_employees_by_title),
+        cmocka_unit_test(test_employee_table),
+        cmocka_unit_test(test_title_dictionary),
+        cmocka_unit_test(test_trigram_name_search),
+        cmocka_unit_test(test_substring_search),
+        cmocka_unit_test(test_flat_hash_index),
+        cmocka_unit_test(test_employee_id),
+        cmocka_unit_test(test_employee_handles),
+        cmocka_unit_test(test_journal_replay),
+        cmocka_unit_test(test_journal_compaction),
+        cmocka_unit_test(test_forked_snapshot),
+        cmocka_unit_test(test_group_commit_batches),
+        cmocka_unit_test(test_concurrent_readers_and_writers),
+        cmocka_unit_test(test_sharded_writers),
+        cmocka_unit_test(test_salary_ranks),
+        cmocka_unit_test(test_secondary_indexes),
+        cmocka_unit_test(test_range_queries),
+        cmocka_unit_test(test_autocomplete),
+        cmocka_unit_test(test_fuzzy_name_search),
+        cmocka_unit_test(test_email_index),
+        cmocka_unit_test(test_composite_query),
+        cmocka_unit_test(test_mutation_batches),
+        cmocka_unit_test(test_work_stealing_pool),
+        cmocka_unit_test(test_request_lanes),
+        cmocka_unit_test(test_binary_snapshot),
+        cmocka_unit_test(test_streaming_json_load),
+        cmocka_unit_test(test_parallel_jsonl_load),
     };
     
     // Start timing the entire test suite execution
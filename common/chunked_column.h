@@ -0,0 +1,93 @@
+#ifndef CHUNKED_COLUMN_H
+#define CHUNKED_COLUMN_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Column of values stored in fixed-size chunks that copies of the column
+// share. Copying costs one pointer per chunk; writing to a row first clones its
+// chunk if another copy still refers to it. Used for the per-row state of
+// EmployeeTable, strings and numbers alike, so publishing a new table version
+// copies one pointer per 1024 rows rather than every row.
+template <typename T>
+class ChunkedColumn {
+private:
+    static constexpr size_t kChunkSize = 1024;
+    using Chunk = std::vector<T>;
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    size_t count = 0;
+
+    // Chunks are only shared with other copies of the column, which are made
+    // while no one writes to this one, so use_count() is stable here
+    Chunk& writableChunk(size_t index) {
+        if (chunks[index].use_count() > 1) {
+            auto copy = std::make_shared<Chunk>();
+            copy->reserve(kChunkSize);
+            copy->assign(chunks[index]->begin(), chunks[index]->end());
+            chunks[index] = std::move(copy);
+        }
+        return *chunks[index];
+    }
+
+public:
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    const T& operator[](size_t row) const {
+        return (*chunks[row / kChunkSize])[row % kChunkSize];
+    }
+
+    const T& back() const {
+        return (*this)[count - 1];
+    }
+
+    // Calls visit(value) for every row in order, a chunk at a time
+    template <typename Visit>
+    void forEach(Visit&& visit) const {
+        for (const auto& chunk : chunks) {
+            for (const T& value : *chunk) {
+                visit(value);
+            }
+        }
+    }
+
+    // Writable reference to one row, unsharing its chunk first
+    T& mutableAt(size_t row) {
+        return writableChunk(row / kChunkSize)[row % kChunkSize];
+    }
+
+    void push_back(T value) {
+        if (count % kChunkSize == 0) {
+            chunks.push_back(std::make_shared<Chunk>());
+            chunks.back()->reserve(kChunkSize);
+        }
+        writableChunk(chunks.size() - 1).push_back(std::move(value));
+        count++;
+    }
+
+    void pop_back() {
+        writableChunk(chunks.size() - 1).pop_back();
+        count--;
+        if (count % kChunkSize == 0) {
+            chunks.pop_back();
+        }
+    }
+
+    void clear() {
+        chunks.clear();
+        count = 0;
+    }
+
+    void reserve(size_t rows) {
+        chunks.reserve((rows + kChunkSize - 1) / kChunkSize);
+    }
+};
+
+#endif // CHUNKED_COLUMN_H
@@ -8,27 +8,27 @@ Employee::Employee(const std::string& id, const std::string& name, const std::st
       employee_age(age), employee_title(title), employee_email(email) {}
 
 // Getters
-std::string Employee::getId() const {
+const std::string& Employee::getId() const {
     return id;
 }
 
-std::string Employee::getName() const {
+const std::string& Employee::getName() const {
     return employee_name;
 }
 
-std::string Employee::getSalary() const {
+const std::string& Employee::getSalary() const {
     return employee_salary;
 }
 
-std::string Employee::getAge() const {
+const std::string& Employee::getAge() const {
     return employee_age;
 }
 
-std::string Employee::getTitle() const {
+const std::string& Employee::getTitle() const {
     return employee_title;
 }
 
-std::string Employee::getEmail() const {
+const std::string& Employee::getEmail() const {
     return employee_email;
 }
 
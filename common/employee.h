@@ -18,12 +18,12 @@ public:
              const std::string& age, const std::string& title, const std::string& email);
     
     // Getters
-    std::string getId() const;
-    std::string getName() const;
-    std::string getSalary() const;
-    std::string getAge() const;
-    std::string getTitle() const;
-    std::string getEmail() const;
+    const std::string& getId() const;
+    const std::string& getName() const;
+    const std::string& getSalary() const;
+    const std::string& getAge() const;
+    const std::string& getTitle() const;
+    const std::string& getEmail() const;
     
     // Setters
     void setId(const std::string& id);
@@ -1,144 +1,704 @@
 #include "employee_api.h"
+#include "levenshtein_automaton.h"
 #include "logger.h"
-#include <fstream>
+#include "snapshot.h"
+#include "timer.h"
+#include <filesystem>
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
-EmployeeAPI::EmployeeAPI(const std::string& dataFilePath) : dataFilePath(dataFilePath) {
+namespace {
+
+// Read a "Key:   1234 kB" line from a /proc file; 0 when unavailable
+std::uint64_t readProcKb(const char* procFile, const char* key) {
+    FILE* file = std::fopen(procFile, "r");
+    if (file == nullptr) {
+        return 0;
+    }
+
+    std::uint64_t value = 0;
+    size_t keyLength = std::strlen(key);
+    char line[256];
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        if (std::strncmp(line, key, keyLength) == 0 && line[keyLength] == ':') {
+            value = std::strtoull(line + keyLength + 1, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(file);
+    return value;
+}
+
+// Outcome a forked snapshot child reports back to the parent over a pipe
+struct ChildSnapshotResult {
+    int ok;
+    std::uint64_t durationMillis;
+    std::uint64_t rssStartKb;
+    std::uint64_t rssEndKb;
+    std::uint64_t copyOnWriteKb;
+    char error[192];
+};
+
+std::int64_t unixNow() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string putRecord(const Employee& employee) {
+    return json{{"op", "put"}, {"data", Snapshot::employeeToJson(employee)}}.dump();
+}
+
+std::string deleteRecord(const std::string& id) {
+    return json{{"op", "delete"}, {"id", id}}.dump();
+}
+
+// Numeric salaries of a shard in order
+const SalaryIndex::Tree& salariesOf(const EmployeeTable& table) {
+    return table.index<SalaryIndex>()->entries();
+}
+
+// Merge the shards' ordered index over [min, max] from the low end, taking
+// the earlier shard on ties; O(log n + limit) per shard
+template <typename Index>
+RangeResult rangeOf(const StoreView& view, std::int32_t min, std::int32_t max, size_t limit) {
+    RangeResult result;
+    std::vector<typename Index::Tree::Cursor> walks;
+    walks.reserve(view.shards.size());
+    for (const auto& table : view.shards) {
+        const auto& entries = table->template index<Index>()->entries();
+        result.total += entries.countUpTo(max) - std::min(entries.countBefore(min), entries.countUpTo(max));
+        walks.push_back(entries.ascendingFrom(min));
+    }
+
+    while (result.employees.size() < limit) {
+        size_t best = walks.size();
+        for (size_t shard = 0; shard < walks.size(); shard++) {
+            if (!walks[shard].done() && walks[shard].key() <= max &&
+                (best == walks.size() || walks[shard].key() < walks[best].key())) {
+                best = shard;
+            }
+        }
+        if (best == walks.size()) {
+            break;
+        }
+        const auto& table = view.shards[best];
+        result.employees.push_back(table->row(table->rowOfSlot(walks[best].slot())));
+        walks[best].next();
+    }
+    return result;
+}
+
+// Entries of a fuzzily matched name word counted one by one before counting
+// the rest by whole blocks
+constexpr size_t kFuzzyWalkedEntries = 64;
+
+// One shard's walk over the keys of one prefix index
+struct CompletionWalk {
+    PrefixDictionary::Cursor cursor;
+    size_t shard;
+    bool isName;
+};
+
+} // namespace
+
+EmployeeAPI::EmployeeAPI(const std::string& dataFilePath, const PersistenceOptions& options, size_t shardCount)
+    : employees(shardCount), nextNumericId(1), dataFilePath(dataFilePath), options(options),
+      journal(dataFilePath + ".journal"), compactionRunning(false) {
     loadEmployees();
+    writerThread = std::thread([this]() { runWriter(); });
+}
+
+EmployeeAPI::~EmployeeAPI() {
+    // Apply everything already queued before the journal goes away
+    mutations.stop();
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    waitForCompaction();
+    journalWriter.reset();
 }
 
 bool EmployeeAPI::loadEmployees() {
-    Logger::get()->info("Loading employees from {}", dataFilePath);
+    Logger::get()->info("Loading employees from {} into {} shards", dataFilePath, employees.shardCount());
+    auto locks = employees.lockAll();
+    waitForCompaction();
+    if (journalWriter) {
+        journalWriter->flush();
+    }
+    std::atomic_store(&journalWriter, std::shared_ptr<JournalWriter>());
+    journal.close();
     
-    try {
-        std::ifstream file(dataFilePath);
-        if (!file.is_open()) {
-            Logger::get()->error("Could not open file: {}", dataFilePath);
-            return false;
+    // Build the new tables privately; readers keep the old ones until they are published
+    bool snapshotLoaded = false;
+    std::vector<std::shared_ptr<EmployeeTable>> loaded;
+    for (size_t shard = 0; shard < employees.shardCount(); shard++) {
+        loaded.push_back(std::make_shared<EmployeeTable>());
+        loaded.back()->beginBulkLoad();
+    }
+    auto publishLoaded = [this, &loaded]() {
+        size_t duplicates = 0;
+        for (auto& table : loaded) {
+            duplicates += table->endBulkLoad();
         }
+        // Shards are split by id, so duplicates in a data file may land in
+        // different ones; the lowest shard keeps the key, which is also the
+        // one lookups and the writer's checks probe first
+        std::vector<const EmployeeTable*> earlier;
+        for (auto& table : loaded) {
+            duplicates += table->dropUniqueKeysHeldBy(earlier);
+            earlier.push_back(table.get());
+        }
+        if (duplicates > 0) {
+            Logger::get()->warn("{} employees repeat a key of a unique index and are missing from it", duplicates);
+        }
+        std::vector<std::shared_ptr<const EmployeeTable>> tables(loaded.begin(), loaded.end());
+        std::uint64_t next = 1;
+        for (const auto& table : tables) {
+            next = std::max(next, table->nextNumericId());
+        }
+        nextNumericId.store(next);
+        employees.publishAll(std::move(tables));
+    };
 
-        json jsonData;
-        file >> jsonData;
-        file.close();
-
-        employees.clear();
-        Logger::get()->debug("Parsing {} employee records from JSON", jsonData.size());
-        
-        if (jsonData.contains("data") && jsonData["data"].is_array()) {
-            for (const auto& item : jsonData["data"]) {
-                try {
-                    Employee emp;
-                    emp.setId(item["id"].get<std::string>());
-                    emp.setName(item["employee_name"].get<std::string>());
-                    emp.setSalary(item["employee_salary"].is_string() ? 
-                        item["employee_salary"].get<std::string>() : 
-                        std::to_string(item["employee_salary"].get<int>()));
-                    emp.setAge(item["employee_age"].is_string() ? 
-                        item["employee_age"].get<std::string>() : 
-                        std::to_string(item["employee_age"].get<int>()));
-                    emp.setTitle(item["employee_title"].get<std::string>());
-                    emp.setEmail(item["employee_email"].get<std::string>());
-                    
-                    employees[emp.getId()] = emp;
-                } catch (const std::exception& e) {
-                    Logger::get()->warn("Failed to parse employee record: {}", e.what());
-                    // Continue with next record
-                }
+    size_t count = 0;
+    if (!std::filesystem::exists(dataFilePath)) {
+        Logger::get()->error("Could not open file: {}", dataFilePath);
+    } else {
+        std::string error;
+        bool ok = Snapshot::read(dataFilePath, [this, &loaded, &count](const Employee& emp) {
+            loaded[employees.shardOf(emp.getId())]->upsert(emp);
+            count++;
+        }, error);
+        if (!ok) {
+            Logger::get()->error("Error loading employees: {}", error);
+            for (auto& table : loaded) {
+                table->clear();
             }
+            publishLoaded();
+            return false;
         }
-        
-        Logger::get()->info("Successfully loaded {} employees", employees.size());
-        return true;
-    } catch (const std::exception& e) {
-        Logger::get()->error("Error loading employees: {}", e.what());
+        Logger::get()->info("Successfully loaded {} employees", count);
+        snapshotLoaded = true;
+    }
+
+    // Replay mutations logged since the snapshot: an interrupted compaction
+    // may have left a rotated segment, which is older than the active one
+    auto apply = [this, &loaded](const std::string& record) { applyJournalRecord(loaded, record); };
+    bool hadRotated = journal.hasRotated();
+    long replayed = 0;
+    if (hadRotated) {
+        replayed += std::max(0L, Journal::replay(journal.rotatedPath(), apply));
+    }
+    replayed += std::max(0L, Journal::replay(journal.getPath(), apply));
+    publishLoaded();
+    if (replayed > 0) {
+        Logger::get()->info("Replayed {} journal records, {} employees in memory", replayed,
+                            currentEmployees()->size());
+    }
+
+    if (!journal.open()) {
         return false;
     }
+    std::atomic_store(&journalWriter, std::make_shared<JournalWriter>(journal, options.durability,
+                                                                      options.groupCommitWindow,
+                                                                      options.asyncFlushInterval,
+                                                                      options.maxBatchRecords));
+
+    // Fold a leftover rotated segment into the snapshot before it can be rotated over
+    if (hadRotated && !saveEmployeesLocked()) {
+        return false;
+    }
+    return snapshotLoaded;
 }
 
 bool EmployeeAPI::saveEmployees() {
-    Logger::get()->info("Saving {} employees to {}", employees.size(), dataFilePath);
+    auto locks = employees.lockAll();
+    return saveEmployeesLocked();
+}
+
+bool EmployeeAPI::saveEmployeesLocked() {
+    auto view = currentEmployees();
+    Logger::get()->info("Saving {} employees to {}", view->size(), dataFilePath);
+    waitForCompaction();
+    if (!journalWriter) {
+        return false;
+    }
+
+    // Records queued before the rotation marker are covered by this snapshot. A
+    // leftover rotated segment must not be rotated over before the snapshot lands,
+    // so in that case rotate afterwards instead; writers wait on their shard meanwhile.
+    std::uint64_t marker = journal.hasRotated() ? 0 : journalWriter->rotate();
+
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    bool ok = writeSnapshotFile(*view, error);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    recordSnapshot(ok, static_cast<std::uint64_t>(millis), 0, 0);
+
+    if (!ok) {
+        Logger::get()->error("Error saving employees: {}", error);
+        return false;
+    }
+    if (!finishCompaction(marker)) {
+        return false;
+    }
+
+    Logger::get()->info("Successfully saved {} employees to {}", view->size(), dataFilePath);
+    return true;
+}
+
+bool EmployeeAPI::compactJournal() {
+    auto locks = employees.lockAll();
+    return compactJournalLocked();
+}
+
+bool EmployeeAPI::compactJournalLocked() {
+    if (compactionRunning.load() || !journalWriter) {
+        return false;
+    }
+    waitForCompaction();
+
+    // A previous compaction failed before its snapshot landed; rotating again
+    // would overwrite that segment, so fold everything in synchronously instead
+    if (journal.hasRotated()) {
+        return saveEmployeesLocked();
+    }
+
+    // Records after the marker go to a fresh journal; the rotated segment is
+    // dropped only once the snapshot covering it has been renamed into place.
+    // With every shard locked, the view published when the marker is queued is
+    // exactly what it covers.
+    std::uint64_t marker = journalWriter->rotate();
+    auto view = employees.sharedView();
+
+    Logger::get()->info("Compacting journal into snapshot {} ({} employees)", dataFilePath, view->size());
+    compactionRunning.store(true);
+    if (options.forkSnapshots && startForkedSnapshot(*view, marker)) {
+        return true;
+    }
+
+    // Without fork, serialize the pinned version; writers publish new ones meanwhile
+    compactionThread = std::thread([this, marker, view]() {
+        Timer timer("compactJournal");
+        auto start = std::chrono::steady_clock::now();
+        std::string error;
+        bool ok = writeSnapshotFile(*view, error);
+        auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        recordSnapshot(ok, static_cast<std::uint64_t>(millis), 0, 0);
+
+        if (!ok) {
+            Logger::get()->error("Error compacting journal: {}", error);
+        } else if (finishCompaction(marker)) {
+            Logger::get()->info("Compaction finished, snapshot holds {} employees", view->size());
+        }
+        compactionRunning.store(false);
+    });
+    return true;
+}
+
+bool EmployeeAPI::startForkedSnapshot(const StoreView& view, std::uint64_t rotationMarker) {
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) != 0) {
+        Logger::get()->error("Could not create snapshot pipe: {}", std::strerror(errno));
+        return false;
+    }
+
+    pid_t pid = ::fork();
+    if (pid < 0) {
+        Logger::get()->error("Could not fork snapshot child: {}", std::strerror(errno));
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        // Child: serialize its copy-on-write view of the table, report back and
+        // leave without running destructors. Nothing here may log or take locks
+        // another parent thread could have been holding at fork time.
+        ::close(fds[0]);
+        ChildSnapshotResult result{};
+        auto start = std::chrono::steady_clock::now();
+        result.rssStartKb = readProcKb("/proc/self/status", "VmRSS");
+
+        std::string error;
+        result.ok = writeSnapshotFile(view, error) ? 1 : 0;
+
+        result.rssEndKb = readProcKb("/proc/self/status", "VmRSS");
+        result.copyOnWriteKb = readProcKb("/proc/self/smaps_rollup", "Private_Dirty");
+        result.durationMillis = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        std::strncpy(result.error, error.c_str(), sizeof(result.error) - 1);
+
+        ssize_t written = ::write(fds[1], &result, sizeof(result));
+        ::_exit(written == static_cast<ssize_t>(sizeof(result)) && result.ok ? 0 : 1);
+    }
+
+    ::close(fds[1]);
+    Logger::get()->info("Forked snapshot child {}", pid);
+
+    compactionThread = std::thread([this, pid, readFd = fds[0], rotationMarker]() {
+        ChildSnapshotResult result{};
+        size_t received = 0;
+        while (received < sizeof(result)) {
+            ssize_t n = ::read(readFd, reinterpret_cast<char*>(&result) + received, sizeof(result) - received);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            received += static_cast<size_t>(n);
+        }
+        ::close(readFd);
+
+        int status = 0;
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+
+        bool ok = received == sizeof(result) && result.ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        std::uint64_t rssGrowthKb = result.rssEndKb > result.rssStartKb ? result.rssEndKb - result.rssStartKb : 0;
+        recordSnapshot(ok, result.durationMillis, rssGrowthKb, result.copyOnWriteKb);
+
+        if (!ok) {
+            Logger::get()->error("Snapshot child {} failed: {}", pid,
+                                 received == sizeof(result) ? result.error : "exited without reporting");
+        } else if (finishCompaction(rotationMarker)) {
+            Logger::get()->info("Snapshot child {} finished in {} ms (RSS +{} kB, copy-on-write {} kB)",
+                                pid, result.durationMillis, rssGrowthKb, result.copyOnWriteKb);
+        }
+        compactionRunning.store(false);
+    });
+    return true;
+}
+
+bool EmployeeAPI::writeSnapshotFile(const StoreView& view, std::string& error) const {
+    return Snapshot::write(dataFilePath, view.size(), [&view](const EmployeeVisitor& visit) {
+        for (const auto& table : view.shards) {
+            for (size_t row = 0; row < table->size(); row++) {
+                visit(table->row(row));
+            }
+        }
+    }, error);
+}
+
+bool EmployeeAPI::finishCompaction(std::uint64_t rotationMarker) {
+    if (rotationMarker == 0) {
+        rotationMarker = journalWriter->rotate();
+    }
+    return journalWriter->waitFor(rotationMarker) && journal.removeRotated();
+}
+
+void EmployeeAPI::recordSnapshot(bool ok, std::uint64_t durationMillis, std::uint64_t rssGrowthKb,
+                                 std::uint64_t copyOnWriteKb) {
+    std::lock_guard<std::mutex> lock(snapshotStatsMutex);
+    if (ok) {
+        snapshotStats.completed++;
+        snapshotStats.lastSuccessUnix = unixNow();
+    } else {
+        snapshotStats.failed++;
+    }
+    snapshotStats.lastDurationMillis = durationMillis;
+    snapshotStats.lastRssGrowthKb = rssGrowthKb;
+    snapshotStats.lastCopyOnWriteKb = copyOnWriteKb;
+}
+
+SnapshotStats EmployeeAPI::getSnapshotStats() const {
+    std::lock_guard<std::mutex> lock(snapshotStatsMutex);
+    SnapshotStats stats = snapshotStats;
+    stats.running = compactionRunning.load();
+    return stats;
+}
+
+MutationStats EmployeeAPI::getMutationStats() const {
+    return mutations.stats();
+}
+
+PersistenceStats EmployeeAPI::getPersistenceStats() const {
+    auto writer = std::atomic_load(&journalWriter);
+    return writer ? writer->stats() : PersistenceStats();
+}
+
+void EmployeeAPI::waitForCompaction() {
+    if (compactionThread.joinable()) {
+        compactionThread.join();
+    }
+}
+
+void EmployeeAPI::applyJournalRecord(std::vector<std::shared_ptr<EmployeeTable>>& shards,
+                                     const std::string& record) {
     try {
-        json jsonData;
-        json employeesArray = json::array();
-        
-        for (const auto& pair : employees) {
-            const Employee& emp = pair.second;
-            json employeeObj;
-            employeeObj["id"] = emp.getId();
-            employeeObj["employee_name"] = emp.getName();
-            employeeObj["employee_salary"] = emp.getSalary();
-            employeeObj["employee_age"] = emp.getAge();
-            employeeObj["employee_title"] = emp.getTitle();
-            employeeObj["employee_email"] = emp.getEmail();
-            
-            employeesArray.push_back(employeeObj);
-        }
-        
-        jsonData["data"] = employeesArray;
-        Logger::get()->debug("Created JSON with {} employee records", employeesArray.size());
-        
-        std::ofstream file(dataFilePath);
-        if (!file.is_open()) {
-            Logger::get()->error("Could not open file for writing: {}", dataFilePath);
-            return false;
+        json entry = json::parse(record);
+        const std::string op = entry.at("op").get<std::string>();
+        if (op == "put") {
+            Employee employee = Snapshot::employeeFromJson(entry.at("data"));
+            shards[employees.shardOf(employee.getId())]->upsert(employee);
+        } else if (op == "delete") {
+            std::string id = entry.at("id").get<std::string>();
+            shards[employees.shardOf(id)]->erase(id);
+        } else {
+            Logger::get()->warn("Skipping journal record with unknown op: {}", op);
         }
-        
-        file << jsonData.dump(4);  // Pretty print with 4 spaces indentation
-        file.close();
-        
-        Logger::get()->info("Successfully saved {} employees to {}", employees.size(), dataFilePath);
-        return true;
     } catch (const std::exception& e) {
-        Logger::get()->error("Error saving employees: {}", e.what());
+        // A torn final line after a crash is expected; skip it
+        Logger::get()->warn("Failed to parse journal record: {}", e.what());
+    }
+}
+
+PinnedView EmployeeAPI::currentEmployees() const {
+    return employees.view();
+}
+
+std::future<MutationResult> EmployeeAPI::submit(Mutation mutation) {
+    return mutations.push(std::move(mutation));
+}
+
+void EmployeeAPI::runWriter() {
+    std::vector<Mutation> batch;
+    while (mutations.popBatch(batch, options.maxMutationBatch)) {
+        applyBatch(batch);
+        compactIfDue();
+    }
+}
+
+void EmployeeAPI::applyBatch(std::vector<Mutation>& batch) {
+    // Explicit numeric ids raise the counter first, so the ids handed out next
+    // cannot collide with anything stored or queued
+    for (const auto& mutation : batch) {
+        if (mutation.kind == Mutation::Kind::Add) {
+            noteNumericId(mutation.employee.getId());
+        }
+    }
+    for (auto& mutation : batch) {
+        if (mutation.kind == Mutation::Kind::AddWithNextId) {
+            mutation.employee.setId(std::to_string(nextNumericId.fetch_add(1)));
+        }
+    }
+
+    // Lock the shards the batch touches, in index order like lockAll()
+    size_t shardCount = employees.shardCount();
+    std::vector<size_t> shardOf(batch.size());
+    std::vector<bool> touched(shardCount, false);
+    for (size_t i = 0; i < batch.size(); i++) {
+        const Mutation& mutation = batch[i];
+        if (mutation.handle) {
+            shardOf[i] = mutation.handle->shard;
+        } else {
+            shardOf[i] = employees.shardOf(mutation.kind == Mutation::Kind::Delete ? mutation.id
+                                                                                  : mutation.employee.getId());
+        }
+        if (shardOf[i] < shardCount) {
+            touched[shardOf[i]] = true;
+        }
+    }
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (size_t shard = 0; shard < shardCount; shard++) {
+        if (touched[shard]) {
+            locks.emplace_back(employees.shardMutex(shard));
+        }
+    }
+
+    // Apply in order to private copies, copying each shard at most once per batch
+    auto view = currentEmployees();
+    std::vector<std::shared_ptr<EmployeeTable>> working(shardCount);
+    auto writable = [&](size_t shard) -> EmployeeTable& {
+        if (!working[shard]) {
+            working[shard] = std::make_shared<EmployeeTable>(*view->shards[shard]);
+        }
+        return *working[shard];
+    };
+
+    // Unique indexes are per shard, so a key has to be checked against all of
+    // them; the single writer makes check and write atomic
+    auto conflicts = [&](const Employee& employee, MutationResult& result) {
+        for (size_t shard = 0; shard < shardCount; shard++) {
+            const EmployeeTable& table = working[shard] ? *working[shard] : *view->shards[shard];
+            if (const SecondaryIndexBase* index = table.uniqueConflict(employee)) {
+                Logger::get()->warn("Employee {} conflicts on unique index {}", employee.getId(), index->name());
+                result.status = MutationStatus::Conflict;
+                result.conflict = index->name();
+                return true;
+            }
+        }
         return false;
+    };
+
+    std::vector<MutationResult> results(batch.size());
+    std::vector<std::string> records(batch.size());  // empty when nothing changed
+    for (size_t i = 0; i < batch.size(); i++) {
+        Mutation& mutation = batch[i];
+        MutationResult& result = results[i];
+        size_t shard = shardOf[i];
+        if (shard >= shardCount) {
+            result.status = MutationStatus::NotFound;
+            continue;
+        }
+        const EmployeeTable& table = working[shard] ? *working[shard] : *view->shards[shard];
+
+        switch (mutation.kind) {
+            case Mutation::Kind::Add:
+            case Mutation::Kind::AddWithNextId:
+                result.id = mutation.employee.getId();
+                if (table.contains(result.id)) {
+                    result.status = MutationStatus::AlreadyExists;
+                    break;
+                }
+                if (conflicts(mutation.employee, result)) {
+                    break;
+                }
+                writable(shard).upsert(mutation.employee);
+                records[i] = putRecord(mutation.employee);
+                break;
+
+            case Mutation::Kind::Update: {
+                result.id = mutation.employee.getId();
+                auto row = mutation.handle ? table.rowOf(*mutation.handle) : table.findRow(result.id);
+                if (!row || table.idAt(*row) != EmployeeId::borrow(result.id)) {
+                    // Deleted since the handle was taken, or a different employee
+                    result.status = MutationStatus::NotFound;
+                    break;
+                }
+                if (conflicts(mutation.employee, result)) {
+                    break;
+                }
+                writable(shard).upsert(mutation.employee);
+                records[i] = putRecord(mutation.employee);
+                break;
+            }
+
+            case Mutation::Kind::Delete: {
+                auto row = mutation.handle ? table.rowOf(*mutation.handle) : table.findRow(mutation.id);
+                if (!row) {
+                    result.status = MutationStatus::NotFound;
+                    break;
+                }
+                result.id = table.idAt(*row).toString();
+                writable(shard).eraseRow(*row);
+                records[i] = deleteRecord(result.id);
+                break;
+            }
+        }
+    }
+
+    // Publish the changed shards together and queue the records in batch order
+    // while the shards are still locked
+    std::vector<std::pair<size_t, std::shared_ptr<const EmployeeTable>>> changed;
+    for (size_t shard = 0; shard < shardCount; shard++) {
+        if (working[shard]) {
+            changed.emplace_back(shard, std::move(working[shard]));
+        }
+    }
+    if (!changed.empty()) {
+        employees.publish(changed);
+    }
+
+    auto writer = std::atomic_load(&journalWriter);
+    std::vector<std::uint64_t> seqs(batch.size(), 0);
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (!records[i].empty() && writer) {
+            seqs[i] = writer->queue(records[i]);
+        }
+    }
+    locks.clear();
+
+    // Waiting for the last record covers the whole batch; the rest answer at once
+    for (size_t i = batch.size(); i-- > 0;) {
+        if (!records[i].empty() && (seqs[i] == 0 || !writer->acknowledge(seqs[i]))) {
+            results[i].status = MutationStatus::NotDurable;
+        }
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+        batch[i].done.set_value(std::move(results[i]));
+    }
+}
+
+void EmployeeAPI::compactIfDue() {
+    auto writer = std::atomic_load(&journalWriter);
+    if (writer && writer->activeJournalBytes() >= options.compactionThresholdBytes && !compactionRunning.load()) {
+        compactJournal();
+    }
+}
+
+void EmployeeAPI::noteNumericId(const std::string& id) {
+    EmployeeId parsed = EmployeeId::borrow(id);
+    if (!parsed.isNumber()) {
+        return;
+    }
+    std::uint64_t next = parsed.number() + 1;
+    std::uint64_t current = nextNumericId.load();
+    while (current < next && !nextNumericId.compare_exchange_weak(current, next)) {
     }
 }
 
 std::vector<Employee> EmployeeAPI::getAllEmployees() const {
-    Logger::get()->debug("Getting all employees, count: {}", employees.size());
+    auto view = currentEmployees();
+    Logger::get()->debug("Getting all employees, count: {}", view->size());
     
     std::vector<Employee> result;
-    for (const auto& pair : employees) {
-        result.push_back(pair.second);
+    result.reserve(view->size());
+    for (const auto& table : view->shards) {
+        for (size_t row = 0; row < table->size(); row++) {
+            result.push_back(table->row(row));
+        }
     }
     return result;
 }
 
-Employee* EmployeeAPI::getEmployeeById(const std::string& id) {
+std::optional<Employee> EmployeeAPI::getEmployeeById(std::string_view id) const {
+    auto view = currentEmployees();
     Logger::get()->debug("Looking up employee with ID: {}", id);
     
-    auto it = employees.find(id);
-    if (it != employees.end()) {
-        Logger::get()->debug("Found employee: {} ({})", it->second.getName(), id);
-        return &(it->second);
+    const auto& table = view->shards[view->shardOf(id)];
+    auto row = table->findRow(id);
+    if (row) {
+        Logger::get()->debug("Found employee: {} ({})", table->nameColumn()[*row], id);
+        return table->row(*row);
     }
     
     Logger::get()->debug("Employee with ID {} not found", id);
-    return nullptr;
+    return std::nullopt;
+}
+
+std::optional<Employee> EmployeeAPI::getEmployeeByEmail(std::string_view email) const {
+    auto view = currentEmployees();
+    Logger::get()->debug("Looking up employee with email: {}", email);
+
+    // Shards are split by id, so the email may be in any of them: one probe each
+    std::string folded = TrigramIndex::fold(email);
+    for (const auto& table : view->shards) {
+        if (auto slot = table->index<EmailIndex>()->entries().findAny(folded)) {
+            return table->row(table->rowOfSlot(*slot));
+        }
+    }
+
+    Logger::get()->debug("Employee with email {} not found", email);
+    return std::nullopt;
 }
 
 std::vector<Employee> EmployeeAPI::getEmployeesByName(const std::string& name) const {
+    auto view = currentEmployees();
     Logger::get()->debug("Searching for employees with name containing: '{}'", name);
     
     std::vector<Employee> result;
-    
-    for (const auto& pair : employees) {
-        const Employee& emp = pair.second;
-        // Case-insensitive substring search
-        std::string empName = emp.getName();
-        std::string searchName = name;
-      
-        // Convert both strings to lowercase for case-insensitive comparison
-        std::transform(empName.begin(), empName.end(), empName.begin(), ::tolower);
-        std::transform(searchName.begin(), searchName.end(), searchName.begin(), ::tolower);
-        
-        if (empName.find(searchName) != std::string::npos) {
-            Logger::get()->trace("Match found: {} (ID: {})", emp.getName(), emp.getId());
-            result.push_back(emp);
+    for (const auto& table : view->shards) {
+        for (size_t row : table->rowsWithNameContaining(name)) {
+            Logger::get()->trace("Match found: {} (ID: {})", table->nameColumn()[row], table->idAt(row).toString());
+            result.push_back(table->row(row));
         }
     }
     
@@ -146,101 +706,325 @@ std::vector<Employee> EmployeeAPI::getEmployeesByName(const std::string& name) c
     return result;
 }
 
-bool EmployeeAPI::addEmployee(const Employee& employee) {
-    std::string id = employee.getId();
-    if (employees.find(id) != employees.end()) {
-        return false;  // Employee with this ID already exists
+std::vector<FuzzyMatch> EmployeeAPI::getEmployeesByNameFuzzy(std::string_view name, int maxEdits) const {
+    auto view = currentEmployees();
+    Logger::get()->debug("Fuzzy searching for employees with name: '{}' within {} edits", name, maxEdits);
+
+    std::vector<LevenshteinAutomaton> automata;
+    for (const auto& word : NameTermsField::termsOf(name)) {
+        automata.emplace_back(word, maxEdits);
     }
-    
-    employees[id] = employee;
-    return saveEmployees();
+    std::vector<FuzzyMatch> result;
+    if (automata.empty()) {
+        return result;
+    }
+
+    for (const auto& table : view->shards) {
+        const PrefixDictionary& terms = table->index<NameTermsIndex>()->entries();
+        // The name words within reach of each query word, and how many
+        // employees have one of them. Entries of rare words are counted on the
+        // way past; common ones are counted by whole blocks.
+        std::vector<std::unordered_map<std::string, int>> reachable(automata.size());
+        size_t driving = 0;
+        size_t fewest = std::numeric_limits<size_t>::max();
+        for (size_t i = 0; i < automata.size(); i++) {
+            size_t postings = 0;
+            automata[i].matches(terms, [&](const std::string& term, int edits, PrefixDictionary::Cursor& entries) {
+                reachable[i].emplace(term, edits);
+                size_t walked = 0;
+                for (; walked < kFuzzyWalkedEntries && !entries.done() && entries.key() == term; walked++) {
+                    entries.next();
+                }
+                postings += walked < kFuzzyWalkedEntries ? walked : terms.count(term);
+            });
+            if (postings < fewest) {
+                fewest = postings;
+                driving = i;
+            }
+        }
+        if (fewest == 0) {
+            continue;
+        }
+
+        // Employees reached by the rarest query word are the candidates; the
+        // other words are checked against their name words by lookup
+        std::vector<std::uint32_t> candidates;
+        candidates.reserve(fewest);
+        automata[driving].matches(terms, [&candidates](const std::string& term, int, PrefixDictionary::Cursor& entries) {
+            for (; !entries.done() && entries.key() == term; entries.next()) {
+                candidates.push_back(entries.slot());
+            }
+        });
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        for (std::uint32_t slot : candidates) {
+            size_t row = table->rowOfSlot(slot);
+            auto nameTerms = NameTermsField::termsOf(table->fieldsAt(row).name);
+            int total = 0;
+            for (const auto& words : reachable) {
+                int best = std::numeric_limits<int>::max();
+                for (const auto& term : nameTerms) {
+                    auto found = words.find(term);
+                    if (found != words.end()) {
+                        best = std::min(best, found->second);
+                    }
+                }
+                if (best == std::numeric_limits<int>::max()) {
+                    total = -1;
+                    break;
+                }
+                total += best;
+            }
+            if (total >= 0) {
+                result.push_back(FuzzyMatch{table->row(row), total});
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        if (a.edits != b.edits) {
+            return a.edits < b.edits;
+        }
+        if (a.employee.getName() != b.employee.getName()) {
+            return a.employee.getName() < b.employee.getName();
+        }
+        return a.employee.getId() < b.employee.getId();
+    });
+    Logger::get()->debug("Found {} employees within {} edits of name: '{}'", result.size(), maxEdits, name);
+    return result;
 }
 
-bool EmployeeAPI::updateEmployee(const Employee& employee) {
-    std::string id = employee.getId();
-    if (employees.find(id) == employees.end()) {
-        return false;  // Employee with this ID doesn't exist
+std::string EmployeeAPI::nextEmployeeId() const {
+    return std::to_string(nextNumericId.load());
+}
+
+std::optional<EmployeeHandle> EmployeeAPI::findEmployee(std::string_view id) const {
+    auto view = currentEmployees();
+    size_t shard = view->shardOf(id);
+    auto row = view->shards[shard]->findRow(id);
+    if (!row) {
+        return std::nullopt;
     }
-    
-    employees[id] = employee;
-    return saveEmployees();
+    EmployeeHandle handle = view->shards[shard]->handleAt(*row);
+    handle.shard = static_cast<std::uint32_t>(shard);
+    return handle;
 }
 
-bool EmployeeAPI::deleteEmployee(const std::string& id) {
-    auto it = employees.find(id);
-    if (it == employees.end()) {
-        return false;  // Employee with this ID doesn't exist
+std::optional<Employee> EmployeeAPI::getEmployee(EmployeeHandle handle) const {
+    auto view = currentEmployees();
+    if (handle.shard >= view->shards.size()) {
+        return std::nullopt;
     }
-    
-    employees.erase(it);
-    return saveEmployees();
+    const auto& table = view->shards[handle.shard];
+    auto row = table->rowOf(handle);
+    if (!row) {
+        return std::nullopt;
+    }
+    return table->row(*row);
+}
+
+bool EmployeeAPI::addEmployee(const Employee& employee) {
+    return submit(Mutation::add(employee)).get().status == MutationStatus::Ok;
+}
+
+bool EmployeeAPI::addEmployeeWithNextId(Employee& employee) {
+    MutationResult result = submit(Mutation::addWithNextId(employee)).get();
+    employee.setId(result.id);
+    return result.status == MutationStatus::Ok;
+}
+
+bool EmployeeAPI::updateEmployee(const Employee& employee) {
+    return submit(Mutation::update(employee)).get().status == MutationStatus::Ok;
+}
+
+bool EmployeeAPI::updateEmployee(EmployeeHandle handle, const Employee& employee) {
+    return submit(Mutation::update(handle, employee)).get().status == MutationStatus::Ok;
+}
+
+bool EmployeeAPI::deleteEmployee(const std::string& id) {
+    return submit(Mutation::remove(id)).get().status == MutationStatus::Ok;
+}
+
+bool EmployeeAPI::deleteEmployee(EmployeeHandle handle) {
+    return submit(Mutation::remove(handle)).get().status == MutationStatus::Ok;
 }
 
 int EmployeeAPI::getHighestSalaryOfEmployees() const {
-    int highestSalary = 0;
-    
-    for (const auto& [id, employee] : employees) {
-        try {
-            int salary = std::stoi(employee.getSalary());
-            if (salary > highestSalary) {
-                highestSalary = salary;
-            }
-        } catch (const std::exception& e) {
-            // Skip if salary is not a valid integer
+    auto view = currentEmployees();
+    // Each shard's salary index keeps its highest salary at hand
+    std::int32_t highestSalary = 0;
+    for (const auto& table : view->shards) {
+        if (const std::int32_t* last = salariesOf(*table).last()) {
+            highestSalary = std::max(highestSalary, *last);
         }
     }
-    
     return highestSalary;
 }
 
 std::vector<Employee> EmployeeAPI::getTop10HighestEarningEmployees() const {
-    // Create a vector of employees for sorting
-    std::vector<std::pair<std::string, int>> employeesWithSalary;
-    
-    // Convert salary strings to integers for sorting
-    for (const auto& [id, employee] : employees) {
-        try {
-            int salary = std::stoi(employee.getSalary());
-            employeesWithSalary.push_back({employee.getId(), salary});
-        } catch (const std::exception& e) {
-            // Skip if salary is not a valid integer
-        }
+    return getTopEarners(10);
+}
+
+std::vector<Employee> EmployeeAPI::getTopEarners(size_t k) const {
+    auto view = currentEmployees();
+
+    // Merge the shards' salary indexes from the top, taking the earlier shard on ties
+    std::vector<SalaryIndex::Tree::Cursor> walks;
+    walks.reserve(view->shards.size());
+    for (const auto& table : view->shards) {
+        walks.push_back(salariesOf(*table).descending());
     }
-    
-    // Sort employees by salary in descending order
-    std::sort(employeesWithSalary.begin(), employeesWithSalary.end(), 
-              [](const auto& a, const auto& b) {
-                  return a.second > b.second;
-              });
-    
-    // Get the top 10 (or less if there aren't 10 employees)
+
     std::vector<Employee> topEmployees;
-    int count = std::min(10, static_cast<int>(employeesWithSalary.size()));
-    
-    for (int i = 0; i < count; i++) {
-        topEmployees.push_back(employees.at(employeesWithSalary[i].first));
+    while (topEmployees.size() < k) {
+        size_t best = walks.size();
+        for (size_t shard = 0; shard < walks.size(); shard++) {
+            if (!walks[shard].done() &&
+                (best == walks.size() || walks[shard].key() > walks[best].key())) {
+                best = shard;
+            }
+        }
+        if (best == walks.size()) {
+            break;
+        }
+        const auto& table = view->shards[best];
+        topEmployees.push_back(table->row(table->rowOfSlot(walks[best].slot())));
+        walks[best].next();
     }
-    
     return topEmployees;
 }
 
+std::optional<SalaryRank> EmployeeAPI::getSalaryRank(std::string_view id) const {
+    auto view = currentEmployees();
+    const auto& home = view->shards[view->shardOf(id)];
+    auto row = home->findRow(id);
+    if (!row || home->salaryColumn()[*row] == kNotNumeric) {
+        return std::nullopt;
+    }
+
+    SalaryRank rank;
+    rank.salary = home->salaryColumn()[*row];
+    rank.rank = 1;
+    for (const auto& table : view->shards) {
+        const auto& salaries = salariesOf(*table);
+        rank.rank += salaries.size() - salaries.countUpTo(rank.salary);
+        rank.total += salaries.size();
+    }
+    return rank;
+}
+
+std::optional<std::int32_t> EmployeeAPI::getSalaryAtPercentile(double percentile) const {
+    auto view = currentEmployees();
+    std::uint64_t total = 0;
+    std::int64_t low = std::numeric_limits<std::int32_t>::max();
+    std::int64_t high = std::numeric_limits<std::int32_t>::min();
+    for (const auto& table : view->shards) {
+        const auto& salaries = salariesOf(*table);
+        if (!salaries.empty()) {
+            total += salaries.size();
+            low = std::min<std::int64_t>(low, *salaries.first());
+            high = std::max<std::int64_t>(high, *salaries.last());
+        }
+    }
+    if (total == 0) {
+        return std::nullopt;
+    }
+
+    // Nearest rank, counted from the lowest salary
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * total)));
+    rank = std::min(rank, total);
+    if (view->shards.size() == 1) {
+        return *salariesOf(*view->shards.front()).keyAt(rank - 1);
+    }
+
+    // Across shards, binary search for the lowest salary with rank entries at or below it
+    while (low < high) {
+        std::int64_t middle = low + (high - low) / 2;
+        std::uint64_t atMost = 0;
+        for (const auto& table : view->shards) {
+            atMost += salariesOf(*table).countUpTo(static_cast<std::int32_t>(middle));
+        }
+        if (atMost >= rank) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return static_cast<std::int32_t>(low);
+}
+
+std::optional<RangeResult> EmployeeAPI::getEmployeesInRange(std::string_view field, std::int32_t min,
+                                                            std::int32_t max, size_t limit) const {
+    auto view = currentEmployees();
+    if (field == SalaryField::kName) {
+        return rangeOf<SalaryIndex>(*view, min, max, limit);
+    }
+    if (field == AgeField::kName) {
+        return rangeOf<AgeIndex>(*view, min, max, limit);
+    }
+    return std::nullopt;
+}
+
+std::vector<Completion> EmployeeAPI::getCompletions(std::string_view prefix, size_t limit) const {
+    auto view = currentEmployees();
+    std::string folded = TrigramIndex::fold(prefix);
+
+    // Merge the name and email walks of every shard from the prefix on;
+    // O(log n + limit) per walk
+    std::vector<CompletionWalk> walks;
+    walks.reserve(2 * view->shards.size());
+    for (size_t shard = 0; shard < view->shards.size(); shard++) {
+        const auto& table = view->shards[shard];
+        walks.push_back(CompletionWalk{table->index<NamePrefixIndex>()->entries().ascendingFrom(folded), shard, true});
+        walks.push_back(CompletionWalk{table->index<EmailPrefixIndex>()->entries().ascendingFrom(folded), shard, false});
+    }
+    auto matches = [&folded](const CompletionWalk& walk) {
+        return !walk.cursor.done() && walk.cursor.key().compare(0, folded.size(), folded) == 0;
+    };
+
+    std::vector<Completion> result;
+    while (result.size() < limit) {
+        size_t best = walks.size();
+        for (size_t i = 0; i < walks.size(); i++) {
+            if (matches(walks[i]) && (best == walks.size() || walks[i].cursor.key() < walks[best].cursor.key())) {
+                best = i;
+            }
+        }
+        if (best == walks.size()) {
+            break;
+        }
+        const CompletionWalk& walk = walks[best];
+        const auto& table = view->shards[walk.shard];
+        size_t row = table->rowOfSlot(walk.cursor.slot());
+        EmployeeFields fields = table->fieldsAt(row);
+        result.push_back(Completion{std::string(walk.isName ? fields.name : fields.email),
+                                    walk.isName ? NameField::kName : EmailField::kName,
+                                    table->idAt(row).toString()});
+        walks[best].cursor.next();
+    }
+    return result;
+}
+
 std::vector<Employee> EmployeeAPI::getEmployeesByTitle(const std::string& title) const {
+    auto view = currentEmployees();
+    // Case-insensitive substring search over the distinct titles only
     std::vector<Employee> result;
-
-    for (const auto& pair : employees) {
-        const Employee& emp = pair.second;
-        // Case-insensitive substring search
-        std::string empTitle = emp.getTitle();
-        std::string searchTtile = title;
-      
-        // Convert both strings to lowercase for case-insensitive comparison
-        std::transform(empTitle.begin(), empTitle.end(), empTitle.begin(), ::tolower);
-        std::transform(searchTtile.begin(), searchTtile.end(), searchTtile.begin(), ::tolower);
-        
-        if (empTitle.find(searchTtile) != std::string::npos) {
-            result.push_back(emp);
+    for (const auto& table : view->shards) {
+        for (std::uint32_t row : table->titles().rowsContaining(title)) {
+            result.push_back(table->row(row));
         }
     }
     
     return result;
 }
+
+QueryResult EmployeeAPI::query(const Filter& filter, size_t limit) const {
+    auto view = currentEmployees();
+    QueryResult result = runQuery(*view, filter, limit);
+    Logger::get()->debug("Query {} drove {} ({} rows estimated, {} examined), {} matched", filter.describe(),
+                         accessPathName(result.plan.driver.path), result.plan.driver.estimatedRows,
+                         result.rowsExamined, result.total);
+    return result;
+}
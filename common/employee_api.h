@@ -1,40 +1,197 @@
 #ifndef EMPLOYEE_API_H
 #define EMPLOYEE_API_H
 
-#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
 #include <string>
+#include <string_view>
 #include "employee.h"
+#include "employee_query.h"
+#include "employee_store.h"
+#include "employee_table.h"
+#include "journal.h"
+#include "journal_writer.h"
+#include "mutation_queue.h"
 
+struct PersistenceOptions {
+    // Fold the journal into a fresh snapshot once it grows past this many bytes
+    std::uintmax_t compactionThresholdBytes = 4 * 1024 * 1024;
+
+    // Group commit: how long to gather writes (group) or the flush deadline (async)
+    DurabilityMode durability = DurabilityMode::Group;
+    std::chrono::milliseconds groupCommitWindow{2};
+    std::chrono::milliseconds asyncFlushInterval{10};
+    size_t maxBatchRecords = 1024;
+
+    // Most mutations the writer thread applies and journals as one batch
+    size_t maxMutationBatch = 1024;
+
+    // Write compaction snapshots from a forked child (copy-on-write view of the
+    // store) instead of copying every employee on the calling thread
+    bool forkSnapshots = true;
+};
+
+struct SnapshotStats {
+    bool running = false;
+    std::uint64_t completed = 0;
+    std::uint64_t failed = 0;
+    std::uint64_t lastDurationMillis = 0;
+    std::uint64_t lastRssGrowthKb = 0;      // child VmRSS growth while writing
+    std::uint64_t lastCopyOnWriteKb = 0;    // child Private_Dirty when done
+    std::int64_t lastSuccessUnix = 0;       // seconds since the epoch, 0 if never
+};
+
+// Where one employee's salary stands among all numeric salaries
+struct SalaryRank {
+    std::int32_t salary = 0;
+    std::uint64_t rank = 0;   // 1 + employees earning strictly more, so ties share a rank
+    std::uint64_t total = 0;  // employees with a numeric salary
+};
+
+// One page of employees whose field lies in a range
+struct RangeResult {
+    std::vector<Employee> employees;  // lowest key first, at most the limit
+    std::uint64_t total = 0;          // all employees in the range
+};
+
+// A name or email starting with an autocomplete prefix
+struct Completion {
+    std::string value;  // as stored, not case-folded
+    const char* field;  // "name" or "email"
+    std::string id;
+};
+
+// An employee whose name is within a few edits of a fuzzy query
+struct FuzzyMatch {
+    Employee employee;
+    int edits;  // summed over the words of the query
+};
+
+// Thread-safe: readers pin the current version of the store and never block.
+// Every add, update and delete is queued to a single writer thread, which takes
+// them in batches, applies a batch to copies of the shards it touches, publishes
+// them together and journals the batch with one commit before completing the
+// callers' futures.
 class EmployeeAPI {
 private:
-    std::unordered_map<std::string, Employee> employees;
+    // Versions are freed once the last reader pinning them lets go
+    EmployeeStore employees;
+    std::atomic<std::uint64_t> nextNumericId;  // next id for POST without one
+    MutationQueue mutations;
+    std::thread writerThread;
     std::string dataFilePath;
+    PersistenceOptions options;
+    Journal journal;
+    std::shared_ptr<JournalWriter> journalWriter;  // replaced with every shard locked
+    std::thread compactionThread;
+    std::atomic<bool> compactionRunning;
+    mutable std::mutex snapshotStatsMutex;
+    SnapshotStats snapshotStats;
+
+    PinnedView currentEmployees() const;
+
+    // Writer thread: apply queued mutations batch by batch
+    void runWriter();
+    void applyBatch(std::vector<Mutation>& batch);
+
+    // Start a compaction once the journal has grown past the threshold
+    void compactIfDue();
+
+    // Keep the next generated id above a numeric id that was just stored
+    void noteNumericId(const std::string& id);
+
+    void applyJournalRecord(std::vector<std::shared_ptr<EmployeeTable>>& shards, const std::string& record);
+
+    // Whole-store operations, called with every shard locked
+    bool saveEmployeesLocked();
+    bool compactJournalLocked();
+
+    bool writeSnapshotFile(const StoreView& view, std::string& error) const;
+    bool startForkedSnapshot(const StoreView& view, std::uint64_t rotationMarker);
+    bool finishCompaction(std::uint64_t rotationMarker);
+    void recordSnapshot(bool ok, std::uint64_t durationMillis, std::uint64_t rssGrowthKb, std::uint64_t copyOnWriteKb);
+    void waitForCompaction();
 
 public:
-    EmployeeAPI(const std::string& dataFilePath);
+    EmployeeAPI(const std::string& dataFilePath, const PersistenceOptions& options = PersistenceOptions(),
+                size_t shardCount = kDefaultShardCount);
+    ~EmployeeAPI();
     
     // API methods
     bool loadEmployees();
     bool saveEmployees();
+
+    // Rotate the journal and rewrite the snapshot in the background (BGSAVE);
+    // returns false if a compaction is already running
+    bool compactJournal();
+
+    // Batch size and commit latency counters of the journal writer
+    PersistenceStats getPersistenceStats() const;
+
+    // Duration, memory and outcome of the most recent snapshot
+    SnapshotStats getSnapshotStats() const;
+
+    // Batch counters of the writer thread
+    MutationStats getMutationStats() const;
+
+    // Queue a mutation for the writer thread; the future completes once it has
+    // been applied and journaled as durably as configured. The bool methods
+    // below submit one and wait for it.
+    std::future<MutationResult> submit(Mutation mutation);
     
     // Get all employees
     std::vector<Employee> getAllEmployees() const;
     
     // Get employee by ID
-    Employee* getEmployeeById(const std::string& id);
+    std::optional<Employee> getEmployeeById(std::string_view id) const;
+
+    // Stable handle to an employee for a later read-modify-write; unlike a
+    // row number it survives other records being erased
+    std::optional<EmployeeHandle> findEmployee(std::string_view id) const;
+
+    // Copy of the employee behind a handle, nothing once it has been deleted
+    std::optional<Employee> getEmployee(EmployeeHandle handle) const;
+
+    // The employee with this email, ignoring case; emails are unique
+    std::optional<Employee> getEmployeeByEmail(std::string_view email) const;
 
     // Get employee by name
     std::vector<Employee> getEmployeesByName(const std::string& name) const;
+
+    // Employees with a name word within maxEdits edits of every word of
+    // name, ignoring case, fewest total edits first, then by name. maxEdits
+    // is clamped to [0, LevenshteinAutomaton::kMaxEdits].
+    std::vector<FuzzyMatch> getEmployeesByNameFuzzy(std::string_view name, int maxEdits) const;
     
+    // Next free numeric id (one above the largest numeric id seen); UUID and
+    // other text ids do not take part
+    std::string nextEmployeeId() const;
+
     // Add new employee
     bool addEmployee(const Employee& employee);
+
+    // Add a new employee under the next free numeric id, handed out by the
+    // writer thread so concurrent adds cannot collide; sets the id on employee
+    bool addEmployeeWithNextId(Employee& employee);
     
     // Update employee
     bool updateEmployee(const Employee& employee);
+
+    // Update the employee behind a handle; fails if it has been deleted since
+    // the handle was taken or the id does not match
+    bool updateEmployee(EmployeeHandle handle, const Employee& employee);
     
     // Delete an employee by ID
     bool deleteEmployee(const std::string& id);
+
+    // Delete the employee behind a handle; fails if it is already gone
+    bool deleteEmployee(EmployeeHandle handle);
     
     // Get the highest salary amongst all employees
     int getHighestSalaryOfEmployees() const;
@@ -44,6 +201,34 @@ public:
     
     // Get the top 10 highest earning employees
     std::vector<Employee> getTop10HighestEarningEmployees() const;
+
+    // The k highest earners, best first; equal salaries come in shard order.
+    // Employees without a numeric salary are left out.
+    std::vector<Employee> getTopEarners(size_t k) const;
+
+    // Salary rank of an employee; nothing if the id is unknown or the salary
+    // is not numeric
+    std::optional<SalaryRank> getSalaryRank(std::string_view id) const;
+
+    // Nearest-rank percentile of the numeric salaries: the lowest salary that
+    // at least percentile% of employees earn no more than. Nothing without
+    // numeric salaries; percentile is clamped to [0, 100].
+    std::optional<std::int32_t> getSalaryAtPercentile(double percentile) const;
+
+    // Employees with min <= field <= max for a numeric field with an ordered
+    // index ("salary" or "age"), in key order with equal keys in shard order.
+    // Nothing if the field has no such index.
+    std::optional<RangeResult> getEmployeesInRange(std::string_view field, std::int32_t min, std::int32_t max,
+                                                   size_t limit) const;
+
+    // Up to limit names and emails starting with prefix, ignoring case, in
+    // case-folded order. An employee whose name and email both match appears
+    // once for each.
+    std::vector<Completion> getCompletions(std::string_view prefix, size_t limit) const;
+
+    // Employees passing filter, driven by whichever index or scan planQuery
+    // finds cheapest; up to limit of them, with the total and the plan
+    QueryResult query(const Filter& filter, size_t limit) const;
 };
 
 #endif // EMPLOYEE_API_H
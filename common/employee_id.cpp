@@ -0,0 +1,199 @@
+#include "employee_id.h"
+#include <cstring>
+#include <functional>
+#include <utility>
+
+namespace {
+
+// Nibble value of each lowercase hex digit, -1 for every other byte
+struct HexTable {
+    signed char values[256];
+
+    constexpr HexTable() : values() {
+        for (int c = 0; c < 256; c++) {
+            values[c] = -1;
+        }
+        for (int c = '0'; c <= '9'; c++) {
+            values[c] = static_cast<signed char>(c - '0');
+        }
+        for (int c = 'a'; c <= 'f'; c++) {
+            values[c] = static_cast<signed char>(c - 'a' + 10);
+        }
+    }
+};
+
+constexpr HexTable kHex;
+
+bool parseNumber(std::string_view text, std::uint64_t& number) {
+    if (text.empty() || text.size() > 19 || (text[0] == '0' && text.size() > 1)) {
+        return false;
+    }
+    number = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        number = number * 10 + static_cast<std::uint64_t>(c - '0');
+    }
+    return true;
+}
+
+// Position of each byte's two hex digits in the canonical 8-4-4-4-12 text
+constexpr unsigned char kUuidPairOffsets[16] = {0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34};
+
+bool parseUuid(std::string_view text, unsigned char* bytes) {
+    if (text.size() != 36 || text[8] != '-' || text[13] != '-' || text[18] != '-' || text[23] != '-') {
+        return false;
+    }
+
+    // Decode all 16 byte pairs, then check for invalid digits once
+    int invalid = 0;
+    for (size_t i = 0; i < 16; i++) {
+        int high = kHex.values[static_cast<unsigned char>(text[kUuidPairOffsets[i]])];
+        int low = kHex.values[static_cast<unsigned char>(text[kUuidPairOffsets[i] + 1])];
+        invalid |= high | low;
+        bytes[i] = static_cast<unsigned char>((high << 4) | (low & 0xF));
+    }
+    return invalid >= 0;
+}
+
+std::uint64_t mix64(std::uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    return x ^ (x >> 33);
+}
+
+} // namespace
+
+EmployeeId::EmployeeId() : length(0), idKind(Kind::Text) {
+    std::memset(&value, 0, sizeof(value));
+}
+
+EmployeeId::EmployeeId(const EmployeeId& other) : EmployeeId() {
+    copyFrom(other);
+}
+
+EmployeeId::EmployeeId(EmployeeId&& other) noexcept : value(other.value), length(other.length), idKind(other.idKind) {
+    other.idKind = Kind::Text;
+    other.length = 0;
+}
+
+EmployeeId& EmployeeId::operator=(const EmployeeId& other) {
+    if (this != &other) {
+        release();
+        copyFrom(other);
+    }
+    return *this;
+}
+
+EmployeeId& EmployeeId::operator=(EmployeeId&& other) noexcept {
+    if (this != &other) {
+        release();
+        value = other.value;
+        length = other.length;
+        idKind = other.idKind;
+        other.idKind = Kind::Text;
+        other.length = 0;
+    }
+    return *this;
+}
+
+EmployeeId::~EmployeeId() {
+    release();
+}
+
+void EmployeeId::release() {
+    if (isHeapText() && value.heap.owned) {
+        delete[] value.heap.data;
+    }
+    idKind = Kind::Text;
+    length = 0;
+}
+
+void EmployeeId::copyFrom(const EmployeeId& other) {
+    value = other.value;
+    length = other.length;
+    idKind = other.idKind;
+    if (other.isHeapText()) {
+        char* data = new char[length];
+        std::memcpy(data, other.value.heap.data, length);
+        value.heap.data = data;
+        value.heap.owned = true;
+    }
+}
+
+EmployeeId EmployeeId::make(std::string_view text, bool copyLongText) {
+    EmployeeId id;
+    if (parseNumber(text, id.value.number)) {
+        id.idKind = Kind::Number;
+    } else if (parseUuid(text, id.value.bytes)) {
+        id.idKind = Kind::Uuid;
+    } else {
+        std::memset(&id.value, 0, sizeof(id.value));
+        id.length = static_cast<std::uint32_t>(text.size());
+        if (text.size() <= kInlineCapacity) {
+            std::memcpy(id.value.text, text.data(), text.size());
+        } else if (copyLongText) {
+            char* data = new char[text.size()];
+            std::memcpy(data, text.data(), text.size());
+            id.value.heap.data = data;
+            id.value.heap.owned = true;
+        } else {
+            id.value.heap.data = text.data();
+            id.value.heap.owned = false;
+        }
+    }
+    return id;
+}
+
+EmployeeId EmployeeId::parse(std::string_view text) {
+    return make(text, true);
+}
+
+EmployeeId EmployeeId::borrow(std::string_view text) {
+    return make(text, false);
+}
+
+EmployeeId EmployeeId::fromNumber(std::uint64_t number) {
+    EmployeeId id;
+    id.value.number = number;
+    id.idKind = Kind::Number;
+    return id;
+}
+
+std::uint64_t EmployeeId::hash() const {
+    switch (idKind) {
+        case Kind::Number:
+            return mix64(value.number);
+        case Kind::Uuid: {
+            std::uint64_t high, low;
+            std::memcpy(&high, value.bytes, 8);
+            std::memcpy(&low, value.bytes + 8, 8);
+            return mix64(high ^ mix64(low));
+        }
+        case Kind::Text:
+        default:
+            return std::hash<std::string_view>()(std::string_view(textData(), length));
+    }
+}
+
+std::string EmployeeId::toString() const {
+    switch (idKind) {
+        case Kind::Number:
+            return std::to_string(value.number);
+        case Kind::Uuid: {
+            static const char* hex = "0123456789abcdef";
+            std::string text(36, '-');
+            for (size_t i = 0; i < 16; i++) {
+                text[kUuidPairOffsets[i]] = hex[value.bytes[i] >> 4];
+                text[kUuidPairOffsets[i] + 1] = hex[value.bytes[i] & 0xF];
+            }
+            return text;
+        }
+        case Kind::Text:
+        default:
+            return std::string(textData(), length);
+    }
+}
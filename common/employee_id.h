@@ -0,0 +1,96 @@
+#ifndef EMPLOYEE_ID_H
+#define EMPLOYEE_ID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Compact employee id, 24 bytes whatever the text:
+//   Number - canonical decimal ("0", "42"; no sign or leading zeros) below 2^64
+//   Uuid   - canonical lowercase 8-4-4-4-12 UUID, kept as 16 binary bytes
+//   Text   - anything else; up to 16 bytes inline, longer ids on the heap
+// Parsing is canonical, so two ids are equal exactly when their text is, and
+// toString() gives back the original text.
+class EmployeeId {
+public:
+    enum class Kind : std::uint8_t { Number, Uuid, Text };
+
+private:
+    static constexpr size_t kInlineCapacity = 16;
+
+    union {
+        std::uint64_t number;
+        unsigned char bytes[16];   // UUID
+        char text[kInlineCapacity];
+        struct {
+            const char* data;
+            bool owned;            // false for a probe built with borrow()
+        } heap;
+    } value;
+    std::uint32_t length;          // text length for Text ids
+    Kind idKind;
+
+    bool isHeapText() const {
+        return idKind == Kind::Text && length > kInlineCapacity;
+    }
+
+    const char* textData() const {
+        return isHeapText() ? value.heap.data : value.text;
+    }
+
+    static EmployeeId make(std::string_view text, bool copyLongText);
+    void release();
+    void copyFrom(const EmployeeId& other);
+
+public:
+    EmployeeId();
+    EmployeeId(const EmployeeId& other);
+    EmployeeId(EmployeeId&& other) noexcept;
+    EmployeeId& operator=(const EmployeeId& other);
+    EmployeeId& operator=(EmployeeId&& other) noexcept;
+    ~EmployeeId();
+
+    static EmployeeId parse(std::string_view text);
+
+    // Like parse, but a long text id refers to text instead of copying it.
+    // Only for probing an index while text is alive; copies of the result own
+    // their text.
+    static EmployeeId borrow(std::string_view text);
+
+    static EmployeeId fromNumber(std::uint64_t number);
+
+    Kind kind() const {
+        return idKind;
+    }
+
+    bool isNumber() const {
+        return idKind == Kind::Number;
+    }
+
+    std::uint64_t number() const {
+        return value.number;
+    }
+
+    std::uint64_t hash() const;
+    std::string toString() const;
+
+    bool operator==(const EmployeeId& other) const {
+        // Number and UUID payloads fill the first 16 bytes; short text is
+        // zero-padded, so one compare covers every inline id
+        if (idKind != other.idKind || length != other.length) {
+            return false;
+        }
+        if (isHeapText()) {
+            return std::memcmp(value.heap.data, other.value.heap.data, length) == 0;
+        }
+        return std::memcmp(value.bytes, other.value.bytes, sizeof(value.bytes)) == 0;
+    }
+
+    bool operator!=(const EmployeeId& other) const {
+        return !(*this == other);
+    }
+};
+
+#endif // EMPLOYEE_ID_H
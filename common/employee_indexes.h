@@ -0,0 +1,110 @@
+#ifndef EMPLOYEE_INDEXES_H
+#define EMPLOYEE_INDEXES_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "secondary_index.h"
+#include "trigram_index.h"
+
+// Employee fields that secondary indexes can be declared against
+
+struct SalaryField {
+    using Key = std::int32_t;
+    static constexpr const char* kName = "salary";
+    static std::optional<Key> keyOf(const EmployeeFields& fields) {
+        return fields.salary == kNotNumeric ? std::nullopt : std::optional<Key>(fields.salary);
+    }
+};
+
+struct AgeField {
+    using Key = std::int32_t;
+    static constexpr const char* kName = "age";
+    static std::optional<Key> keyOf(const EmployeeFields& fields) {
+        return fields.age == kNotNumeric ? std::nullopt : std::optional<Key>(fields.age);
+    }
+};
+
+// Case-folded names and emails. Emails are unique ignoring case, and
+// autocomplete matches prefixes against both.
+struct EmailField {
+    using Key = std::string;
+    static constexpr const char* kName = "email";
+    static std::optional<Key> keyOf(const EmployeeFields& fields) {
+        return fields.email.empty() ? std::nullopt : std::optional<Key>(TrigramIndex::fold(fields.email));
+    }
+};
+
+struct NameField {
+    using Key = std::string;
+    static constexpr const char* kName = "name";
+    static std::optional<Key> keyOf(const EmployeeFields& fields) {
+        return fields.name.empty() ? std::nullopt : std::optional<Key>(TrigramIndex::fold(fields.name));
+    }
+};
+
+// Distinct case-folded words of a name, which fuzzy search matches query
+// words against. Words are split at ASCII spaces and punctuation; other
+// bytes, including UTF-8 sequences, stay inside words.
+struct NameTermsField {
+    using Key = std::string;
+    static constexpr const char* kName = "nameTerms";
+
+    static std::vector<std::string> termsOf(std::string_view text) {
+        std::vector<std::string> terms;
+        std::string term;
+        for (char c : text) {
+            auto byte = static_cast<unsigned char>(c);
+            if (byte >= 0x80 || std::isalnum(byte)) {
+                term.push_back(TrigramIndex::fold(c));
+            } else if (!term.empty()) {
+                terms.push_back(std::move(term));
+                term.clear();
+            }
+        }
+        if (!term.empty()) {
+            terms.push_back(std::move(term));
+        }
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+        return terms;
+    }
+
+    static std::vector<std::string> keysOf(const EmployeeFields& fields) {
+        return termsOf(fields.name);
+    }
+};
+
+// Numeric salaries in order, for top earners, ranks, percentiles and ranges
+using SalaryIndex = OrderedIndex<SalaryField>;
+
+// Numeric ages in order, for range queries
+using AgeIndex = OrderedIndex<AgeField>;
+
+// One employee per email, for lookups by email
+using EmailIndex = UniqueIndex<EmailField>;
+
+// Names and emails by prefix, for autocomplete
+using NamePrefixIndex = PrefixIndex<NameField>;
+using EmailPrefixIndex = PrefixIndex<EmailField>;
+
+// Words of names in order, for fuzzy name search
+using NameTermsIndex = PrefixIndex<NameTermsField>;
+
+// The indexes every EmployeeTable keeps. Declaring one here is all it takes:
+// the table builds it on load and keeps it in step with every add, update and
+// delete.
+inline void declareEmployeeIndexes(SecondaryIndexes& indexes) {
+    indexes.declare<SalaryIndex>();
+    indexes.declare<AgeIndex>();
+    indexes.declare<EmailIndex>();
+    indexes.declare<NamePrefixIndex>();
+    indexes.declare<EmailPrefixIndex>();
+    indexes.declare<NameTermsIndex>();
+}
+
+#endif // EMPLOYEE_INDEXES_H
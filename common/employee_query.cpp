@@ -0,0 +1,660 @@
+#include "employee_query.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include "trigram_index.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// Deepest filter tree accepted, so a hostile request cannot exhaust the stack
+constexpr int kMaxFilterDepth = 32;
+
+// Relative cost of checking one row reached by a scan, which reads the
+// columns in order, and one reached through an index, by handle slot, as
+// measured by ./benchmark queries
+constexpr double kScanRowCost = 1.0;
+constexpr double kIndexRowCost = 5.0;
+
+// Numeric column values; anything below is kNotNumeric
+constexpr std::int64_t kLowestNumber = static_cast<std::int64_t>(kNotNumeric) + 1;
+constexpr std::int64_t kHighestNumber = std::numeric_limits<std::int32_t>::max();
+
+struct FieldName {
+    const char* name;
+    QueryField field;
+};
+
+constexpr FieldName kFieldNames[] = {
+    {"id", QueryField::Id},         {"name", QueryField::Name},     {"title", QueryField::Title},
+    {"email", QueryField::Email},   {"salary", QueryField::Salary}, {"age", QueryField::Age},
+};
+
+struct OpName {
+    const char* name;
+    QueryOp op;
+};
+
+constexpr OpName kOpNames[] = {
+    {"=", QueryOp::Equal},          {"!=", QueryOp::NotEqual},  {"<", QueryOp::Less},
+    {"<=", QueryOp::LessOrEqual},   {">", QueryOp::Greater},    {">=", QueryOp::GreaterOrEqual},
+    {"contains", QueryOp::Contains}, {"prefix", QueryOp::Prefix},
+};
+
+const char* fieldName(QueryField field) {
+    for (const auto& entry : kFieldNames) {
+        if (entry.field == field) {
+            return entry.name;
+        }
+    }
+    return "";
+}
+
+const char* opName(QueryOp op) {
+    for (const auto& entry : kOpNames) {
+        if (entry.op == op) {
+            return entry.name;
+        }
+    }
+    return "";
+}
+
+bool isNumeric(QueryField field) {
+    return field == QueryField::Salary || field == QueryField::Age;
+}
+
+bool opApplies(QueryField field, QueryOp op) {
+    switch (field) {
+        case QueryField::Id:
+            return op == QueryOp::Equal || op == QueryOp::NotEqual;
+        case QueryField::Name:
+        case QueryField::Title:
+        case QueryField::Email:
+            return op == QueryOp::Equal || op == QueryOp::NotEqual || op == QueryOp::Contains || op == QueryOp::Prefix;
+        case QueryField::Salary:
+        case QueryField::Age:
+            return op != QueryOp::Contains && op != QueryOp::Prefix;
+    }
+    return false;
+}
+
+// Comparisons of raw text with an already folded value, ignoring case
+bool sameFolded(char c, char folded) {
+    return TrigramIndex::fold(c) == folded;
+}
+
+bool equalsFolded(std::string_view text, std::string_view folded) {
+    return text.size() == folded.size() && std::equal(text.begin(), text.end(), folded.begin(), sameFolded);
+}
+
+bool startsWithFolded(std::string_view text, std::string_view folded) {
+    return text.size() >= folded.size() && std::equal(folded.begin(), folded.end(), text.begin(),
+                                                      [](char f, char c) { return sameFolded(c, f); });
+}
+
+bool containsFolded(std::string_view text, std::string_view folded) {
+    return std::search(text.begin(), text.end(), folded.begin(), folded.end(), sameFolded) != text.end();
+}
+
+std::optional<std::int64_t> integerValue(const json& value) {
+    if (value.is_number_integer()) {
+        return value.get<std::int64_t>();
+    }
+    if (!value.is_string()) {
+        return std::nullopt;
+    }
+    const std::string& text = value.get_ref<const std::string&>();
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    errno = 0;
+    char* end = nullptr;
+    long long number = std::strtoll(text.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0') {
+        return std::nullopt;
+    }
+    return number;
+}
+
+std::optional<Predicate> parsePredicate(const json& node, std::string& error) {
+    if (!node.contains("field") || !node.contains("op") || !node.contains("value")) {
+        error = "a predicate needs field, op and value";
+        return std::nullopt;
+    }
+    const json& field = node["field"];
+    const json& op = node["op"];
+    const json& value = node["value"];
+
+    Predicate predicate;
+    auto namedField = std::find_if(std::begin(kFieldNames), std::end(kFieldNames), [&field](const FieldName& entry) {
+        return field.is_string() && field.get_ref<const std::string&>() == entry.name;
+    });
+    if (namedField == std::end(kFieldNames)) {
+        error = "field must be one of id, name, title, email, salary, age";
+        return std::nullopt;
+    }
+    predicate.field = namedField->field;
+    auto namedOp = std::find_if(std::begin(kOpNames), std::end(kOpNames), [&op](const OpName& entry) {
+        return op.is_string() && op.get_ref<const std::string&>() == entry.name;
+    });
+    if (namedOp == std::end(kOpNames)) {
+        error = "op must be one of =, !=, <, <=, >, >=, contains, prefix";
+        return std::nullopt;
+    }
+    predicate.op = namedOp->op;
+    if (!opApplies(predicate.field, predicate.op)) {
+        error = std::string("op ") + namedOp->name + " does not apply to " + namedField->name;
+        return std::nullopt;
+    }
+
+    if (isNumeric(predicate.field)) {
+        auto number = integerValue(value);
+        if (!number) {
+            error = std::string("value of ") + namedField->name + " must be an integer";
+            return std::nullopt;
+        }
+        predicate.number = *number;
+        predicate.value = std::to_string(*number);
+    } else if (value.is_string()) {
+        predicate.value = value.get<std::string>();
+    } else if (predicate.field == QueryField::Id && value.is_number_integer()) {
+        predicate.value = std::to_string(value.get<std::int64_t>());
+    } else {
+        error = std::string("value of ") + namedField->name + " must be a string";
+        return std::nullopt;
+    }
+    if (predicate.field == QueryField::Id) {
+        predicate.id = EmployeeId::parse(predicate.value);
+    } else {
+        predicate.folded = TrigramIndex::fold(predicate.value);
+    }
+    return predicate;
+}
+
+std::optional<Filter> parseFilter(const json& node, int depth, std::string& error) {
+    if (depth > kMaxFilterDepth) {
+        error = "filter is nested more than " + std::to_string(kMaxFilterDepth) + " levels deep";
+        return std::nullopt;
+    }
+    if (!node.is_object()) {
+        error = "a filter must be an object";
+        return std::nullopt;
+    }
+
+    Filter filter;
+    if (node.contains("not")) {
+        auto child = parseFilter(node["not"], depth + 1, error);
+        if (!child) {
+            return std::nullopt;
+        }
+        filter.kind = Filter::Kind::Not;
+        filter.children.push_back(std::move(*child));
+        return filter;
+    }
+    for (auto kind : {Filter::Kind::And, Filter::Kind::Or}) {
+        const char* name = kind == Filter::Kind::And ? "and" : "or";
+        if (!node.contains(name)) {
+            continue;
+        }
+        if (!node[name].is_array()) {
+            error = std::string(name) + " must be an array of filters";
+            return std::nullopt;
+        }
+        filter.kind = kind;
+        for (const auto& item : node[name]) {
+            auto child = parseFilter(item, depth + 1, error);
+            if (!child) {
+                return std::nullopt;
+            }
+            if (child->kind == kind) {
+                std::move(child->children.begin(), child->children.end(), std::back_inserter(filter.children));
+            } else {
+                filter.children.push_back(std::move(*child));
+            }
+        }
+        if (filter.children.size() == 1) {
+            return std::move(filter.children.front());
+        }
+        return filter;
+    }
+
+    auto predicate = parsePredicate(node, error);
+    if (!predicate) {
+        return std::nullopt;
+    }
+    filter.kind = Filter::Kind::Predicate;
+    filter.predicate = std::move(*predicate);
+    return filter;
+}
+
+// Descending one tree or dictionary in every shard
+double probeCost(const StoreView& view) {
+    size_t shards = std::max<size_t>(1, view.shards.size());
+    double rowsPerShard = static_cast<double>(view.size()) / static_cast<double>(shards);
+    return std::log2(std::max(2.0, rowsPerShard)) * static_cast<double>(shards);
+}
+
+// Rows of one shard's ordered index with a key in [min, max]
+template <typename Index>
+std::uint64_t rangeCount(const EmployeeTable& table, std::int32_t min, std::int32_t max) {
+    if (min > max) {
+        return 0;
+    }
+    const auto& entries = table.index<Index>()->entries();
+    return entries.countUpTo(max) - std::min(entries.countBefore(min), entries.countUpTo(max));
+}
+
+// Calls visit(code) for the titles of a shard a title predicate accepts
+template <typename Visit>
+void forEachTitle(const EmployeeTable& table, const Predicate& predicate, Visit&& visit) {
+    const TitleDictionary& titles = table.titles();
+    for (std::uint32_t code : titles.codesContaining(predicate.folded)) {
+        // Folding keeps lengths, so a title containing the value and as long is equal to it
+        if (predicate.op != QueryOp::Equal || titles.title(code).size() == predicate.folded.size()) {
+            visit(code);
+        }
+    }
+}
+
+// Index access answering a predicate, with its estimated rows and cost, or
+// nothing if no index can
+std::optional<AccessPlan> indexAccess(const StoreView& view, const Predicate& predicate) {
+    AccessPlan access;
+    access.predicate = predicate;
+    double lookupCost = probeCost(view);
+    std::uint64_t rows = 0;
+
+    switch (predicate.field) {
+        case QueryField::Id: {
+            if (predicate.op != QueryOp::Equal) {
+                return std::nullopt;
+            }
+            access.path = AccessPath::IdLookup;
+            rows = view.shards[view.shardOf(predicate.value)]->contains(predicate.value) ? 1 : 0;
+            lookupCost = 1;
+            break;
+        }
+        case QueryField::Email: {
+            // Empty emails are not indexed, so an empty value must scan
+            if (predicate.folded.empty()) {
+                return std::nullopt;
+            }
+            if (predicate.op == QueryOp::Equal) {
+                access.path = AccessPath::EmailLookup;
+                for (const auto& table : view.shards) {
+                    rows += table->index<EmailIndex>()->entries().countOf(predicate.folded);
+                }
+                lookupCost = static_cast<double>(view.shards.size());
+            } else if (predicate.op == QueryOp::Prefix) {
+                access.path = AccessPath::EmailPrefix;
+                for (const auto& table : view.shards) {
+                    rows += table->index<EmailPrefixIndex>()->entries().countWithPrefix(predicate.folded);
+                }
+            } else {
+                return std::nullopt;
+            }
+            break;
+        }
+        case QueryField::Name: {
+            // Empty names are not indexed, so an empty value must scan
+            if ((predicate.op == QueryOp::Equal || predicate.op == QueryOp::Prefix) && !predicate.folded.empty()) {
+                access.path = AccessPath::NamePrefix;
+                for (const auto& table : view.shards) {
+                    const auto& entries = table->index<NamePrefixIndex>()->entries();
+                    rows += predicate.op == QueryOp::Equal ? entries.count(predicate.folded)
+                                                           : entries.countWithPrefix(predicate.folded);
+                }
+            } else if (predicate.op == QueryOp::Contains && predicate.folded.size() >= TrigramIndex::kMinQueryLength) {
+                access.path = AccessPath::NameTrigrams;
+                for (const auto& table : view.shards) {
+                    rows += table->nameContainingEstimate(predicate.folded);
+                }
+            } else {
+                return std::nullopt;
+            }
+            break;
+        }
+        case QueryField::Title: {
+            if (predicate.op != QueryOp::Equal && predicate.op != QueryOp::Contains) {
+                return std::nullopt;
+            }
+            // Every distinct title of every shard is compared
+            access.path = AccessPath::TitleDictionary;
+            lookupCost = 0;
+            for (const auto& table : view.shards) {
+                lookupCost += static_cast<double>(table->titles().distinctCount());
+                forEachTitle(*table, predicate, [&](std::uint32_t code) { rows += table->titles().rows(code).size(); });
+            }
+            break;
+        }
+        case QueryField::Salary:
+        case QueryField::Age: {
+            if (predicate.op == QueryOp::NotEqual) {
+                return std::nullopt;
+            }
+            bool salary = predicate.field == QueryField::Salary;
+            access.path = salary ? AccessPath::SalaryRange : AccessPath::AgeRange;
+            auto [min, max] = predicate.range();
+            for (const auto& table : view.shards) {
+                rows += salary ? rangeCount<SalaryIndex>(*table, min, max) : rangeCount<AgeIndex>(*table, min, max);
+            }
+            break;
+        }
+    }
+
+    access.estimatedRows = rows;
+    access.cost = lookupCost + static_cast<double>(rows) * kIndexRowCost;
+    return access;
+}
+
+// Calls visit(row) for every row of one shard the driver yields
+template <typename Visit>
+void forEachDriverRow(const StoreView& view, size_t shard, const AccessPlan& driver, Visit&& visit) {
+    const EmployeeTable& table = *view.shards[shard];
+    if (driver.path == AccessPath::FullScan) {
+        for (size_t row = 0; row < table.size(); row++) {
+            visit(row);
+        }
+        return;
+    }
+
+    const Predicate& predicate = *driver.predicate;
+    auto walkPrefix = [&](const PrefixDictionary& entries) {
+        for (auto cursor = entries.ascendingFrom(predicate.folded); !cursor.done(); cursor.next()) {
+            bool inRange = predicate.op == QueryOp::Equal ? cursor.key() == predicate.folded
+                                                          : cursor.key().compare(0, predicate.folded.size(), predicate.folded) == 0;
+            if (!inRange) {
+                break;
+            }
+            visit(table.rowOfSlot(cursor.slot()));
+        }
+    };
+    auto walkRange = [&](const auto& entries) {
+        auto [min, max] = predicate.range();
+        if (min > max) {
+            return;
+        }
+        for (auto cursor = entries.ascendingFrom(min); !cursor.done() && cursor.key() <= max; cursor.next()) {
+            visit(table.rowOfSlot(cursor.slot()));
+        }
+    };
+
+    switch (driver.path) {
+        case AccessPath::FullScan:
+            break;
+        case AccessPath::IdLookup:
+            if (shard == view.shardOf(predicate.value)) {
+                if (auto row = table.findRow(predicate.value)) {
+                    visit(*row);
+                }
+            }
+            break;
+        case AccessPath::EmailLookup:
+            if (auto slot = table.index<EmailIndex>()->entries().findAny(predicate.folded)) {
+                visit(table.rowOfSlot(*slot));
+            }
+            break;
+        case AccessPath::NamePrefix:
+            walkPrefix(table.index<NamePrefixIndex>()->entries());
+            break;
+        case AccessPath::EmailPrefix:
+            walkPrefix(table.index<EmailPrefixIndex>()->entries());
+            break;
+        case AccessPath::NameTrigrams:
+            for (size_t row : table.rowsWithNameContaining(predicate.folded)) {
+                visit(row);
+            }
+            break;
+        case AccessPath::TitleDictionary:
+            forEachTitle(table, predicate, [&](std::uint32_t code) {
+                table.titles().rows(code).forEach([&](std::uint32_t row) { visit(row); });
+            });
+            break;
+        case AccessPath::SalaryRange:
+            walkRange(table.index<SalaryIndex>()->entries());
+            break;
+        case AccessPath::AgeRange:
+            walkRange(table.index<AgeIndex>()->entries());
+            break;
+    }
+}
+
+} // namespace
+
+bool Predicate::matches(const EmployeeFields& fields, const EmployeeId& rowId) const {
+    std::string_view text;
+    std::int32_t number = kNotNumeric;
+    switch (field) {
+        case QueryField::Id:
+            return (rowId == id) == (op == QueryOp::Equal);
+        case QueryField::Name:
+            text = fields.name;
+            break;
+        case QueryField::Title:
+            text = fields.title;
+            break;
+        case QueryField::Email:
+            text = fields.email;
+            break;
+        case QueryField::Salary:
+            number = fields.salary;
+            break;
+        case QueryField::Age:
+            number = fields.age;
+            break;
+    }
+
+    if (!isNumeric(field)) {
+        switch (op) {
+            case QueryOp::Equal:
+                return equalsFolded(text, folded);
+            case QueryOp::NotEqual:
+                return !equalsFolded(text, folded);
+            case QueryOp::Contains:
+                return containsFolded(text, folded);
+            case QueryOp::Prefix:
+                return startsWithFolded(text, folded);
+            default:
+                return false;
+        }
+    }
+    if (number == kNotNumeric) {
+        return false;
+    }
+    switch (op) {
+        case QueryOp::Equal:
+            return number == this->number;
+        case QueryOp::NotEqual:
+            return number != this->number;
+        case QueryOp::Less:
+            return number < this->number;
+        case QueryOp::LessOrEqual:
+            return number <= this->number;
+        case QueryOp::Greater:
+            return number > this->number;
+        case QueryOp::GreaterOrEqual:
+            return number >= this->number;
+        default:
+            return false;
+    }
+}
+
+std::pair<std::int32_t, std::int32_t> Predicate::range() const {
+    std::int64_t min = kLowestNumber;
+    std::int64_t max = kHighestNumber;
+    switch (op) {
+        case QueryOp::Equal:
+            min = max = number;
+            break;
+        case QueryOp::Less:
+            max = number == std::numeric_limits<std::int64_t>::min() ? min - 1 : number - 1;
+            break;
+        case QueryOp::LessOrEqual:
+            max = number;
+            break;
+        case QueryOp::Greater:
+            min = number == std::numeric_limits<std::int64_t>::max() ? max + 1 : number + 1;
+            break;
+        case QueryOp::GreaterOrEqual:
+            min = number;
+            break;
+        default:
+            break;
+    }
+    min = std::max(min, kLowestNumber);
+    max = std::min(max, kHighestNumber);
+    if (min > max) {
+        return {1, 0};
+    }
+    return {static_cast<std::int32_t>(min), static_cast<std::int32_t>(max)};
+}
+
+std::string Predicate::describe() const {
+    std::string operand = isNumeric(field) ? value : json(value).dump();
+    return std::string(fieldName(field)) + " " + opName(op) + " " + operand;
+}
+
+bool Filter::matches(const EmployeeFields& fields, const EmployeeId& rowId) const {
+    switch (kind) {
+        case Kind::Predicate:
+            return predicate.matches(fields, rowId);
+        case Kind::And:
+            return std::all_of(children.begin(), children.end(),
+                               [&](const Filter& child) { return child.matches(fields, rowId); });
+        case Kind::Or:
+            return std::any_of(children.begin(), children.end(),
+                               [&](const Filter& child) { return child.matches(fields, rowId); });
+        case Kind::Not:
+            return !children.front().matches(fields, rowId);
+    }
+    return false;
+}
+
+std::vector<const Filter*> Filter::conjuncts() const {
+    std::vector<const Filter*> result;
+    if (kind == Kind::And) {
+        for (const auto& child : children) {
+            result.push_back(&child);
+        }
+    } else {
+        result.push_back(this);
+    }
+    return result;
+}
+
+std::string Filter::describe() const {
+    switch (kind) {
+        case Kind::Predicate:
+            return predicate.describe();
+        case Kind::Not:
+            return "NOT " + children.front().describe();
+        case Kind::And:
+        case Kind::Or:
+            break;
+    }
+    if (children.empty()) {
+        return kind == Kind::And ? "true" : "false";
+    }
+    std::string text = "(";
+    for (size_t i = 0; i < children.size(); i++) {
+        text += (i == 0 ? "" : kind == Kind::And ? " AND " : " OR ") + children[i].describe();
+    }
+    return text + ")";
+}
+
+std::optional<Filter> Filter::fromJson(const json& node, std::string& error) {
+    return parseFilter(node, 0, error);
+}
+
+const char* accessPathName(AccessPath path) {
+    switch (path) {
+        case AccessPath::FullScan:
+            return "full scan";
+        case AccessPath::IdLookup:
+            return "id index";
+        case AccessPath::EmailLookup:
+            return "email index";
+        case AccessPath::NamePrefix:
+            return "name prefix index";
+        case AccessPath::EmailPrefix:
+            return "email prefix index";
+        case AccessPath::NameTrigrams:
+            return "name trigram index";
+        case AccessPath::TitleDictionary:
+            return "title dictionary";
+        case AccessPath::SalaryRange:
+            return "salary index";
+        case AccessPath::AgeRange:
+            return "age index";
+    }
+    return "";
+}
+
+QueryPlan planQuery(const StoreView& view, const Filter& filter) {
+    // Each costed path with the conjunct it answers; the scan answers none
+    auto conjuncts = filter.conjuncts();
+    std::vector<std::pair<AccessPlan, size_t>> paths;
+    AccessPlan scan;
+    scan.estimatedRows = view.size();
+    scan.cost = static_cast<double>(view.size()) * kScanRowCost;
+    paths.emplace_back(scan, conjuncts.size());
+    for (size_t i = 0; i < conjuncts.size(); i++) {
+        if (conjuncts[i]->kind != Filter::Kind::Predicate) {
+            continue;
+        }
+        if (auto access = indexAccess(view, conjuncts[i]->predicate)) {
+            paths.emplace_back(std::move(*access), i);
+        }
+    }
+    // On a tie the scan, considered first, wins: it reads rows in order
+    std::stable_sort(paths.begin(), paths.end(), [](const auto& a, const auto& b) { return a.first.cost < b.first.cost; });
+
+    QueryPlan plan;
+    plan.driver = paths.front().first;
+    size_t answered = paths.front().second;
+    for (auto& path : paths) {
+        plan.considered.push_back(std::move(path.first));
+    }
+
+    // The driver yields exactly the rows its conjunct accepts, so only the
+    // others are left to check
+    if (answered == conjuncts.size()) {
+        plan.residual = filter;
+        return plan;
+    }
+    plan.residual.kind = Filter::Kind::And;
+    for (size_t i = 0; i < conjuncts.size(); i++) {
+        if (i != answered) {
+            plan.residual.children.push_back(*conjuncts[i]);
+        }
+    }
+    if (plan.residual.children.size() == 1) {
+        plan.residual = Filter(plan.residual.children.front());
+    }
+    return plan;
+}
+
+QueryResult runQuery(const StoreView& view, const Filter& filter, size_t limit) {
+    QueryResult result;
+    result.plan = planQuery(view, filter);
+    const Filter& residual = result.plan.residual;
+
+    for (size_t shard = 0; shard < view.shards.size(); shard++) {
+        const EmployeeTable& table = *view.shards[shard];
+        forEachDriverRow(view, shard, result.plan.driver, [&](size_t row) {
+            result.rowsExamined++;
+            if (!residual.matches(table.fieldsAt(row), table.idAt(row))) {
+                return;
+            }
+            result.total++;
+            if (result.employees.size() < limit) {
+                result.employees.push_back(table.row(row));
+            }
+        });
+    }
+    return result;
+}
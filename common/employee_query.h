@@ -0,0 +1,112 @@
+#ifndef EMPLOYEE_QUERY_H
+#define EMPLOYEE_QUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "employee.h"
+#include "employee_id.h"
+#include "employee_store.h"
+#include "nlohmann/json.hpp"
+
+enum class QueryField { Id, Name, Title, Email, Salary, Age };
+
+enum class QueryOp { Equal, NotEqual, Less, LessOrEqual, Greater, GreaterOrEqual, Contains, Prefix };
+
+// One comparison of a field with a constant. Names, titles and emails are
+// compared ignoring case, ids exactly. Salary and age compare as integers, and
+// an employee whose value is not a number matches no numeric comparison.
+struct Predicate {
+    QueryField field = QueryField::Id;
+    QueryOp op = QueryOp::Equal;
+    std::string value;   // as given, for descriptions
+    std::string folded;  // case-folded value of a text field
+    EmployeeId id;       // value of an id comparison
+    std::int64_t number = 0;
+
+    bool matches(const EmployeeFields& fields, const EmployeeId& rowId) const;
+
+    // Keys [min, max] of a numeric comparison other than !=, clamped to the
+    // numeric int32 values; min > max when nothing can match
+    std::pair<std::int32_t, std::int32_t> range() const;
+
+    // e.g. salary > 150000
+    std::string describe() const;
+};
+
+// Filter expression tree: a predicate, or the and, or, or not of other
+// filters. An empty and matches every employee and an empty or none.
+struct Filter {
+    enum class Kind { Predicate, And, Or, Not };
+
+    Kind kind = Kind::And;
+    Predicate predicate;           // Kind::Predicate only
+    std::vector<Filter> children;  // one for Kind::Not
+
+    bool matches(const EmployeeFields& fields, const EmployeeId& rowId) const;
+
+    // Filters every employee must pass: the children of an and, otherwise
+    // the filter itself
+    std::vector<const Filter*> conjuncts() const;
+
+    std::string describe() const;
+
+    // Parse the JSON form:
+    //   {"field": "salary", "op": ">", "value": 150000}
+    //   {"and": [...]}, {"or": [...]}, {"not": {...}}
+    // Nested ands and ors are flattened and single-child ones unwrapped.
+    // Nothing on malformed input, with the reason in error.
+    static std::optional<Filter> fromJson(const nlohmann::json& node, std::string& error);
+};
+
+// How a query reaches the rows its residual filter is checked against
+enum class AccessPath {
+    FullScan,
+    IdLookup,         // id index of the owning shard
+    EmailLookup,      // unique email index, one probe per shard
+    NamePrefix,       // front-coded name dictionary, for = and prefix
+    EmailPrefix,      // front-coded email dictionary, for prefix
+    NameTrigrams,     // trigram index, for contains of three or more characters
+    TitleDictionary,  // distinct titles, for = and contains
+    SalaryRange,      // ordered salary index, for =, <, <=, > and >=
+    AgeRange          // ordered age index, likewise
+};
+
+const char* accessPathName(AccessPath path);
+
+// One way of producing candidate rows, with what the planner expects it to cost
+struct AccessPlan {
+    AccessPath path = AccessPath::FullScan;
+    std::optional<Predicate> predicate;  // the conjunct it answers; none for a full scan
+    std::uint64_t estimatedRows = 0;     // rows handed to the residual filter
+    double cost = 0;
+};
+
+struct QueryPlan {
+    AccessPlan driver;
+    std::vector<AccessPlan> considered;  // every costed path, cheapest first
+    Filter residual;                     // checked on every row the driver yields
+};
+
+struct QueryResult {
+    std::vector<Employee> employees;  // at most the limit, shard by shard in driver order
+    std::uint64_t total = 0;          // all matching employees
+    std::uint64_t rowsExamined = 0;   // rows the driver yielded
+    QueryPlan plan;
+};
+
+// Cost-based planning over one StoreView. Every conjunct an index can answer
+// is costed from the index's own counts: exact for ordered ranges, prefixes,
+// titles and lookups, an upper bound for trigrams. The cheapest of those and a
+// full scan drives the query, and the other conjuncts filter its rows. Ors
+// and nots are only ever residual; a filter without an indexable conjunct
+// scans.
+QueryPlan planQuery(const StoreView& view, const Filter& filter);
+
+QueryResult runQuery(const StoreView& view, const Filter& filter, size_t limit);
+
+#endif // EMPLOYEE_QUERY_H
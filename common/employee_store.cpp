@@ -0,0 +1,93 @@
+#include "employee_store.h"
+#include <algorithm>
+#include <utility>
+#include "employee_id.h"
+
+size_t StoreView::shardOf(std::string_view id) const {
+    return EmployeeStore::shardOf(EmployeeId::borrow(id).hash(), shards.size());
+}
+
+size_t StoreView::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard->size();
+    }
+    return total;
+}
+
+EmployeeStore::EmployeeStore(size_t shardCount)
+    : shardMutexes(new std::mutex[std::max<size_t>(shardCount, 1)]), shards(std::max<size_t>(shardCount, 1)) {
+    auto empty = std::make_shared<StoreView>();
+    for (size_t shard = 0; shard < shards; shard++) {
+        empty->shards.push_back(std::make_shared<const EmployeeTable>());
+    }
+    replace(std::move(empty));
+}
+
+size_t EmployeeStore::shardOf(std::uint64_t hash, size_t shardCount) {
+    return static_cast<size_t>(((hash >> 32) * shardCount) >> 32);
+}
+
+size_t EmployeeStore::shardCount() const {
+    return shards;
+}
+
+size_t EmployeeStore::shardOf(std::string_view id) const {
+    return shardOf(EmployeeId::borrow(id).hash(), shards);
+}
+
+PinnedView EmployeeStore::view() const {
+    // Pin first: a view loaded after the pin is not freed before it is dropped
+    ReadEpoch::Pin pin;
+    return PinnedView(std::move(pin), current.load(std::memory_order_seq_cst));
+}
+
+std::shared_ptr<const StoreView> EmployeeStore::sharedView() const {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    return owner;
+}
+
+std::mutex& EmployeeStore::shardMutex(size_t shard) {
+    return shardMutexes[shard];
+}
+
+std::vector<std::unique_lock<std::mutex>> EmployeeStore::lockAll() {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(shards);
+    for (size_t shard = 0; shard < shards; shard++) {
+        locks.emplace_back(shardMutexes[shard]);
+    }
+    return locks;
+}
+
+void EmployeeStore::publish(const std::vector<std::pair<size_t, std::shared_ptr<const EmployeeTable>>>& tables) {
+    // Writers of other shards may publish at the same time; each builds on
+    // whatever view the one before it left
+    std::lock_guard<std::mutex> lock(publishMutex);
+    auto next = std::make_shared<StoreView>(*owner);
+    for (const auto& table : tables) {
+        next->shards[table.first] = table.second;
+    }
+    replace(std::move(next));
+}
+
+void EmployeeStore::publishAll(std::vector<std::shared_ptr<const EmployeeTable>> tables) {
+    auto next = std::make_shared<StoreView>();
+    next->shards = std::move(tables);
+    std::lock_guard<std::mutex> lock(publishMutex);
+    replace(std::move(next));
+}
+
+void EmployeeStore::replace(std::shared_ptr<const StoreView> next) {
+    current.store(next.get(), std::memory_order_seq_cst);
+    if (owner) {
+        retired.emplace_back(ReadEpoch::advance(), std::move(owner));
+    }
+    owner = std::move(next);
+
+    // Readers pinned at a later epoch loaded the pointer after it moved on
+    std::uint64_t oldest = ReadEpoch::oldestPinned();
+    retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                 [oldest](const auto& entry) { return entry.first < oldest; }),
+                  retired.end());
+}
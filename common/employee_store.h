@@ -0,0 +1,94 @@
+#ifndef EMPLOYEE_STORE_H
+#define EMPLOYEE_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "employee_table.h"
+#include "read_epoch.h"
+
+// Shards used unless configured otherwise (EMPLOYEE_SHARDS for the server)
+constexpr size_t kDefaultShardCount = 16;
+
+// Every shard's table as of one moment. Views are immutable; a write publishes
+// a new view that shares all untouched shards with the previous one.
+struct StoreView {
+    std::vector<std::shared_ptr<const EmployeeTable>> shards;
+
+    size_t shardOf(std::string_view id) const;
+    size_t size() const;
+};
+
+// The current StoreView, kept alive for as long as this lives. Must be dropped
+// on the thread that took it; hand a sharedView() to other threads instead.
+class PinnedView {
+private:
+    ReadEpoch::Pin pin;
+    const StoreView* pinned;
+
+public:
+    PinnedView(ReadEpoch::Pin pin, const StoreView* view) : pin(std::move(pin)), pinned(view) {}
+
+    const StoreView& operator*() const {
+        return *pinned;
+    }
+    const StoreView* operator->() const {
+        return pinned;
+    }
+};
+
+// Employees partitioned into shards by id hash. Each shard has its own table,
+// with its own id index, title dictionary and handles, and its own writer lock,
+// so a write copies and publishes only the shards it touches. Readers pin the
+// current StoreView with a store to a slot of their own thread and one atomic
+// load, taking no lock and touching no reference count; views replaced since
+// are freed by later publishes once no reader has them pinned (read_epoch.h).
+class EmployeeStore {
+private:
+    std::atomic<const StoreView*> current;
+    std::unique_ptr<std::mutex[]> shardMutexes;
+    size_t shards;
+
+    // Publishers take this to swap views; readers never do
+    mutable std::mutex publishMutex;
+    std::shared_ptr<const StoreView> owner;  // keeps current alive
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<const StoreView>>> retired;  // with the epoch that ended
+
+    // Make next current, retire the old view and free views no reader can still see
+    void replace(std::shared_ptr<const StoreView> next);
+
+public:
+    explicit EmployeeStore(size_t shardCount);
+
+    // Shard owning an id hash; uses the high half of the hash, which the
+    // per-shard index folds away, so shards do not skew its buckets
+    static size_t shardOf(std::uint64_t hash, size_t shardCount);
+
+    size_t shardCount() const;
+    size_t shardOf(std::string_view id) const;
+    PinnedView view() const;
+
+    // Owning reference to the current view, for work that outlives the
+    // calling thread's pin; takes the publish lock
+    std::shared_ptr<const StoreView> sharedView() const;
+
+    // Writer lock of one shard; held while changing and publishing it
+    std::mutex& shardMutex(size_t shard);
+
+    // Every shard lock in index order, for operations that need the whole store still
+    std::vector<std::unique_lock<std::mutex>> lockAll();
+
+    // Replace the tables of some shards in one step, so readers see all of the
+    // changes or none; the caller holds those shards' locks
+    void publish(const std::vector<std::pair<size_t, std::shared_ptr<const EmployeeTable>>>& tables);
+
+    // Replace every table at once; the caller holds every shard lock
+    void publishAll(std::vector<std::shared_ptr<const EmployeeTable>> tables);
+};
+
+#endif // EMPLOYEE_STORE_H
@@ -0,0 +1,341 @@
+#include "employee_table.h"
+#include <algorithm>
+#include <stdexcept>
+
+std::int32_t EmployeeTable::parseNumber(const std::string& text, std::string& originalText) {
+    // Same rules the string-based queries applied with std::stoi on every request
+    std::int32_t value = kNotNumeric;
+    try {
+        value = std::stoi(text);
+    } catch (const std::exception&) {
+        // Not numeric; only the text is meaningful
+    }
+
+    if (value != kNotNumeric && std::to_string(value) == text) {
+        originalText.clear();
+    } else {
+        originalText = text;
+    }
+    return value;
+}
+
+std::string EmployeeTable::numberText(std::int32_t value, std::string_view originalText) {
+    return originalText.empty() && value != kNotNumeric ? std::to_string(value) : std::string(originalText);
+}
+
+void EmployeeTable::setRow(size_t row, const Employee& employee) {
+    // Only touch string cells that change, so chunks shared with older table
+    // versions are cloned as rarely as possible
+    auto assign = [row](auto& column, const auto& value) {
+        if (column[row] != value) {
+            column.mutableAt(row) = value;
+        }
+    };
+    auto assignText = [row](TextColumn& column, std::string_view value) {
+        if (column[row] != value) {
+            column.set(row, value);
+        }
+    };
+    std::string salaryText, ageText;
+    assign(salaries, parseNumber(employee.getSalary(), salaryText));
+    assign(ages, parseNumber(employee.getAge(), ageText));
+    if (names[row] != employee.getName()) {
+        nameTrigrams.update(slotOfRow[row], names[row], employee.getName());
+        foldedNames.set(row, employee.getName());
+    }
+    assignText(names, employee.getName());
+    assignText(emails, employee.getEmail());
+    assignText(salaryTexts, salaryText);
+    assignText(ageTexts, ageText);
+}
+
+EmployeeTable::EmployeeTable() : highestNumericId(0) {
+    declareEmployeeIndexes(indexes);
+}
+
+void EmployeeTable::beginBulkLoad() {
+    bulkLoading = true;
+}
+
+size_t EmployeeTable::endBulkLoad() {
+    if (!bulkLoading) {
+        return 0;
+    }
+    bulkLoading = false;
+    return rebuildIndexes();
+}
+
+size_t EmployeeTable::dropUniqueKeysHeldBy(const std::vector<const EmployeeTable*>& others) {
+    size_t dropped = 0;
+    for (const auto& index : indexes.all()) {
+        if (index->kind() != IndexKind::Unique) {
+            continue;
+        }
+        std::vector<const SecondaryIndexBase*> theirs;
+        for (const EmployeeTable* other : others) {
+            if (const SecondaryIndexBase* found = other->indexes.find(index->name())) {
+                theirs.push_back(found);
+            }
+        }
+        for (size_t row = 0; row < size() && !theirs.empty(); row++) {
+            EmployeeFields fields = fieldsAt(row);
+            // Duplicates within this table are already left out
+            if (index->holderOf(fields) != slotOfRow[row]) {
+                continue;
+            }
+            for (const SecondaryIndexBase* other : theirs) {
+                if (other->holderOf(fields)) {
+                    index->erase(fields, slotOfRow[row]);
+                    dropped++;
+                    break;
+                }
+            }
+        }
+    }
+    return dropped;
+}
+
+size_t EmployeeTable::rebuildIndexes() {
+    return indexes.rebuild(size(), [this](size_t row) { return fieldsAt(row); }, slotOfRow);
+}
+
+size_t EmployeeTable::size() const {
+    return ids.size();
+}
+
+void EmployeeTable::clear() {
+    ids.clear();
+    names.clear();
+    foldedNames.clear();
+    titleCodes.clear();
+    titleDictionary.clear();
+    nameTrigrams.clear();
+    indexes.clear();
+    emails.clear();
+    salaries.clear();
+    ages.clear();
+    salaryTexts.clear();
+    ageTexts.clear();
+    slotOfRow.clear();
+    handles.clear();
+    rowById.clear();
+    highestNumericId = 0;
+}
+
+void EmployeeTable::reserve(size_t rows) {
+    ids.reserve(rows);
+    names.reserve(rows);
+    foldedNames.reserve(rows);
+    titleCodes.reserve(rows);
+    emails.reserve(rows);
+    salaries.reserve(rows);
+    ages.reserve(rows);
+    salaryTexts.reserve(rows);
+    ageTexts.reserve(rows);
+    slotOfRow.reserve(rows);
+    rowById.reserve(rows);
+}
+
+void EmployeeTable::upsert(const Employee& employee) {
+    EmployeeId id = EmployeeId::parse(employee.getId());
+    auto existing = findRow(id);
+    if (existing) {
+        size_t row = *existing;
+        if (!bulkLoading) {
+            indexes.update(fieldsAt(row), fieldsOf(employee), slotOfRow[row]);
+        }
+        std::uint32_t code = titleCodes[row];
+        if (titleDictionary.title(code) != employee.getTitle()) {
+            titleDictionary.remove(code, row);
+            titleCodes.mutableAt(row) = titleDictionary.add(employee.getTitle(), row);
+        }
+        setRow(row, employee);
+        return;
+    }
+
+    size_t row = ids.size();
+    if (id.isNumber()) {
+        highestNumericId = std::max(highestNumericId, id.number());
+    }
+    ids.push_back(std::move(id));
+    names.push_back(std::string_view());
+    foldedNames.push_back(std::string_view());
+    titleCodes.push_back(titleDictionary.add(employee.getTitle(), row));
+    emails.push_back(std::string_view());
+    salaries.push_back(kNotNumeric);
+    ages.push_back(kNotNumeric);
+    salaryTexts.push_back(std::string_view());
+    ageTexts.push_back(std::string_view());
+    slotOfRow.push_back(handles.acquire(static_cast<std::uint32_t>(row)).slot);
+    setRow(row, employee);
+    rowById.insert(ids[row].hash(), static_cast<std::uint32_t>(row), idMatches(ids[row]));
+    if (!bulkLoading) {
+        indexes.insert(fieldsAt(row), slotOfRow[row]);
+    }
+}
+
+bool EmployeeTable::erase(std::string_view text) {
+    auto found = findRow(text);
+    if (!found) {
+        return false;
+    }
+    eraseRow(*found);
+    return true;
+}
+
+void EmployeeTable::eraseRow(size_t row) {
+    // Keep the columns dense: move the last row into the freed slot
+    size_t last = ids.size() - 1;
+    rowById.erase(ids[row].hash(), idMatches(ids[row]));
+    titleDictionary.remove(titleCodes[row], row);
+    nameTrigrams.remove(slotOfRow[row], names[row]);
+    if (!bulkLoading) {
+        indexes.erase(fieldsAt(row), slotOfRow[row]);
+    }
+    handles.release(slotOfRow[row]);
+    if (row != last) {
+        titleDictionary.moveRow(titleCodes[last], last, row);
+        rowById.relocate(ids[last].hash(), static_cast<std::uint32_t>(row), idMatches(ids[last]));
+        ids.mutableAt(row) = std::move(ids.mutableAt(last));
+        foldedNames.set(row, names[last]);
+        names.set(row, names[last]);
+        titleCodes.mutableAt(row) = titleCodes[last];
+        emails.set(row, emails[last]);
+        salaries.mutableAt(row) = salaries[last];
+        ages.mutableAt(row) = ages[last];
+        salaryTexts.set(row, salaryTexts[last]);
+        ageTexts.set(row, ageTexts[last]);
+        slotOfRow.mutableAt(row) = slotOfRow[last];
+        handles.move(slotOfRow[row], static_cast<std::uint32_t>(row));
+    }
+
+    ids.pop_back();
+    names.pop_back();
+    foldedNames.pop_back();
+    titleCodes.pop_back();
+    emails.pop_back();
+    salaries.pop_back();
+    ages.pop_back();
+    salaryTexts.pop_back();
+    ageTexts.pop_back();
+    slotOfRow.pop_back();
+}
+
+std::optional<size_t> EmployeeTable::findRow(std::string_view id) const {
+    return findRow(EmployeeId::borrow(id));
+}
+
+std::optional<size_t> EmployeeTable::findRow(const EmployeeId& id) const {
+    auto row = rowById.find(id.hash(), idMatches(id));
+    if (!row) {
+        return std::nullopt;
+    }
+    return *row;
+}
+
+bool EmployeeTable::contains(std::string_view id) const {
+    return findRow(id).has_value();
+}
+
+EmployeeHandle EmployeeTable::handleAt(size_t row) const {
+    return handles.handleOf(slotOfRow[row]);
+}
+
+std::optional<size_t> EmployeeTable::rowOf(EmployeeHandle handle) const {
+    auto row = handles.resolve(handle);
+    if (!row) {
+        return std::nullopt;
+    }
+    return *row;
+}
+
+std::uint64_t EmployeeTable::nextNumericId() const {
+    return highestNumericId + 1;
+}
+
+Employee EmployeeTable::row(size_t row) const {
+    return Employee(ids[row].toString(), std::string(names[row]), numberText(salaries[row], salaryTexts[row]),
+                    numberText(ages[row], ageTexts[row]), titleDictionary.title(titleCodes[row]),
+                    std::string(emails[row]));
+}
+
+const EmployeeId& EmployeeTable::idAt(size_t row) const {
+    return ids[row];
+}
+
+const TextColumn& EmployeeTable::nameColumn() const {
+    return names;
+}
+
+const FoldedTextColumn& EmployeeTable::foldedNameColumn() const {
+    return foldedNames;
+}
+
+const ChunkedColumn<std::uint32_t>& EmployeeTable::titleCodeColumn() const {
+    return titleCodes;
+}
+
+const TitleDictionary& EmployeeTable::titles() const {
+    return titleDictionary;
+}
+
+std::vector<size_t> EmployeeTable::rowsWithNameContaining(std::string_view needle) const {
+    std::string folded = TrigramIndex::fold(needle);
+    std::vector<size_t> rows;
+    if (folded.size() < TrigramIndex::kMinQueryLength) {
+        foldedNames.forEachContaining(folded, [&rows](size_t row) { rows.push_back(row); });
+        return rows;
+    }
+
+    // Having every trigram does not mean they are adjacent, so check each candidate
+    for (std::uint32_t slot : nameTrigrams.candidates(folded)) {
+        size_t row = handles.rowOfSlot(slot);
+        if (foldedNames[row].find(folded) != std::string_view::npos) {
+            rows.push_back(row);
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+size_t EmployeeTable::nameContainingEstimate(std::string_view needle) const {
+    return nameTrigrams.estimate(TrigramIndex::fold(needle));
+}
+
+const ChunkedColumn<std::int32_t>& EmployeeTable::salaryColumn() const {
+    return salaries;
+}
+
+EmployeeFields EmployeeTable::fieldsAt(size_t row) const {
+    return EmployeeFields{names[row], titleDictionary.title(titleCodes[row]), emails[row], salaries[row], ages[row]};
+}
+
+EmployeeFields EmployeeTable::fieldsOf(const Employee& employee) {
+    std::string originalText;
+    return EmployeeFields{employee.getName(), employee.getTitle(), employee.getEmail(),
+                          parseNumber(employee.getSalary(), originalText), parseNumber(employee.getAge(), originalText)};
+}
+
+const SecondaryIndexes& EmployeeTable::secondaryIndexes() const {
+    return indexes;
+}
+
+const SecondaryIndexBase* EmployeeTable::uniqueConflict(const Employee& employee) const {
+    auto holder = indexes.uniqueHolder(fieldsOf(employee));
+    if (!holder || ids[handles.rowOfSlot(holder->second)] == EmployeeId::borrow(employee.getId())) {
+        return nullptr;
+    }
+    return holder->first;
+}
+
+size_t EmployeeTable::rowOfSlot(std::uint32_t slot) const {
+    return handles.rowOfSlot(slot);
+}
+
+const ChunkedColumn<std::int32_t>& EmployeeTable::ageColumn() const {
+    return ages;
+}
+
+size_t EmployeeTable::indexMemoryBytes() const {
+    return rowById.memoryBytes();
+}
@@ -0,0 +1,155 @@
+#ifndef EMPLOYEE_TABLE_H
+#define EMPLOYEE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "chunked_column.h"
+#include "employee.h"
+#include "employee_id.h"
+#include "employee_indexes.h"
+#include "flat_hash_index.h"
+#include "folded_text_column.h"
+#include "handle_slab.h"
+#include "text_column.h"
+#include "title_dictionary.h"
+#include "trigram_index.h"
+
+// Employees stored as columns addressed by a dense row index. Ids are kept as
+// compact EmployeeId keys and turned back into text only when a row is
+// materialized. Salary and age are parsed once on insert into contiguous int32
+// arrays so aggregates are plain linear passes; their original text is kept
+// only when it differs from the canonical integer. Titles are
+// dictionary-encoded: each row holds a code into titleDictionary, which also
+// keeps the rows per title. Names are indexed by trigram for substring
+// search, and kept case-folded and packed for the searches too short for
+// trigrams; other fields get the secondary indexes declared in
+// employee_indexes.h, kept in step with every write. Erasing moves the last
+// row into the hole, so row indexes are only stable until the next erase; an
+// EmployeeHandle survives such moves and detects erasure. Copies are cheap
+// enough to publish a new version per write: every column, the id index, the
+// handles, the title postings and the secondary indexes are kept in chunks,
+// pages or nodes shared with the copy, so copying costs a pointer per chunk
+// and a write clones only what it touches. Text columns are packed per chunk,
+// so that clone is two buffer copies rather than a string per row.
+class EmployeeTable {
+private:
+    ChunkedColumn<EmployeeId> ids;
+    TextColumn names;
+    ChunkedColumn<std::uint32_t> titleCodes;
+    TextColumn emails;
+    ChunkedColumn<std::int32_t> salaries;
+    ChunkedColumn<std::int32_t> ages;
+    TextColumn salaryTexts;  // empty when the column value is canonical
+    TextColumn ageTexts;
+    ChunkedColumn<std::uint32_t> slotOfRow;  // handle slot of each row
+    HandleSlab handles;
+    FlatHashIndex rowById;
+    TitleDictionary titleDictionary;
+    FoldedTextColumn foldedNames;
+    TrigramIndex nameTrigrams;  // keyed by handle slot
+    SecondaryIndexes indexes;   // keyed by handle slot
+    bool bulkLoading = false;   // indexes are rebuilt by endBulkLoad()
+
+    static std::int32_t parseNumber(const std::string& text, std::string& originalText);
+    static std::string numberText(std::int32_t value, std::string_view originalText);
+    static EmployeeFields fieldsOf(const Employee& employee);
+    size_t rebuildIndexes();
+    void setRow(size_t row, const Employee& employee);
+
+    std::uint64_t highestNumericId;        // high-water mark, not lowered by erase
+
+    auto idMatches(const EmployeeId& id) const {
+        return [this, &id](std::uint32_t row) { return ids[row] == id; };
+    }
+
+public:
+    EmployeeTable();
+
+    size_t size() const;
+    void clear();
+    void reserve(size_t rows);
+
+    // Between these, the secondary indexes are left alone and then built in
+    // one pass, which is much cheaper than maintaining them row by row during
+    // a load. Returns the rows unique indexes left out as duplicates.
+    void beginBulkLoad();
+    size_t endBulkLoad();
+
+    // After a load, leave out of the unique indexes the keys that any of
+    // others, the tables of other shards, already holds; returns the rows
+    // left out
+    size_t dropUniqueKeysHeldBy(const std::vector<const EmployeeTable*>& others);
+
+    // Insert a new row or replace the one with the same id
+    void upsert(const Employee& employee);
+    bool erase(std::string_view id);
+    void eraseRow(size_t row);
+
+    // Lookups take a view so request paths can probe without allocating
+    std::optional<size_t> findRow(std::string_view id) const;
+    std::optional<size_t> findRow(const EmployeeId& id) const;
+    bool contains(std::string_view id) const;
+
+    // Handle of a row, and the row a handle currently points at (nothing once
+    // the record has been erased)
+    EmployeeHandle handleAt(size_t row) const;
+    std::optional<size_t> rowOf(EmployeeHandle handle) const;
+
+    // One above the largest numeric id ever stored since the last clear()
+    std::uint64_t nextNumericId() const;
+
+    // Materialize one row as an Employee
+    Employee row(size_t row) const;
+
+    const EmployeeId& idAt(size_t row) const;
+    const TextColumn& nameColumn() const;
+    const FoldedTextColumn& foldedNameColumn() const;
+    const ChunkedColumn<std::uint32_t>& titleCodeColumn() const;
+    const TitleDictionary& titles() const;
+
+    // Rows whose name contains needle, ignoring case, in ascending order.
+    // Needles of three or more characters go through the trigram index and
+    // only its candidates are compared; shorter ones scan the folded names.
+    std::vector<size_t> rowsWithNameContaining(std::string_view needle) const;
+
+    // Upper bound on the rows whose name contains a needle of at least
+    // TrigramIndex::kMinQueryLength characters, from the trigram index alone
+    size_t nameContainingEstimate(std::string_view needle) const;
+    const ChunkedColumn<std::int32_t>& salaryColumn() const;
+
+    // Indexable values of a row, viewing the columns until the next write
+    EmployeeFields fieldsAt(size_t row) const;
+
+    // A declared secondary index, null if the table has none of that type
+    template <typename Index>
+    const Index* index() const {
+        return indexes.find<Index>();
+    }
+
+    // Add an index beyond the declared ones and build it from the current rows
+    template <typename Index>
+    void declareIndex() {
+        if (indexes.declare<Index>() && !bulkLoading) {
+            rebuildIndexes();
+        }
+    }
+
+    const SecondaryIndexes& secondaryIndexes() const;
+
+    // Unique index that already holds one of employee's keys for a different
+    // employee, or null. Uniqueness across shards is up to the caller.
+    const SecondaryIndexBase* uniqueConflict(const Employee& employee) const;
+
+    // Row currently holding the record of a handle slot taken from an index
+    size_t rowOfSlot(std::uint32_t slot) const;
+    const ChunkedColumn<std::int32_t>& ageColumn() const;
+
+    // Bytes held by the id index
+    size_t indexMemoryBytes() const;
+};
+
+#endif // EMPLOYEE_TABLE_H
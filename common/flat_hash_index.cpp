@@ -0,0 +1,94 @@
+#include "flat_hash_index.h"
+#include <algorithm>
+
+FlatHashIndex::FlatHashIndex() : groupMask(0), count(0), tombstones(0) {
+    rehash(1);
+}
+
+size_t FlatHashIndex::size() const {
+    return count;
+}
+
+void FlatHashIndex::clear() {
+    rehash(1);
+}
+
+void FlatHashIndex::reserve(size_t rows) {
+    size_t groups = 1;
+    while (groups * kGroupSize * 7 / 8 < rows) {
+        groups *= 2;
+    }
+    if (groups > groupMask + 1) {
+        rehash(groups);
+    }
+}
+
+size_t FlatHashIndex::memoryBytes() const {
+    size_t bytes = pages.capacity() * sizeof(std::shared_ptr<Page>);
+    for (const auto& page : pages) {
+        bytes += page->control.capacity() * sizeof(std::int8_t) + page->slots.capacity() * sizeof(Slot);
+    }
+    return bytes;
+}
+
+FlatHashIndex::Page& FlatHashIndex::writablePage(size_t slot) {
+    auto& page = pages[slot / (kPageGroups * kGroupSize)];
+    if (page.use_count() > 1) {
+        page = std::make_shared<Page>(*page);
+    }
+    return *page;
+}
+
+void FlatHashIndex::setSlot(size_t slot, std::int8_t control, std::optional<Slot> value) {
+    Page& page = writablePage(slot);
+    size_t offset = slot % (kPageGroups * kGroupSize);
+    page.control[offset] = control;
+    if (value) {
+        page.slots[offset] = *value;
+    }
+}
+
+void FlatHashIndex::place(std::uint32_t hash, std::uint32_t row) {
+    // Keep at most 7/8 of the slots in use, counting tombstones; if most of
+    // that is tombstones, rebuilding at the same size is enough
+    size_t capacity = (groupMask + 1) * kGroupSize;
+    if ((count + tombstones + 1) * 8 > capacity * 7) {
+        rehash((count + 1) * 8 > capacity * 7 / 2 ? (groupMask + 1) * 2 : groupMask + 1);
+    }
+
+    size_t target = npos;
+    probe(hash, [&](size_t group) {
+        std::uint32_t mask = matchFree(group);
+        if (mask == 0) {
+            return false;
+        }
+        target = group * kGroupSize + lowestBit(mask);
+        return true;
+    });
+
+    if (groupControl(target / kGroupSize)[target % kGroupSize] == kDeleted) {
+        tombstones--;
+    }
+    setSlot(target, h2(hash), Slot{hash, row});
+    count++;
+}
+
+void FlatHashIndex::rehash(size_t groupCount) {
+    std::vector<std::shared_ptr<Page>> oldPages(groupCount < kPageGroups ? 1 : groupCount / kPageGroups);
+    size_t pageSlots = std::min(groupCount, kPageGroups) * kGroupSize;
+    for (auto& page : oldPages) {
+        page = std::make_shared<Page>(Page{std::vector<std::int8_t>(pageSlots, kEmpty), std::vector<Slot>(pageSlots)});
+    }
+    oldPages.swap(pages);
+    groupMask = groupCount - 1;
+    count = 0;
+    tombstones = 0;
+
+    for (const auto& page : oldPages) {
+        for (size_t slot = 0; slot < page->control.size(); slot++) {
+            if (page->control[slot] >= 0) {
+                place(page->slots[slot].hash, page->slots[slot].row);
+            }
+        }
+    }
+}
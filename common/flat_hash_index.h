@@ -0,0 +1,208 @@
+#ifndef FLAT_HASH_INDEX_H
+#define FLAT_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Open-addressing hash index from a key to a table row, laid out like a Swiss
+// table: one control byte per slot holding 7 bits of the hash, probed 16 at a
+// time (SSE2 when available), and a flat slot array of {hash, row}. Keys are
+// not stored; callers pass the key's hash and a predicate that tells whether
+// a row holds the key, so lookups work on any key representation without
+// building a temporary. Groups are stored in pages of kPageGroups that copies
+// of the index share, like the chunks of ChunkedColumn: copying costs one
+// pointer per page, and a write clones the one page it touches.
+class FlatHashIndex {
+public:
+    static constexpr size_t kGroupSize = 16;
+
+private:
+    static constexpr std::int8_t kEmpty = -128;
+    static constexpr std::int8_t kDeleted = -2;
+    static constexpr size_t kPageGroups = 64;
+
+    struct Slot {
+        std::uint32_t hash;
+        std::uint32_t row;
+    };
+
+    // Control bytes and slots of up to kPageGroups consecutive groups
+    struct Page {
+        std::vector<std::int8_t> control;
+        std::vector<Slot> slots;
+    };
+
+    std::vector<std::shared_ptr<Page>> pages;
+    size_t groupMask;   // group count - 1; the group count is a power of two
+    size_t count;
+    size_t tombstones;
+
+    static std::uint32_t foldHash(std::uint64_t hash) {
+        return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+    }
+
+    static std::int8_t h2(std::uint32_t hash) {
+        return static_cast<std::int8_t>(hash & 0x7F);
+    }
+
+    static size_t h1(std::uint32_t hash) {
+        return hash >> 7;
+    }
+
+    const std::int8_t* groupControl(size_t group) const {
+        return pages[group / kPageGroups]->control.data() + (group % kPageGroups) * kGroupSize;
+    }
+
+    const Slot& slotAt(size_t slot) const {
+        return pages[slot / (kPageGroups * kGroupSize)]->slots[slot % (kPageGroups * kGroupSize)];
+    }
+
+    // Page holding a slot, cloned first if a copy of the index still shares
+    // it; copies are made while no one writes to this one, so use_count() is
+    // stable here
+    Page& writablePage(size_t slot);
+
+    void setSlot(size_t slot, std::int8_t control, std::optional<Slot> value = std::nullopt);
+
+    // Bit i is set when control byte i of the group equals value
+    std::uint32_t matchByte(size_t group, std::int8_t value) const {
+        const std::int8_t* bytes = groupControl(group);
+#if defined(__SSE2__)
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#else
+        std::uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupSize; i++) {
+            mask |= static_cast<std::uint32_t>(bytes[i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Bit i is set when slot i of the group is empty or deleted
+    std::uint32_t matchFree(size_t group) const {
+        const std::int8_t* bytes = groupControl(group);
+#if defined(__SSE2__)
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl)));
+#else
+        std::uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupSize; i++) {
+            mask |= static_cast<std::uint32_t>(bytes[i] < -1) << i;
+        }
+        return mask;
+#endif
+    }
+
+    static int lowestBit(std::uint32_t mask) {
+        return __builtin_ctz(mask);
+    }
+
+    // Walk the triangular group probe sequence for hash. visit(group) returns
+    // true to stop.
+    template <typename Visit>
+    void probe(std::uint32_t hash, Visit visit) const {
+        size_t group = h1(hash) & groupMask;
+        for (size_t step = 1; !visit(group); step++) {
+            group = (group + step) & groupMask;
+        }
+    }
+
+    // Slot holding a matching row, or npos
+    template <typename Matches>
+    size_t findSlot(std::uint32_t hash, Matches matches) const {
+        if (count == 0) {
+            return npos;
+        }
+        size_t found = npos;
+        probe(hash, [&](size_t group) {
+            for (std::uint32_t mask = matchByte(group, h2(hash)); mask != 0; mask &= mask - 1) {
+                size_t slot = group * kGroupSize + lowestBit(mask);
+                if (slotAt(slot).hash == hash && matches(slotAt(slot).row)) {
+                    found = slot;
+                    return true;
+                }
+            }
+            return matchByte(group, kEmpty) != 0;
+        });
+        return found;
+    }
+
+    void place(std::uint32_t hash, std::uint32_t row);
+    void rehash(size_t groupCount);
+
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    FlatHashIndex();
+
+    size_t size() const;
+    void clear();
+
+    // Size the table for at least rows entries without rehashing
+    void reserve(size_t rows);
+
+    // Bytes held by the control and slot arrays of every page
+    size_t memoryBytes() const;
+
+    template <typename Matches>
+    std::optional<std::uint32_t> find(std::uint64_t hash, Matches matches) const {
+        size_t slot = findSlot(foldHash(hash), matches);
+        if (slot == npos) {
+            return std::nullopt;
+        }
+        return slotAt(slot).row;
+    }
+
+    // Add row under hash; false if a row matching the key is already present
+    template <typename Matches>
+    bool insert(std::uint64_t hash, std::uint32_t row, Matches matches) {
+        std::uint32_t folded = foldHash(hash);
+        if (findSlot(folded, matches) != npos) {
+            return false;
+        }
+        place(folded, row);
+        return true;
+    }
+
+    template <typename Matches>
+    bool erase(std::uint64_t hash, Matches matches) {
+        size_t slot = findSlot(foldHash(hash), matches);
+        if (slot == npos) {
+            return false;
+        }
+
+        // A group that still has an empty slot never overflowed into the next
+        // one, so nothing probes past it and the slot can be emptied outright
+        size_t group = slot / kGroupSize;
+        if (matchByte(group, kEmpty) != 0) {
+            setSlot(slot, kEmpty);
+        } else {
+            setSlot(slot, kDeleted);
+            tombstones++;
+        }
+        count--;
+        return true;
+    }
+
+    // Point the entry for the key at a new row (after the table moved it)
+    template <typename Matches>
+    bool relocate(std::uint64_t hash, std::uint32_t row, Matches matches) {
+        size_t slot = findSlot(foldHash(hash), matches);
+        if (slot == npos) {
+            return false;
+        }
+        std::uint32_t folded = slotAt(slot).hash;
+        setSlot(slot, h2(folded), Slot{folded, row});
+        return true;
+    }
+};
+
+#endif // FLAT_HASH_INDEX_H
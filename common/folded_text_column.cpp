@@ -0,0 +1,15 @@
+#include "folded_text_column.h"
+#include "trigram_index.h"
+
+void FoldedTextColumn::push_back(std::string_view text) {
+    Chunk& chunk = appendChunk();
+    for (char c : text) {
+        chunk.text.push_back(TrigramIndex::fold(c));
+    }
+    chunk.ends.push_back(static_cast<std::uint32_t>(chunk.text.size()));
+    count++;
+}
+
+void FoldedTextColumn::set(size_t row, std::string_view text) {
+    TextColumn::set(row, TrigramIndex::fold(text));
+}
@@ -0,0 +1,52 @@
+#ifndef FOLDED_TEXT_COLUMN_H
+#define FOLDED_TEXT_COLUMN_H
+
+#include <cstddef>
+#include <string_view>
+#include "substring_search.h"
+#include "text_column.h"
+
+// Case-folded copy of a text column for substring search. Each chunk of rows
+// packs its folded values back to back into one buffer, as in TextColumn, so a
+// search runs the vector kernel over the whole buffer instead of folding and
+// comparing row by row, and maps each match back to its row.
+class FoldedTextColumn : public TextColumn {
+public:
+    // Values are folded on the way in
+    void push_back(std::string_view text);
+    void set(size_t row, std::string_view text);
+
+    // Calls visit(row) for every row containing an already folded needle, in
+    // ascending order
+    template <typename Visit>
+    void forEachContaining(std::string_view foldedNeedle, Visit&& visit) const {
+        for (size_t index = 0; index < chunks.size(); index++) {
+            const Chunk& chunk = *chunks[index];
+            const size_t base = index * kChunkSize;
+            if (foldedNeedle.empty()) {
+                for (size_t row = 0; row < chunk.ends.size(); row++) {
+                    visit(base + row);
+                }
+                continue;
+            }
+
+            size_t row = 0;
+            size_t at = findSubstring(chunk.text, foldedNeedle);
+            while (at != std::string_view::npos) {
+                while (chunk.ends[row] <= at) {
+                    row++;
+                }
+                if (at + foldedNeedle.size() <= chunk.ends[row]) {
+                    visit(base + row);
+                    at = findSubstring(chunk.text, foldedNeedle, chunk.ends[row]);
+                    row++;
+                } else {
+                    // Runs into the next row, so not a match
+                    at = findSubstring(chunk.text, foldedNeedle, at + 1);
+                }
+            }
+        }
+    }
+};
+
+#endif // FOLDED_TEXT_COLUMN_H
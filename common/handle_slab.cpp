@@ -0,0 +1,36 @@
+#include "handle_slab.h"
+
+EmployeeHandle HandleSlab::acquire(std::uint32_t row) {
+    std::uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<std::uint32_t>(slots.size());
+        slots.push_back(Slot{0, 0});
+    }
+    slots.mutableAt(slot).row = row;
+    return EmployeeHandle{slot, slots[slot].generation};
+}
+
+void HandleSlab::release(std::uint32_t slot) {
+    slots.mutableAt(slot).generation++;
+    freeSlots.push_back(slot);
+}
+
+void HandleSlab::move(std::uint32_t slot, std::uint32_t row) {
+    slots.mutableAt(slot).row = row;
+}
+
+EmployeeHandle HandleSlab::handleOf(std::uint32_t slot) const {
+    return EmployeeHandle{slot, slots[slot].generation};
+}
+
+void HandleSlab::clear() {
+    // Keep the generations so handles from before the clear stay stale
+    freeSlots.clear();
+    for (std::uint32_t slot = static_cast<std::uint32_t>(slots.size()); slot > 0; slot--) {
+        slots.mutableAt(slot - 1).generation++;
+        freeSlots.push_back(slot - 1);
+    }
+}
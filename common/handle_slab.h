@@ -0,0 +1,71 @@
+#ifndef HANDLE_SLAB_H
+#define HANDLE_SLAB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include "chunked_column.h"
+
+// Stable reference to one employee record. It stays valid while the record
+// exists, however rows are moved around, and goes stale once the record is
+// erased, even if its slot has been reused since.
+struct EmployeeHandle {
+    std::uint32_t slot = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t generation = 0;
+    std::uint32_t shard = 0;  // which slab issued it, for owners with several (EmployeeAPI)
+
+    bool operator==(const EmployeeHandle& other) const {
+        return slot == other.slot && generation == other.generation && shard == other.shard;
+    }
+
+    bool operator!=(const EmployeeHandle& other) const {
+        return !(*this == other);
+    }
+};
+
+// Slab of generation-counted slots mapping handles to dense table rows.
+// Records themselves stay packed in the table's columns; only this 8-byte
+// indirection has holes, and freed slots are recycled through a free list.
+// Releasing a slot bumps its generation, so resolving an old handle is one
+// compare. Both the slots and the free list are chunked, so copies share
+// them and a write clones only the chunks it touches.
+class HandleSlab {
+private:
+    struct Slot {
+        std::uint32_t row;
+        std::uint32_t generation;
+    };
+
+    ChunkedColumn<Slot> slots;
+    ChunkedColumn<std::uint32_t> freeSlots;
+
+public:
+    // Give row a slot and return its handle
+    EmployeeHandle acquire(std::uint32_t row);
+
+    // Invalidate every handle to the slot and make it reusable
+    void release(std::uint32_t slot);
+
+    // The record in slot now lives at row
+    void move(std::uint32_t slot, std::uint32_t row);
+
+    EmployeeHandle handleOf(std::uint32_t slot) const;
+
+    // Current row of the record, or nothing if the handle is stale
+    std::optional<std::uint32_t> resolve(EmployeeHandle handle) const {
+        if (handle.slot >= slots.size() || slots[handle.slot].generation != handle.generation) {
+            return std::nullopt;
+        }
+        return slots[handle.slot].row;
+    }
+
+    // Current row of the record in a live slot
+    std::uint32_t rowOfSlot(std::uint32_t slot) const {
+        return slots[slot].row;
+    }
+
+    void clear();
+};
+
+#endif // HANDLE_SLAB_H
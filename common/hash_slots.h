@@ -0,0 +1,156 @@
+#ifndef HASH_SLOTS_H
+#define HASH_SLOTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "chunked_column.h"
+
+// Hash multimap from keys to handle slots for equality lookups in O(1).
+// Buckets are shared between copies and cloned on first write, and the bucket
+// table itself is a ChunkedColumn, so copying the map costs one pointer per
+// 1024 buckets and a write clones one small bucket and its table chunk.
+template <typename Key>
+class HashSlots {
+private:
+    struct Entry {
+        Key key;
+        std::uint32_t slot;
+    };
+
+    struct Bucket {
+        std::vector<Entry> entries;
+    };
+
+    static constexpr size_t kMinBuckets = 64;
+    static constexpr size_t kMaxLoad = 8;  // average entries per bucket before doubling
+
+    ChunkedColumn<std::shared_ptr<Bucket>> buckets;  // power of two in size, null while empty
+    size_t count = 0;
+
+    static size_t hashOf(const Key& key) {
+        std::uint64_t x = static_cast<std::uint64_t>(std::hash<Key>()(key));
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return static_cast<size_t>(x);
+    }
+
+    const Bucket* bucketFor(const Key& key) const {
+        return buckets.empty() ? nullptr : buckets[hashOf(key) & (buckets.size() - 1)].get();
+    }
+
+    // Buckets are only shared with other copies of the map, which are made
+    // while no one writes to this one, so use_count() is stable here
+    Bucket& writableBucket(const Key& key) {
+        auto& bucket = buckets.mutableAt(hashOf(key) & (buckets.size() - 1));
+        if (!bucket) {
+            bucket = std::make_shared<Bucket>();
+        } else if (bucket.use_count() > 1) {
+            bucket = std::make_shared<Bucket>(*bucket);
+        }
+        return *bucket;
+    }
+
+    void rehash(size_t bucketCount) {
+        ChunkedColumn<std::shared_ptr<Bucket>> old = std::move(buckets);
+        buckets.clear();
+        buckets.reserve(bucketCount);
+        for (size_t i = 0; i < bucketCount; i++) {
+            buckets.push_back(nullptr);
+        }
+        old.forEach([this](const std::shared_ptr<Bucket>& bucket) {
+            if (bucket) {
+                for (const Entry& entry : bucket->entries) {
+                    writableBucket(entry.key).entries.push_back(entry);
+                }
+            }
+        });
+    }
+
+public:
+    void insert(const Key& key, std::uint32_t slot) {
+        if (buckets.empty() || count >= buckets.size() * kMaxLoad) {
+            rehash(buckets.empty() ? kMinBuckets : buckets.size() * 2);
+        }
+        writableBucket(key).entries.push_back(Entry{key, slot});
+        count++;
+    }
+
+    // Make room for entries without doubling on the way, for loads
+    void reserve(size_t entries) {
+        size_t target = kMinBuckets;
+        while (target * kMaxLoad < entries) {
+            target *= 2;
+        }
+        if (target > buckets.size()) {
+            rehash(target);
+        }
+    }
+
+    // False if the entry was not there
+    bool erase(const Key& key, std::uint32_t slot) {
+        const Bucket* shared = bucketFor(key);
+        if (!shared) {
+            return false;
+        }
+        size_t position = 0;
+        while (position < shared->entries.size() &&
+               !(shared->entries[position].slot == slot && shared->entries[position].key == key)) {
+            position++;
+        }
+        if (position == shared->entries.size()) {
+            return false;  // not here, so nothing to clone
+        }
+        auto& entries = writableBucket(key).entries;
+        entries[position] = std::move(entries.back());
+        entries.pop_back();
+        count--;
+        return true;
+    }
+
+    void clear() {
+        buckets.clear();
+        count = 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Calls visit(slot) for every entry with key, in no particular order
+    template <typename Visit>
+    void forEach(const Key& key, Visit&& visit) const {
+        if (const Bucket* bucket = bucketFor(key)) {
+            for (const Entry& entry : bucket->entries) {
+                if (entry.key == key) {
+                    visit(entry.slot);
+                }
+            }
+        }
+    }
+
+    // Some slot with key, if any
+    std::optional<std::uint32_t> findAny(const Key& key) const {
+        if (const Bucket* bucket = bucketFor(key)) {
+            for (const Entry& entry : bucket->entries) {
+                if (entry.key == key) {
+                    return entry.slot;
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    size_t countOf(const Key& key) const {
+        size_t matches = 0;
+        forEach(key, [&matches](std::uint32_t) { matches++; });
+        return matches;
+    }
+};
+
+#endif // HASH_SLOTS_H
@@ -0,0 +1,324 @@
+#ifndef INDEX_TREE_H
+#define INDEX_TREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Persistent order-statistics tree of (key, slot) entries, ordered by key and
+// then slot. It is a treap whose priorities are hashed from the entry, so the
+// same entries always give the same shape, and every node counts the entries
+// below it, so ranks and positions are O(log n) and walking K entries from any
+// point is O(log n + K). Nodes are immutable and shared: a write copies only
+// the path it changes, so copying the tree is a pointer copy and older table
+// versions keep reading the tree they were published with.
+template <typename Key, typename Compare = std::less<Key>>
+class IndexTree {
+public:
+    struct Entry {
+        Key key;
+        std::uint32_t slot;
+    };
+
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node {
+        Key key;
+        std::uint32_t slot;
+        std::uint32_t priority;  // heap order
+        std::uint32_t count;     // entries in this subtree
+        NodePtr left;
+        NodePtr right;
+    };
+
+    NodePtr root;
+    // Ends of the tree, kept by every write so they are O(1) to read. They
+    // point into nodes that root keeps alive, in this copy and any other.
+    const Node* firstNode = nullptr;
+    const Node* lastNode = nullptr;
+
+    static bool keyBefore(const Key& a, const Key& b) {
+        return Compare()(a, b);
+    }
+
+    static bool before(const Key& key, std::uint32_t slot, const Key& otherKey, std::uint32_t otherSlot) {
+        return keyBefore(key, otherKey) || (!keyBefore(otherKey, key) && slot < otherSlot);
+    }
+
+    static std::uint32_t priorityOf(const Key& key, std::uint32_t slot) {
+        std::uint64_t x = static_cast<std::uint64_t>(std::hash<Key>()(key)) ^
+                          (static_cast<std::uint64_t>(slot) * 0x9e3779b97f4a7c15ULL);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<std::uint32_t>(x);
+    }
+
+    static size_t countOf(const NodePtr& node) {
+        return node ? node->count : 0;
+    }
+
+    static NodePtr join(const Node& entry, NodePtr left, NodePtr right) {
+        auto count = static_cast<std::uint32_t>(1 + countOf(left) + countOf(right));
+        return std::make_shared<const Node>(Node{entry.key, entry.slot, entry.priority, count,
+                                                 std::move(left), std::move(right)});
+    }
+
+    // Entries before (key, slot), and the rest
+    static std::pair<NodePtr, NodePtr> split(const NodePtr& node, const Key& key, std::uint32_t slot) {
+        if (!node) {
+            return {nullptr, nullptr};
+        }
+        if (before(node->key, node->slot, key, slot)) {
+            auto [lower, upper] = split(node->right, key, slot);
+            return {join(*node, node->left, std::move(lower)), std::move(upper)};
+        }
+        auto [lower, upper] = split(node->left, key, slot);
+        return {std::move(lower), join(*node, std::move(upper), node->right)};
+    }
+
+    static NodePtr merge(const NodePtr& lower, const NodePtr& upper) {
+        if (!lower) {
+            return upper;
+        }
+        if (!upper) {
+            return lower;
+        }
+        if (lower->priority > upper->priority) {
+            return join(*lower, lower->left, merge(lower->right, upper));
+        }
+        return join(*upper, merge(lower, upper->left), upper->right);
+    }
+
+    static NodePtr insert(const NodePtr& node, const NodePtr& fresh) {
+        if (!node) {
+            return fresh;
+        }
+        if (fresh->priority > node->priority) {
+            auto [lower, upper] = split(node, fresh->key, fresh->slot);
+            return join(*fresh, std::move(lower), std::move(upper));
+        }
+        if (before(fresh->key, fresh->slot, node->key, node->slot)) {
+            return join(*node, insert(node->left, fresh), node->right);
+        }
+        return join(*node, node->left, insert(node->right, fresh));
+    }
+
+    static NodePtr erase(const NodePtr& node, const Key& key, std::uint32_t slot) {
+        if (!node) {
+            return node;
+        }
+        if (node->slot == slot && !keyBefore(key, node->key) && !keyBefore(node->key, key)) {
+            return merge(node->left, node->right);
+        }
+        if (before(key, slot, node->key, node->slot)) {
+            return join(*node, erase(node->left, key, slot), node->right);
+        }
+        return join(*node, node->left, erase(node->right, key, slot));
+    }
+
+    void refreshEnds() {
+        firstNode = lastNode = root.get();
+        while (firstNode && firstNode->left) {
+            firstNode = firstNode->left.get();
+        }
+        while (lastNode && lastNode->right) {
+            lastNode = lastNode->right.get();
+        }
+    }
+
+public:
+    // Walks entries in key order or in reverse; valid while the tree it came
+    // from is alive and unchanged
+    class Cursor {
+    private:
+        friend class IndexTree;
+        std::vector<const Node*> path;
+        bool descending = false;
+
+        // Push node and the chain of children towards the walk's start
+        void descend(const Node* node) {
+            for (; node; node = descending ? node->right.get() : node->left.get()) {
+                path.push_back(node);
+            }
+        }
+
+    public:
+        bool done() const {
+            return path.empty();
+        }
+
+        const Key& key() const {
+            return path.back()->key;
+        }
+
+        std::uint32_t slot() const {
+            return path.back()->slot;
+        }
+
+        void next() {
+            const Node* node = path.back();
+            path.pop_back();
+            descend(descending ? node->left.get() : node->right.get());
+        }
+    };
+
+    void insert(const Key& key, std::uint32_t slot) {
+        auto fresh = std::make_shared<const Node>(Node{key, slot, priorityOf(key, slot), 1, nullptr, nullptr});
+        root = insert(root, fresh);
+        refreshEnds();
+    }
+
+    void erase(const Key& key, std::uint32_t slot) {
+        root = erase(root, key, slot);
+        refreshEnds();
+    }
+
+    void clear() {
+        root.reset();
+        refreshEnds();
+    }
+
+    // Replace the contents in one pass, for loads: O(n log n) to sort and
+    // O(n) to build, instead of a path copy per entry
+    void assign(std::vector<Entry> entries) {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return before(a.key, a.slot, b.key, b.slot);
+        });
+
+        // Cartesian tree over the sorted entries: the stack holds the right
+        // spine, and each node covers the entries from its start up to where
+        // it is popped
+        struct Open {
+            std::shared_ptr<Node> node;
+            size_t start;
+        };
+        std::vector<Open> spine;
+        auto close = [&spine](size_t end) {
+            Open open = std::move(spine.back());
+            spine.pop_back();
+            open.node->count = static_cast<std::uint32_t>(end - open.start);
+            return open;
+        };
+        for (size_t i = 0; i < entries.size(); i++) {
+            std::uint32_t priority = priorityOf(entries[i].key, entries[i].slot);
+            auto node = std::make_shared<Node>(Node{std::move(entries[i].key), entries[i].slot, priority, 1,
+                                                    nullptr, nullptr});
+            size_t start = i;
+            while (!spine.empty() && spine.back().node->priority < node->priority) {
+                Open closed = close(i);
+                start = closed.start;
+                node->left = std::move(closed.node);
+            }
+            if (!spine.empty()) {
+                spine.back().node->right = node;
+            }
+            spine.push_back(Open{std::move(node), start});
+        }
+        root.reset();
+        while (!spine.empty()) {
+            root = close(entries.size()).node;
+        }
+        refreshEnds();
+    }
+
+    size_t size() const {
+        return countOf(root);
+    }
+
+    bool empty() const {
+        return !root;
+    }
+
+    // Smallest and largest keys; null when empty
+    const Key* first() const {
+        return firstNode ? &firstNode->key : nullptr;
+    }
+
+    const Key* last() const {
+        return lastNode ? &lastNode->key : nullptr;
+    }
+
+    // Entries whose key orders before key
+    size_t countBefore(const Key& key) const {
+        size_t count = 0;
+        for (const Node* node = root.get(); node;) {
+            if (keyBefore(node->key, key)) {
+                count += 1 + countOf(node->left);
+                node = node->right.get();
+            } else {
+                node = node->left.get();
+            }
+        }
+        return count;
+    }
+
+    // Entries whose key does not order after key
+    size_t countUpTo(const Key& key) const {
+        size_t count = 0;
+        for (const Node* node = root.get(); node;) {
+            if (!keyBefore(key, node->key)) {
+                count += 1 + countOf(node->left);
+                node = node->right.get();
+            } else {
+                node = node->left.get();
+            }
+        }
+        return count;
+    }
+
+    // Key of the entry at a zero-based position in key order; null past the end
+    const Key* keyAt(size_t position) const {
+        for (const Node* node = root.get(); node;) {
+            size_t leftCount = countOf(node->left);
+            if (position < leftCount) {
+                node = node->left.get();
+            } else if (position == leftCount) {
+                return &node->key;
+            } else {
+                position -= leftCount + 1;
+                node = node->right.get();
+            }
+        }
+        return nullptr;
+    }
+
+    // Walk from the first entry
+    Cursor ascending() const {
+        Cursor cursor;
+        cursor.descend(root.get());
+        return cursor;
+    }
+
+    // Walk from the first entry whose key does not order before lower
+    Cursor ascendingFrom(const Key& lower) const {
+        Cursor cursor;
+        for (const Node* node = root.get(); node;) {
+            if (keyBefore(node->key, lower)) {
+                node = node->right.get();
+            } else {
+                cursor.path.push_back(node);
+                node = node->left.get();
+            }
+        }
+        return cursor;
+    }
+
+    // Walk from the last entry backwards
+    Cursor descending() const {
+        Cursor cursor;
+        cursor.descending = true;
+        cursor.descend(root.get());
+        return cursor;
+    }
+};
+
+#endif // INDEX_TREE_H
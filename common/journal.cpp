@@ -0,0 +1,142 @@
+#include "journal.h"
+#include "logger.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Journal::Journal(const std::string& path) : path(path), fd(-1), bytesWritten(0) {}
+
+Journal::~Journal() {
+    close();
+}
+
+bool Journal::open() {
+    if (fd >= 0) {
+        return true;
+    }
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        Logger::get()->error("Could not open journal {}: {}", path, std::strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    bytesWritten = (::fstat(fd, &st) == 0) ? static_cast<std::uintmax_t>(st.st_size) : 0;
+    Logger::get()->debug("Opened journal {} ({} bytes)", path, bytesWritten);
+    return true;
+}
+
+void Journal::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool Journal::isOpen() const {
+    return fd >= 0;
+}
+
+bool Journal::append(const std::string& record) {
+    return appendBatch({record});
+}
+
+bool Journal::appendBatch(const std::vector<std::string>& records) {
+    if (fd < 0) {
+        Logger::get()->error("Journal {} is not open", path);
+        return false;
+    }
+
+    std::string buffer;
+    for (const auto& record : records) {
+        buffer += record;
+        buffer.push_back('\n');
+    }
+
+    const char* data = buffer.data();
+    size_t remaining = buffer.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Logger::get()->error("Failed to append to journal {}: {}", path, std::strerror(errno));
+            return false;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+
+    bytesWritten += buffer.size();
+    return true;
+}
+
+bool Journal::sync() {
+    if (fd < 0 || ::fdatasync(fd) != 0) {
+        Logger::get()->error("Failed to sync journal {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+std::uintmax_t Journal::size() const {
+    return bytesWritten;
+}
+
+bool Journal::rotate() {
+    close();
+
+    if (std::rename(path.c_str(), rotatedPath().c_str()) != 0 && errno != ENOENT) {
+        Logger::get()->error("Could not rotate journal {}: {}", path, std::strerror(errno));
+        open();
+        return false;
+    }
+
+    bytesWritten = 0;
+    return open();
+}
+
+bool Journal::removeRotated() {
+    if (std::remove(rotatedPath().c_str()) != 0 && errno != ENOENT) {
+        Logger::get()->error("Could not remove rotated journal {}: {}", rotatedPath(), std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool Journal::hasRotated() const {
+    struct stat st;
+    return ::stat(rotatedPath().c_str(), &st) == 0;
+}
+
+const std::string& Journal::getPath() const {
+    return path;
+}
+
+std::string Journal::rotatedPath() const {
+    return path + ".old";
+}
+
+long Journal::replay(const std::string& path, const std::function<void(const std::string&)>& onRecord) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return -1;
+    }
+
+    long count = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        onRecord(line);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,56 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Append-only mutation log kept next to the employee snapshot.
+// Each record is a single line of compact JSON; records are replayed in
+// order on top of the last snapshot when the store is loaded.
+class Journal {
+private:
+    std::string path;
+    int fd;
+    std::uintmax_t bytesWritten;
+
+public:
+    explicit Journal(const std::string& path);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Open (or create) the journal for appending
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    // Append one record; a trailing newline is added
+    bool append(const std::string& record);
+
+    // Append several records with a single write
+    bool appendBatch(const std::vector<std::string>& records);
+
+    // Flush appended records to stable storage
+    bool sync();
+
+    // Current size of the active journal in bytes
+    std::uintmax_t size() const;
+
+    // Close the active journal, move it aside to rotatedPath() and start a new one.
+    // The rotated segment stays on disk until the covering snapshot is written.
+    bool rotate();
+    bool removeRotated();
+    bool hasRotated() const;
+
+    const std::string& getPath() const;
+    std::string rotatedPath() const;
+
+    // Invoke the callback for every record of a journal file, oldest first.
+    // Returns the number of records read, or -1 if the file could not be opened.
+    static long replay(const std::string& path, const std::function<void(const std::string&)>& onRecord);
+};
+
+#endif // JOURNAL_H
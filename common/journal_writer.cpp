@@ -0,0 +1,199 @@
+#include "journal_writer.h"
+#include "logger.h"
+#include <algorithm>
+
+const char* durabilityModeName(DurabilityMode mode) {
+    switch (mode) {
+        case DurabilityMode::Sync:
+            return "sync";
+        case DurabilityMode::Async:
+            return "async";
+        case DurabilityMode::Group:
+        default:
+            return "group";
+    }
+}
+
+bool parseDurabilityMode(const std::string& name, DurabilityMode& mode) {
+    if (name == "sync") {
+        mode = DurabilityMode::Sync;
+    } else if (name == "group") {
+        mode = DurabilityMode::Group;
+    } else if (name == "async") {
+        mode = DurabilityMode::Async;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+JournalWriter::JournalWriter(Journal& journal, DurabilityMode mode,
+                             std::chrono::milliseconds batchWindow, std::chrono::milliseconds flushInterval,
+                             size_t maxBatchRecords)
+    : journal(journal), mode(mode), batchWindow(batchWindow), flushInterval(flushInterval),
+      maxBatchRecords(std::max<size_t>(1, maxBatchRecords)), nextSeq(1), committedSeq(0), urgentSeq(0),
+      journalBytes(journal.size()), stopping(false) {
+    counters.mode = mode;
+    worker = std::thread(&JournalWriter::run, this);
+    Logger::get()->info("Journal writer started in {} mode", durabilityModeName(mode));
+}
+
+JournalWriter::~JournalWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    worker.join();
+}
+
+std::uint64_t JournalWriter::enqueue(Entry entry) {
+    std::uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entry.rotate) {
+            journalBytes = 0;
+        } else {
+            journalBytes += entry.record.size() + 1;
+        }
+        pending.push_back(std::move(entry));
+        seq = nextSeq++;
+    }
+    workAvailable.notify_one();
+    return seq;
+}
+
+bool JournalWriter::append(const std::string& record) {
+    return acknowledge(queue(record));
+}
+
+std::uint64_t JournalWriter::queue(const std::string& record) {
+    return enqueue(Entry{record, false});
+}
+
+bool JournalWriter::acknowledge(std::uint64_t seq) {
+    if (mode == DurabilityMode::Async) {
+        return true;
+    }
+    return waitFor(seq);
+}
+
+std::uint64_t JournalWriter::rotate() {
+    return enqueue(Entry{std::string(), true});
+}
+
+bool JournalWriter::waitFor(std::uint64_t seq) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (committedSeq < seq) {
+        // Someone is waiting on this record, so don't sit out the rest of an async interval
+        if (mode == DurabilityMode::Async && urgentSeq < seq) {
+            urgentSeq = seq;
+            workAvailable.notify_one();
+        }
+        batchCommitted.wait(lock, [&]() { return committedSeq >= seq; });
+    }
+    return succeeded(seq);
+}
+
+bool JournalWriter::flush() {
+    std::uint64_t last;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        last = nextSeq - 1;
+    }
+    return last == 0 || waitFor(last);
+}
+
+std::uintmax_t JournalWriter::activeJournalBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return journalBytes;
+}
+
+PersistenceStats JournalWriter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    PersistenceStats snapshot = counters;
+    snapshot.pendingRecords = pending.size();
+    return snapshot;
+}
+
+bool JournalWriter::succeeded(std::uint64_t seq) const {
+    for (const auto& range : failedRanges) {
+        if (seq >= range.first && seq <= range.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void JournalWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        workAvailable.wait(lock, [&]() { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            break;  // stopping with nothing left to commit
+        }
+
+        // Let more records join the batch before paying for the fsync
+        auto batchFull = [&]() {
+            return stopping || pending.size() >= maxBatchRecords || urgentSeq > committedSeq;
+        };
+        if (mode == DurabilityMode::Group) {
+            workAvailable.wait_for(lock, batchWindow, batchFull);
+        } else if (mode == DurabilityMode::Async) {
+            workAvailable.wait_for(lock, flushInterval, batchFull);
+        }
+
+        std::vector<Entry> batch;
+        batch.swap(pending);
+        std::uint64_t firstSeq = nextSeq - batch.size();
+        std::uint64_t lastSeq = nextSeq - 1;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = commit(batch);
+        auto micros = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+
+        lock.lock();
+        committedSeq = lastSeq;
+        if (!ok) {
+            failedRanges.emplace_back(firstSeq, lastSeq);
+            counters.failedBatches++;
+        }
+        counters.batches++;
+        counters.records += batch.size();
+        counters.maxBatchSize = std::max<std::uint64_t>(counters.maxBatchSize, batch.size());
+        counters.lastCommitMicros = micros;
+        counters.maxCommitMicros = std::max(counters.maxCommitMicros, micros);
+        counters.totalCommitMicros += micros;
+        batchCommitted.notify_all();
+    }
+}
+
+bool JournalWriter::commit(const std::vector<Entry>& batch) {
+    bool ok = true;
+    std::vector<std::string> records;
+    records.reserve(batch.size());
+
+    auto writeRecords = [&]() {
+        if (!records.empty()) {
+            ok = journal.appendBatch(records) && journal.sync() && ok;
+            records.clear();
+        }
+    };
+
+    for (const auto& entry : batch) {
+        if (entry.rotate) {
+            writeRecords();
+            ok = journal.rotate() && ok;
+        } else {
+            records.push_back(entry.record);
+        }
+    }
+    writeRecords();
+
+    if (!ok) {
+        Logger::get()->error("Failed to commit a batch of {} journal entries", batch.size());
+    }
+    return ok;
+}
@@ -0,0 +1,101 @@
+#ifndef JOURNAL_WRITER_H
+#define JOURNAL_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "journal.h"
+
+// When a mutation is acknowledged relative to its journal record reaching disk
+enum class DurabilityMode {
+    Sync,   // commit as soon as records are queued, acknowledge after fsync
+    Group,  // gather records for a batch window, acknowledge after the batch commits
+    Async   // acknowledge immediately, commit within the flush interval
+};
+
+const char* durabilityModeName(DurabilityMode mode);
+bool parseDurabilityMode(const std::string& name, DurabilityMode& mode);
+
+struct PersistenceStats {
+    DurabilityMode mode = DurabilityMode::Group;
+    std::uint64_t batches = 0;
+    std::uint64_t records = 0;
+    std::uint64_t failedBatches = 0;
+    std::uint64_t maxBatchSize = 0;
+    std::uint64_t lastCommitMicros = 0;
+    std::uint64_t maxCommitMicros = 0;
+    std::uint64_t totalCommitMicros = 0;
+    std::uint64_t pendingRecords = 0;
+};
+
+// Dedicated persistence thread in front of a Journal. Callers queue records;
+// the thread coalesces everything queued into one write and one fsync per batch.
+class JournalWriter {
+private:
+    struct Entry {
+        std::string record;
+        bool rotate;  // rotate the journal after everything queued before it
+    };
+
+    Journal& journal;
+    DurabilityMode mode;
+    std::chrono::milliseconds batchWindow;
+    std::chrono::milliseconds flushInterval;
+    size_t maxBatchRecords;
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable batchCommitted;
+    std::vector<Entry> pending;
+    std::uint64_t nextSeq;
+    std::uint64_t committedSeq;
+    std::uint64_t urgentSeq;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> failedRanges;
+    std::uintmax_t journalBytes;
+    bool stopping;
+    PersistenceStats counters;
+    std::thread worker;
+
+    void run();
+    bool commit(const std::vector<Entry>& batch);
+    bool succeeded(std::uint64_t seq) const;
+    std::uint64_t enqueue(Entry entry);
+
+public:
+    JournalWriter(Journal& journal, DurabilityMode mode,
+                  std::chrono::milliseconds batchWindow, std::chrono::milliseconds flushInterval,
+                  size_t maxBatchRecords);
+    ~JournalWriter();
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    // Queue a record and wait as long as the durability mode requires
+    bool append(const std::string& record);
+
+    // append() in two steps, so callers can fix the record order under their
+    // own lock and wait outside it
+    std::uint64_t queue(const std::string& record);
+    bool acknowledge(std::uint64_t seq);
+
+    // Queue a rotation marker; returns its sequence number for waitFor()
+    std::uint64_t rotate();
+
+    // Block until everything up to seq has been committed; false if any of it failed
+    bool waitFor(std::uint64_t seq);
+
+    // Commit everything queued so far
+    bool flush();
+
+    // Bytes queued for the active journal segment since the last rotation
+    std::uintmax_t activeJournalBytes() const;
+
+    PersistenceStats stats() const;
+};
+
+#endif // JOURNAL_WRITER_H
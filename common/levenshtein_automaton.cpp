@@ -0,0 +1,73 @@
+#include "levenshtein_automaton.h"
+#include <algorithm>
+
+LevenshteinAutomaton::LevenshteinAutomaton(std::string_view word, int maxEdits)
+    : word(word), maxEdits(static_cast<std::uint8_t>(std::clamp(maxEdits, 0, kMaxEdits))) {}
+
+LevenshteinAutomaton::State LevenshteinAutomaton::start() const {
+    State state(word.size() + 1);
+    for (size_t j = 0; j < state.size(); j++) {
+        state[j] = static_cast<std::uint8_t>(std::min<size_t>(j, maxEdits + 1));
+    }
+    return state;
+}
+
+void LevenshteinAutomaton::step(const State& from, char c, State& to) const {
+    const std::uint8_t cap = maxEdits + 1;
+    to.resize(from.size());
+    to[0] = std::min<std::uint8_t>(from[0] + 1, cap);
+    for (size_t j = 1; j < to.size(); j++) {
+        std::uint8_t substitute = from[j - 1] + (word[j - 1] == c ? 0 : 1);
+        std::uint8_t insert = from[j] + 1;
+        std::uint8_t erase = to[j - 1] + 1;
+        to[j] = std::min({substitute, insert, erase, cap});
+    }
+}
+
+bool LevenshteinAutomaton::canMatch(const State& state) const {
+    return *std::min_element(state.begin(), state.end()) <= maxEdits;
+}
+
+int LevenshteinAutomaton::distance(const State& state) const {
+    return state.back();
+}
+
+void LevenshteinAutomaton::matches(
+    const PrefixDictionary& dictionary,
+    const std::function<void(const std::string& key, int edits, PrefixDictionary::Cursor& entries)>& visit) const {
+    // states[d] is the state after the first d bytes of previous, for d up to
+    // depth; the vectors are reused from key to key
+    std::vector<State> states(1, start());
+    std::string previous;
+    size_t depth = 0;
+
+    auto cursor = dictionary.ascendingFrom("");
+    while (!cursor.done()) {
+        const std::string& key = cursor.key();
+        auto mismatch = std::mismatch(previous.begin(), previous.end(), key.begin(), key.end());
+        depth = std::min(depth, static_cast<size_t>(mismatch.first - previous.begin()));
+
+        bool rejected = !canMatch(states[depth]);
+        while (!rejected && depth < key.size()) {
+            if (states.size() == depth + 1) {
+                states.emplace_back();
+            }
+            step(states[depth], key[depth], states[depth + 1]);
+            depth++;
+            rejected = !canMatch(states[depth]);
+        }
+        previous = key;
+
+        if (rejected) {
+            // Nothing under this prefix can match
+            cursor.skipPrefix(depth);
+            continue;
+        }
+        int edits = distance(states[depth]);
+        if (edits <= maxEdits) {
+            visit(previous, edits, cursor);
+        }
+        // Skip the other entries with this key
+        cursor.seek(previous + '\0');
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef LEVENSHTEIN_AUTOMATON_H
+#define LEVENSHTEIN_AUTOMATON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "prefix_dictionary.h"
+
+// Automaton accepting the strings within maxEdits insertions, deletions and
+// substitutions of one word. A state is the row of edit distances between
+// every prefix of the word and the input read so far, capped at maxEdits + 1,
+// so stepping costs O(word length) and a state that can no longer reach an
+// accepting one is recognized as soon as the input strays too far.
+//
+// Run over a sorted dictionary, the automaton only reads the suffix each key
+// does not share with the key before it, and skips every key under a prefix
+// it has rejected, so it visits a small part of a large dictionary instead of
+// computing a distance against every key.
+class LevenshteinAutomaton {
+public:
+    // Distances beyond this make most short names match each other
+    static constexpr int kMaxEdits = 2;
+
+    using State = std::vector<std::uint8_t>;
+
+private:
+    std::string word;
+    std::uint8_t maxEdits;
+
+public:
+    // maxEdits is clamped to [0, kMaxEdits]
+    LevenshteinAutomaton(std::string_view word, int maxEdits);
+
+    State start() const;
+    void step(const State& from, char c, State& to) const;
+
+    // Whether some continuation of the input can still be accepted
+    bool canMatch(const State& state) const;
+
+    // Edits between the word and the input read so far; above maxEdits when
+    // the input is not accepted
+    int distance(const State& state) const;
+
+    // Visit every distinct key of dictionary that is accepted, in order, with
+    // its distance from the word and a cursor on its first entry. visit may
+    // advance the cursor over the entries of the key, but not past them.
+    void matches(const PrefixDictionary& dictionary,
+                 const std::function<void(const std::string& key, int edits, PrefixDictionary::Cursor& entries)>& visit) const;
+};
+
+#endif // LEVENSHTEIN_AUTOMATON_H
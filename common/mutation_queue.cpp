@@ -0,0 +1,88 @@
+#include "mutation_queue.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+Mutation Mutation::add(const Employee& employee) {
+    Mutation mutation;
+    mutation.kind = Kind::Add;
+    mutation.employee = employee;
+    return mutation;
+}
+
+Mutation Mutation::addWithNextId(const Employee& employee) {
+    Mutation mutation;
+    mutation.kind = Kind::AddWithNextId;
+    mutation.employee = employee;
+    return mutation;
+}
+
+Mutation Mutation::update(const Employee& employee) {
+    Mutation mutation;
+    mutation.kind = Kind::Update;
+    mutation.employee = employee;
+    return mutation;
+}
+
+Mutation Mutation::update(EmployeeHandle handle, const Employee& employee) {
+    Mutation mutation = update(employee);
+    mutation.handle = handle;
+    return mutation;
+}
+
+Mutation Mutation::remove(const std::string& id) {
+    Mutation mutation;
+    mutation.kind = Kind::Delete;
+    mutation.id = id;
+    return mutation;
+}
+
+Mutation Mutation::remove(EmployeeHandle handle) {
+    Mutation mutation;
+    mutation.kind = Kind::Delete;
+    mutation.handle = handle;
+    return mutation;
+}
+
+std::future<MutationResult> MutationQueue::push(Mutation mutation) {
+    std::future<MutationResult> result = mutation.done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(mutation));
+    }
+    available.notify_one();
+    return result;
+}
+
+bool MutationQueue::popBatch(std::vector<Mutation>& batch, size_t maxBatch) {
+    std::unique_lock<std::mutex> lock(mutex);
+    available.wait(lock, [&]() { return stopping || !pending.empty(); });
+    if (pending.empty()) {
+        return false;  // stopping with nothing left to apply
+    }
+
+    size_t count = std::min(pending.size(), std::max<size_t>(maxBatch, 1));
+    batch.clear();
+    std::move(pending.begin(), pending.begin() + count, std::back_inserter(batch));
+    pending.erase(pending.begin(), pending.begin() + count);
+
+    counters.batches++;
+    counters.mutations += count;
+    counters.maxBatchSize = std::max<std::uint64_t>(counters.maxBatchSize, count);
+    return true;
+}
+
+void MutationQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+}
+
+MutationStats MutationQueue::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    MutationStats snapshot = counters;
+    snapshot.pending = pending.size();
+    return snapshot;
+}
@@ -0,0 +1,78 @@
+#ifndef MUTATION_QUEUE_H
+#define MUTATION_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "employee.h"
+#include "handle_slab.h"
+
+enum class MutationStatus {
+    Ok,
+    NotFound,       // no employee with that id, or the handle went stale
+    AlreadyExists,
+    Conflict,       // another employee already holds a key of a unique index
+    NotDurable      // applied in memory, but its journal record failed to commit
+};
+
+struct MutationResult {
+    MutationStatus status = MutationStatus::Ok;
+    std::string id;  // id written or deleted, including one the writer assigned
+    std::string conflict;  // for Conflict, the field of the unique index, e.g. "email"
+};
+
+// One add, update or delete, sent as a command to the writer thread
+struct Mutation {
+    enum class Kind { Add, AddWithNextId, Update, Delete };
+
+    Kind kind = Kind::Add;
+    Employee employee;                     // Add, AddWithNextId and Update
+    std::string id;                        // Delete by id
+    std::optional<EmployeeHandle> handle;  // Update and Delete through a handle
+    std::promise<MutationResult> done;
+
+    static Mutation add(const Employee& employee);
+    static Mutation addWithNextId(const Employee& employee);
+    static Mutation update(const Employee& employee);
+    static Mutation update(EmployeeHandle handle, const Employee& employee);
+    static Mutation remove(const std::string& id);
+    static Mutation remove(EmployeeHandle handle);
+};
+
+struct MutationStats {
+    std::uint64_t batches = 0;
+    std::uint64_t mutations = 0;
+    std::uint64_t maxBatchSize = 0;
+    std::uint64_t pending = 0;
+};
+
+// Queue of mutations in front of the single writer thread, which takes them
+// off in batches
+class MutationQueue {
+private:
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<Mutation> pending;
+    bool stopping = false;
+    MutationStats counters;
+
+public:
+    // Queue a mutation; the future completes once the writer has applied it
+    std::future<MutationResult> push(Mutation mutation);
+
+    // Wait for mutations and move up to maxBatch of them into batch, oldest
+    // first; false once stopped with nothing left
+    bool popBatch(std::vector<Mutation>& batch, size_t maxBatch);
+
+    // Let popBatch return false after the queue drains
+    void stop();
+
+    MutationStats stats() const;
+};
+
+#endif // MUTATION_QUEUE_H
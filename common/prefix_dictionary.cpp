@@ -0,0 +1,354 @@
+#include "prefix_dictionary.h"
+#include <algorithm>
+
+namespace {
+
+void putVarint(std::string& out, std::uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+std::uint32_t getVarint(const std::string& in, size_t& offset) {
+    std::uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        auto byte = static_cast<unsigned char>(in[offset++]);
+        value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+    }
+}
+
+// Decode the entry at offset into key, which holds the key before it
+std::uint32_t decodeEntry(const std::string& bytes, size_t& offset, std::string& key) {
+    std::uint32_t shared = getVarint(bytes, offset);
+    std::uint32_t suffix = getVarint(bytes, offset);
+    key.resize(shared);
+    key.append(bytes, offset, suffix);
+    offset += suffix;
+    return getVarint(bytes, offset);
+}
+
+bool entryBefore(std::string_view key, std::uint32_t slot, std::string_view otherKey, std::uint32_t otherSlot) {
+    int order = key.compare(otherKey);
+    return order < 0 || (order == 0 && slot < otherSlot);
+}
+
+} // namespace
+
+std::vector<PrefixDictionary::Entry> PrefixDictionary::decode(const Block& block) {
+    std::vector<Entry> entries;
+    entries.reserve(block.count + 1);
+    std::string key;
+    for (size_t offset = 0; offset < block.bytes.size();) {
+        std::uint32_t slot = decodeEntry(block.bytes, offset, key);
+        entries.push_back(Entry{key, slot});
+    }
+    return entries;
+}
+
+PrefixDictionary::BlockPtr PrefixDictionary::encode(std::vector<Entry>::const_iterator first,
+                                                    std::vector<Entry>::const_iterator last) {
+    auto block = std::make_shared<Block>();
+    block->firstKey = first->key;
+    block->firstSlot = first->slot;
+    block->count = static_cast<std::uint32_t>(last - first);
+    std::string_view previous;
+    for (auto entry = first; entry != last; ++entry) {
+        auto mismatch = std::mismatch(previous.begin(), previous.end(), entry->key.begin(), entry->key.end());
+        auto shared = static_cast<std::uint32_t>(mismatch.first - previous.begin());
+        putVarint(block->bytes, shared);
+        putVarint(block->bytes, static_cast<std::uint32_t>(entry->key.size() - shared));
+        block->bytes.append(entry->key, shared, std::string::npos);
+        putVarint(block->bytes, entry->slot);
+        previous = entry->key;
+    }
+    block->bytes.shrink_to_fit();
+    return block;
+}
+
+const PrefixDictionary::Block& PrefixDictionary::blockAt(const Segments& segments, Position at) {
+    return *segments[at.segment]->blocks[at.block];
+}
+
+PrefixDictionary::Position PrefixDictionary::following(const Segments& segments, Position at) {
+    if (++at.block == segments[at.segment]->blocks.size()) {
+        at.segment++;
+        at.block = 0;
+    }
+    return at;
+}
+
+PrefixDictionary::Position PrefixDictionary::preceding(const Segments& segments, Position at) {
+    if (at.block == 0) {
+        at.segment--;
+        at.block = segments[at.segment]->blocks.size();
+    }
+    at.block--;
+    return at;
+}
+
+template <typename Test>
+PrefixDictionary::Position PrefixDictionary::partitionPoint(const Segments& segments, Position from, Test test) {
+    if (from.segment == segments.size()) {
+        return from;
+    }
+    // Segments whose last block passes are passed over whole, by binary search
+    if (test(*segments[from.segment]->blocks.back())) {
+        auto segment = std::partition_point(segments.begin() + static_cast<std::ptrdiff_t>(from.segment) + 1,
+                                            segments.end(), [&test](const std::shared_ptr<Segment>& s) {
+            return test(*s->blocks.back());
+        });
+        from = Position{static_cast<size_t>(segment - segments.begin()), 0};
+        if (from.segment == segments.size()) {
+            return from;
+        }
+    }
+    const auto& blocks = segments[from.segment]->blocks;
+    auto block = std::partition_point(blocks.begin() + static_cast<std::ptrdiff_t>(from.block), blocks.end(),
+                                      [&test](const BlockPtr& b) { return test(*b); });
+    from.block = static_cast<size_t>(block - blocks.begin());
+    return from;
+}
+
+PrefixDictionary::Segment& PrefixDictionary::writableSegment(size_t index) {
+    auto& segment = segments[index];
+    if (segment.use_count() > 1) {
+        segment = std::make_shared<Segment>(*segment);
+    }
+    return *segment;
+}
+
+PrefixDictionary::Position PrefixDictionary::blockFor(std::string_view key, std::uint32_t slot) const {
+    Position after = partitionPoint(segments, Position{}, [key, slot](const Block& block) {
+        return !entryBefore(key, slot, block.firstKey, block.firstSlot);
+    });
+    return after == Position{} ? after : preceding(segments, after);
+}
+
+void PrefixDictionary::Cursor::next() {
+    while (at.segment < segments->size() && offset == blockAt(*segments, at).bytes.size()) {
+        at = following(*segments, at);
+        offset = 0;
+        currentKey.clear();
+    }
+    if (at.segment == segments->size()) {
+        finished = true;
+        return;
+    }
+    currentSlot = decodeEntry(blockAt(*segments, at).bytes, offset, currentKey);
+    finished = false;
+}
+
+void PrefixDictionary::Cursor::seek(std::string_view lower) {
+    if (finished || std::string_view(currentKey) >= lower) {
+        return;
+    }
+    // Entries not before lower start in the last block whose first key is
+    // before lower; jump there only if it is past the current one
+    Position after = following(*segments, at);
+    if (after.segment != segments->size() && std::string_view(blockAt(*segments, after).firstKey) < lower) {
+        Position notBefore = partitionPoint(*segments, after, [lower](const Block& b) {
+            return std::string_view(b.firstKey) < lower;
+        });
+        at = preceding(*segments, notBefore);
+        offset = 0;
+        currentKey.clear();
+        next();
+    }
+    while (!finished && std::string_view(currentKey) < lower) {
+        next();
+    }
+}
+
+void PrefixDictionary::Cursor::skipPrefix(size_t length) {
+    if (finished) {
+        return;
+    }
+    if (length == 0) {
+        finished = true;
+        return;
+    }
+    const std::string prefix = currentKey.substr(0, length);
+    auto startsWithPrefix = [&prefix](const Block& b) {
+        return b.firstKey.compare(0, prefix.size(), prefix) == 0;
+    };
+    while (true) {
+        // An entry sharing at least length bytes with the one before it starts
+        // with the prefix too; the first one that does not is where to stop,
+        // and currentKey still holds every byte it shares
+        const std::string& bytes = blockAt(*segments, at).bytes;
+        while (offset < bytes.size()) {
+            size_t position = offset;
+            if (getVarint(bytes, position) < length) {
+                next();
+                return;
+            }
+            position += getVarint(bytes, position);
+            getVarint(bytes, position);
+            offset = position;
+        }
+        // Blocks after this one that start with the prefix hold nothing else,
+        // except the last of them
+        Position after = following(*segments, at);
+        if (after.segment == segments->size() || !startsWithPrefix(blockAt(*segments, after))) {
+            next();
+            return;
+        }
+        at = preceding(*segments, partitionPoint(*segments, after, startsWithPrefix));
+        offset = 0;
+        currentKey.clear();
+        next();
+    }
+}
+
+void PrefixDictionary::insert(const std::string& key, std::uint32_t slot) {
+    entryCount++;
+    if (segments.empty()) {
+        std::vector<Entry> entries{Entry{key, slot}};
+        segments.push_back(std::make_shared<Segment>());
+        segments.back()->blocks.push_back(encode(entries.begin(), entries.end()));
+        return;
+    }
+
+    Position at = blockFor(key, slot);
+    std::vector<Entry> entries = decode(blockAt(segments, at));
+    auto position = std::lower_bound(entries.begin(), entries.end(), key, [slot](const Entry& entry, const std::string& k) {
+        return entryBefore(entry.key, entry.slot, k, slot);
+    });
+    entries.insert(position, Entry{key, slot});
+
+    auto& blocks = writableSegment(at.segment).blocks;
+    if (entries.size() < 2 * kBlockSize) {
+        blocks[at.block] = encode(entries.begin(), entries.end());
+        return;
+    }
+    auto middle = entries.begin() + static_cast<std::ptrdiff_t>(entries.size() / 2);
+    blocks[at.block] = encode(entries.begin(), middle);
+    blocks.insert(blocks.begin() + static_cast<std::ptrdiff_t>(at.block) + 1, encode(middle, entries.end()));
+    if (blocks.size() >= 2 * kSegmentBlocks) {
+        auto upper = std::make_shared<Segment>();
+        auto half = blocks.begin() + static_cast<std::ptrdiff_t>(blocks.size() / 2);
+        upper->blocks.assign(half, blocks.end());
+        blocks.erase(half, blocks.end());
+        segments.insert(segments.begin() + static_cast<std::ptrdiff_t>(at.segment) + 1, std::move(upper));
+    }
+}
+
+bool PrefixDictionary::erase(const std::string& key, std::uint32_t slot) {
+    if (segments.empty()) {
+        return false;
+    }
+    Position at = blockFor(key, slot);
+    std::vector<Entry> entries = decode(blockAt(segments, at));
+    auto found = std::find_if(entries.begin(), entries.end(), [&key, slot](const Entry& entry) {
+        return entry.slot == slot && entry.key == key;
+    });
+    if (found == entries.end()) {
+        return false;
+    }
+    entries.erase(found);
+    entryCount--;
+
+    auto& blocks = writableSegment(at.segment).blocks;
+    if (!entries.empty()) {
+        blocks[at.block] = encode(entries.begin(), entries.end());
+    } else if (blocks.size() > 1) {
+        blocks.erase(blocks.begin() + static_cast<std::ptrdiff_t>(at.block));
+    } else {
+        segments.erase(segments.begin() + static_cast<std::ptrdiff_t>(at.segment));
+    }
+    return true;
+}
+
+void PrefixDictionary::clear() {
+    segments.clear();
+    entryCount = 0;
+}
+
+void PrefixDictionary::assign(std::vector<Entry> entries) {
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return entryBefore(a.key, a.slot, b.key, b.slot);
+    });
+    segments.clear();
+    for (size_t start = 0; start < entries.size(); start += kBlockSize) {
+        if (segments.empty() || segments.back()->blocks.size() == kSegmentBlocks) {
+            segments.push_back(std::make_shared<Segment>());
+            segments.back()->blocks.reserve(kSegmentBlocks);
+        }
+        auto first = entries.begin() + static_cast<std::ptrdiff_t>(start);
+        segments.back()->blocks.push_back(
+            encode(first, first + static_cast<std::ptrdiff_t>(std::min(kBlockSize, entries.size() - start))));
+    }
+    entryCount = entries.size();
+}
+
+size_t PrefixDictionary::size() const {
+    return entryCount;
+}
+
+size_t PrefixDictionary::countRun(std::string_view lower, const std::function<bool(std::string_view)>& match) const {
+    auto countIn = [&match](const Block& block) {
+        size_t found = 0;
+        std::string current;
+        for (size_t offset = 0; offset < block.bytes.size();) {
+            decodeEntry(block.bytes, offset, current);
+            found += match(current) ? 1 : 0;
+        }
+        return found;
+    };
+    // Blocks starting with a matching key form a run; all but the last of
+    // them hold nothing else. The block before the run may end with matches.
+    Position first = partitionPoint(segments, Position{}, [lower](const Block& block) {
+        return std::string_view(block.firstKey) < lower;
+    });
+    Position last = partitionPoint(segments, first, [&match](const Block& block) {
+        return match(block.firstKey);
+    });
+    size_t total = first == Position{} ? 0 : countIn(blockAt(segments, preceding(segments, first)));
+    if (first != last) {
+        Position block = first;
+        for (Position after = following(segments, block); after != last; block = after, after = following(segments, after)) {
+            total += blockAt(segments, block).count;
+        }
+        total += countIn(blockAt(segments, block));
+    }
+    return total;
+}
+
+size_t PrefixDictionary::count(std::string_view key) const {
+    return countRun(key, [key](std::string_view k) { return k == key; });
+}
+
+size_t PrefixDictionary::countWithPrefix(std::string_view prefix) const {
+    return countRun(prefix, [prefix](std::string_view k) { return k.substr(0, prefix.size()) == prefix; });
+}
+
+size_t PrefixDictionary::encodedBytes() const {
+    size_t bytes = 0;
+    for (const auto& segment : segments) {
+        for (const auto& block : segment->blocks) {
+            bytes += block->bytes.size();
+        }
+    }
+    return bytes;
+}
+
+PrefixDictionary::Cursor PrefixDictionary::ascendingFrom(std::string_view lower) const {
+    // Entries not before lower start in the last block whose first key is
+    // before lower, or in the first block if there is none
+    Position notBefore = partitionPoint(segments, Position{}, [lower](const Block& block) {
+        return std::string_view(block.firstKey) < lower;
+    });
+    Cursor cursor;
+    cursor.segments = &segments;
+    cursor.at = notBefore == Position{} ? notBefore : preceding(segments, notBefore);
+    cursor.next();
+    while (!cursor.done() && std::string_view(cursor.key()) < lower) {
+        cursor.next();
+    }
+    return cursor;
+}
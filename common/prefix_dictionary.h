@@ -0,0 +1,151 @@
+#ifndef PREFIX_DICTIONARY_H
+#define PREFIX_DICTIONARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Sorted (key, slot) entries of a string field, compressed for prefix lookups.
+// Entries are kept in blocks of about kBlockSize, and inside a block each key is
+// stored as the length of the prefix it shares with the key before it plus the
+// rest of it, so sorted keys that share long prefixes (names, email domains)
+// cost a few bytes each, as in a trie, without a node per character. Finding
+// the keys with a given prefix is a binary search over the blocks and a walk
+// from there, O(log n + kBlockSize + K) for K keys. Blocks are immutable and
+// grouped in segments of block pointers, both shared between copies, so a copy
+// costs one pointer per segment and a write re-encodes the one block it
+// touches and clones that block's segment.
+class PrefixDictionary {
+public:
+    struct Entry {
+        std::string key;
+        std::uint32_t slot;
+    };
+
+private:
+    static constexpr size_t kBlockSize = 64;      // entries per block after a load; split at twice this
+    static constexpr size_t kSegmentBlocks = 64;  // blocks per segment after a load; split at twice this
+
+    struct Block {
+        std::string firstKey;  // also encoded in bytes, kept here for the binary search
+        std::uint32_t firstSlot;
+        std::uint32_t count;
+        std::string bytes;  // per entry: shared prefix length, suffix length, suffix, slot
+    };
+    using BlockPtr = std::shared_ptr<const Block>;
+
+    // Blocks in order, a run at a time; none is empty
+    struct Segment {
+        std::vector<BlockPtr> blocks;
+    };
+    using Segments = std::vector<std::shared_ptr<Segment>>;
+
+    // A block by segment and index in it; {segments.size(), 0} is the end
+    struct Position {
+        size_t segment = 0;
+        size_t block = 0;
+
+        bool operator==(const Position& other) const {
+            return segment == other.segment && block == other.block;
+        }
+        bool operator!=(const Position& other) const {
+            return !(*this == other);
+        }
+    };
+
+    Segments segments;
+    size_t entryCount = 0;
+
+    static std::vector<Entry> decode(const Block& block);
+    static BlockPtr encode(std::vector<Entry>::const_iterator first, std::vector<Entry>::const_iterator last);
+
+    static const Block& blockAt(const Segments& segments, Position at);
+    static Position following(const Segments& segments, Position at);
+    static Position preceding(const Segments& segments, Position at);  // at is not the first block
+
+    // First block from from on that fails test, for a test that holds for the
+    // blocks before some point and fails after it, like std::partition_point
+    template <typename Test>
+    static Position partitionPoint(const Segments& segments, Position from, Test test);
+
+    // Segments are only shared with other copies of the dictionary, which
+    // are made while no one writes to this one, so use_count() is stable here
+    Segment& writableSegment(size_t index);
+
+    // Last block whose first entry does not order after (key, slot), or the
+    // first block; the dictionary is not empty
+    Position blockFor(std::string_view key, std::uint32_t slot) const;
+
+    // Entries in the run of matching keys that starts from lower, decoding
+    // at most the two blocks at the ends of the run
+    size_t countRun(std::string_view lower, const std::function<bool(std::string_view)>& match) const;
+
+public:
+    // Walks entries in key order, then slot order; valid while the dictionary
+    // it came from is alive and unchanged
+    class Cursor {
+    private:
+        friend class PrefixDictionary;
+        const Segments* segments = nullptr;
+        Position at;
+        size_t offset = 0;  // of the next entry in the current block
+        std::string currentKey;
+        std::uint32_t currentSlot = 0;
+        bool finished = true;
+
+    public:
+        bool done() const {
+            return finished;
+        }
+
+        const std::string& key() const {
+            return currentKey;
+        }
+
+        std::uint32_t slot() const {
+            return currentSlot;
+        }
+
+        void next();
+
+        // Move forward to the first entry whose key does not order before
+        // lower, staying in the current block when lower is close
+        void seek(std::string_view lower);
+
+        // Move forward to the first entry whose key does not start with the
+        // first length bytes of the current key. Entries sharing them are
+        // passed over by their stored prefix lengths without decoding, and
+        // whole blocks of them by binary search, like skipping a trie subtree.
+        void skipPrefix(size_t length);
+    };
+
+    void insert(const std::string& key, std::uint32_t slot);
+    // False if the entry was not there
+    bool erase(const std::string& key, std::uint32_t slot);
+    void clear();
+
+    // Replace the contents in one pass, for loads
+    void assign(std::vector<Entry> entries);
+
+    size_t size() const;
+
+    // Entries with exactly this key, decoding at most the two blocks at the
+    // ends of their run
+    size_t count(std::string_view key) const;
+
+    // Entries whose key starts with prefix, the same way
+    size_t countWithPrefix(std::string_view prefix) const;
+
+    // Bytes of encoded entries
+    size_t encodedBytes() const;
+
+    // Walk from the first entry whose key does not order before lower; keys
+    // starting with a prefix follow each other from ascendingFrom(prefix)
+    Cursor ascendingFrom(std::string_view lower) const;
+};
+
+#endif // PREFIX_DICTIONARY_H
@@ -0,0 +1,85 @@
+#include "read_epoch.h"
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+// One per thread that has ever read, padded to a cache line so pinning never
+// contends. A slot is handed to a new thread once its owner exits, so the list
+// only grows to the peak number of reading threads.
+struct alignas(64) ReadEpochSlot {
+    std::atomic<std::uint64_t> pinned{0};  // 0 while the owner is not reading
+    std::atomic<bool> owned{false};
+    ReadEpochSlot* next = nullptr;
+    unsigned depth = 0;  // nesting of the owner's pins; only the owner touches it
+};
+
+namespace {
+
+// Starts at 1 so that 0 can mean "not pinned"
+std::atomic<std::uint64_t> globalEpoch{1};
+std::atomic<ReadEpochSlot*> slotList{nullptr};
+
+ReadEpochSlot* acquireSlot() {
+    for (ReadEpochSlot* slot = slotList.load(std::memory_order_acquire); slot; slot = slot->next) {
+        bool expected = false;
+        if (!slot->owned.load(std::memory_order_relaxed) &&
+            slot->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return slot;
+        }
+    }
+    auto* slot = new ReadEpochSlot();
+    slot->owned.store(true, std::memory_order_relaxed);
+    ReadEpochSlot* head = slotList.load(std::memory_order_relaxed);
+    do {
+        slot->next = head;
+    } while (!slotList.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+    return slot;
+}
+
+struct ThreadSlot {
+    ReadEpochSlot* slot = acquireSlot();
+
+    ~ThreadSlot() {
+        slot->owned.store(false, std::memory_order_release);
+    }
+};
+
+ReadEpochSlot* threadSlot() {
+    thread_local ThreadSlot mine;
+    return mine.slot;
+}
+
+}
+
+ReadEpoch::Pin::Pin() : slot(threadSlot()) {
+    // The pin must be visible before the caller loads the pointer it protects,
+    // hence sequentially consistent; a writer that misses it published first
+    if (slot->depth++ == 0) {
+        slot->pinned.store(globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+}
+
+ReadEpoch::Pin::~Pin() {
+    if (slot && --slot->depth == 0) {
+        slot->pinned.store(0, std::memory_order_release);
+    }
+}
+
+ReadEpoch::Pin::Pin(Pin&& other) noexcept : slot(other.slot) {
+    other.slot = nullptr;
+}
+
+std::uint64_t ReadEpoch::advance() {
+    return globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+}
+
+std::uint64_t ReadEpoch::oldestPinned() {
+    std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+    for (ReadEpochSlot* slot = slotList.load(std::memory_order_acquire); slot; slot = slot->next) {
+        std::uint64_t pinned = slot->pinned.load(std::memory_order_seq_cst);
+        if (pinned != 0 && pinned < oldest) {
+            oldest = pinned;
+        }
+    }
+    return oldest;
+}
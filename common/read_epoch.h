@@ -0,0 +1,40 @@
+#ifndef READ_EPOCH_H
+#define READ_EPOCH_H
+
+#include <cstdint>
+
+struct ReadEpochSlot;
+
+// Epoch-based reclamation for data that readers reach through a plain atomic
+// pointer. A reader pins the current epoch in a slot of its own thread before
+// loading the pointer, so reading writes no cache line that another thread
+// writes. A writer unlinks the old data, calls advance() and keeps it until
+// oldestPinned() is past the epoch advance() returned: every reader that could
+// still see it pinned that epoch or an earlier one.
+class ReadEpoch {
+public:
+    // Pins the epoch for the calling thread while it lives. Nested pins on one
+    // thread share the outermost one. A pin must be dropped on the thread that
+    // took it.
+    class Pin {
+    private:
+        ReadEpochSlot* slot;
+
+    public:
+        Pin();
+        ~Pin();
+        Pin(Pin&& other) noexcept;
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+        Pin& operator=(Pin&&) = delete;
+    };
+
+    // Start a new epoch after unlinking something; returns the epoch it ended
+    static std::uint64_t advance();
+
+    // Oldest epoch any thread has pinned, UINT64_MAX if none is reading.
+    // Data retired at an epoch below this can be freed.
+    static std::uint64_t oldestPinned();
+};
+
+#endif // READ_EPOCH_H
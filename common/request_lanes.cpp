@@ -0,0 +1,139 @@
+#include "request_lanes.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <future>
+#include <memory>
+
+const char* laneName(Lane lane) {
+    switch (lane) {
+        case Lane::PointRead: return "point_read";
+        case Lane::Scan: return "scan";
+        case Lane::Mutation: return "mutation";
+    }
+    return "unknown";
+}
+
+size_t LatencyHistogram::bucketOf(std::uint64_t micros) {
+    if (micros < 4) {
+        return static_cast<size_t>(micros);
+    }
+    size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(micros));
+    size_t sub = static_cast<size_t>(micros >> (exponent - 2)) & 3;
+    return std::min(kBuckets - 1, 4 * (exponent - 1) + sub);
+}
+
+std::uint64_t LatencyHistogram::upperBoundOf(size_t bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    size_t exponent = bucket / 4 + 1;
+    std::uint64_t sub = bucket % 4;
+    return ((5 + sub) << (exponent - 2)) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t micros) {
+    buckets[bucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+    std::uint64_t seen = maxMicros.load(std::memory_order_relaxed);
+    while (micros > seen && !maxMicros.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t LatencyHistogram::count() const {
+    std::uint64_t total = 0;
+    for (const auto& bucket : buckets) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const {
+    std::uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(fraction * total)));
+    std::uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < kBuckets; bucket++) {
+        seen += buckets[bucket].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return std::min(upperBoundOf(bucket), max());
+        }
+    }
+    return max();
+}
+
+std::uint64_t LatencyHistogram::max() const {
+    return maxMicros.load(std::memory_order_relaxed);
+}
+
+RequestLanes::RequestLanes(const std::array<LaneOptions, kLaneCount>& options) {
+    for (size_t lane = 0; lane < kLaneCount; lane++) {
+        size_t workers = std::max<size_t>(options[lane].workers, 1);
+        // The pool bounds each worker's deque, so split the queue between them
+        size_t perWorker = std::max<size_t>(1, (options[lane].queueCapacity + workers - 1) / workers);
+        lanes[lane].pool = std::make_unique<WorkStealingPool>(workers, perWorker);
+    }
+}
+
+RequestLanes::~RequestLanes() {
+    for (auto& lane : lanes) {
+        lane.pool->shutdown();
+    }
+}
+
+bool RequestLanes::run(Lane lane, const std::function<void()>& work) {
+    using Clock = std::chrono::steady_clock;
+    auto micros = [](Clock::duration elapsed) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    };
+
+    LaneState& state = lanes[static_cast<size_t>(lane)];
+    auto submitted = Clock::now();
+    // The task owns the promise so it outlives set_value; everything else it
+    // borrows from this frame, which waits for it and which it must not touch
+    // once the promise is satisfied
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> finished = done->get_future();
+    bool queued = state.pool->enqueue([&, done]() {
+        auto started = Clock::now();
+        std::exception_ptr error;
+        try {
+            work();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        auto ended = Clock::now();
+        state.wait.record(micros(started - submitted));
+        state.service.record(micros(ended - started));
+        state.total.record(micros(ended - submitted));
+        if (error) {
+            done->set_exception(error);
+        } else {
+            done->set_value();
+        }
+    });
+    if (!queued) {
+        state.rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    finished.get();
+    return true;
+}
+
+LaneStats RequestLanes::stats(Lane lane) const {
+    const LaneState& state = lanes[static_cast<size_t>(lane)];
+    TaskPoolStats pool = state.pool->stats();
+    LaneStats snapshot;
+    snapshot.workers = pool.workers;
+    snapshot.depth = pool.depth;
+    snapshot.completed = state.total.count();  // recorded before the caller is released
+    snapshot.rejected = state.rejected.load(std::memory_order_relaxed);
+    snapshot.waitP50Micros = state.wait.percentile(0.5);
+    snapshot.waitP99Micros = state.wait.percentile(0.99);
+    snapshot.serviceP50Micros = state.service.percentile(0.5);
+    snapshot.serviceP99Micros = state.service.percentile(0.99);
+    snapshot.maxMicros = state.total.max();
+    return snapshot;
+}
@@ -0,0 +1,88 @@
+#ifndef REQUEST_LANES_H
+#define REQUEST_LANES_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "work_stealing_pool.h"
+
+// Classes of request, each served by its own pool so slow ones cannot hold up
+// cheap ones
+enum class Lane {
+    PointRead,  // lookups by id and other reads answered from an index
+    Scan,       // listings, searches and other reads whose cost grows with the result
+    Mutation    // adds, updates, deletes and snapshots
+};
+
+constexpr size_t kLaneCount = 3;
+
+const char* laneName(Lane lane);
+
+// Lock-free latency histogram: four buckets per power of two of microseconds,
+// so a reported percentile is at most 25% above the true value
+class LatencyHistogram {
+private:
+    static constexpr size_t kBuckets = 4 * 40;
+    std::array<std::atomic<std::uint64_t>, kBuckets> buckets{};
+    std::atomic<std::uint64_t> maxMicros{0};
+
+    static size_t bucketOf(std::uint64_t micros);
+    static std::uint64_t upperBoundOf(size_t bucket);
+
+public:
+    void record(std::uint64_t micros);
+    std::uint64_t count() const;
+    std::uint64_t percentile(double fraction) const;
+    std::uint64_t max() const;
+};
+
+struct LaneOptions {
+    size_t workers = 1;
+    size_t queueCapacity = 64;  // requests waiting for a worker, beyond which new ones are refused
+};
+
+struct LaneStats {
+    std::uint64_t workers = 0;
+    std::uint64_t depth = 0;
+    std::uint64_t completed = 0;
+    std::uint64_t rejected = 0;
+    std::uint64_t waitP50Micros = 0;     // queued until a worker picked it up
+    std::uint64_t waitP99Micros = 0;
+    std::uint64_t serviceP50Micros = 0;  // running on the worker
+    std::uint64_t serviceP99Micros = 0;
+    std::uint64_t maxMicros = 0;         // wait plus service
+};
+
+// One bounded worker pool per lane. Callers hand a request's work to its lane
+// and wait for it; a full lane refuses the work at once instead of queueing
+// it behind the rest.
+class RequestLanes {
+private:
+    struct LaneState {
+        std::unique_ptr<WorkStealingPool> pool;
+        std::atomic<std::uint64_t> rejected{0};
+        LatencyHistogram wait;
+        LatencyHistogram service;
+        LatencyHistogram total;
+    };
+
+    std::array<LaneState, kLaneCount> lanes;
+
+public:
+    explicit RequestLanes(const std::array<LaneOptions, kLaneCount>& options);
+    ~RequestLanes();
+
+    RequestLanes(const RequestLanes&) = delete;
+    RequestLanes& operator=(const RequestLanes&) = delete;
+
+    // Run work on the lane's pool and wait for it; false without running it
+    // if the lane's queue is full. Exceptions from work are rethrown here.
+    bool run(Lane lane, const std::function<void()>& work);
+
+    LaneStats stats(Lane lane) const;
+};
+
+#endif // REQUEST_LANES_H
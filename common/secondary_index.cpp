@@ -0,0 +1,72 @@
+#include "secondary_index.h"
+
+SecondaryIndexes::SecondaryIndexes(const SecondaryIndexes& other) {
+    *this = other;
+}
+
+SecondaryIndexes& SecondaryIndexes::operator=(const SecondaryIndexes& other) {
+    if (this != &other) {
+        indexes.clear();
+        indexes.reserve(other.indexes.size());
+        for (const auto& index : other.indexes) {
+            indexes.push_back(index->clone());
+        }
+    }
+    return *this;
+}
+
+const SecondaryIndexBase* SecondaryIndexes::find(std::string_view name) const {
+    for (const auto& index : indexes) {
+        if (name == index->name()) {
+            return index.get();
+        }
+    }
+    return nullptr;
+}
+
+const std::vector<std::unique_ptr<SecondaryIndexBase>>& SecondaryIndexes::all() const {
+    return indexes;
+}
+
+void SecondaryIndexes::insert(const EmployeeFields& fields, std::uint32_t slot) {
+    for (auto& index : indexes) {
+        index->insert(fields, slot);
+    }
+}
+
+void SecondaryIndexes::erase(const EmployeeFields& fields, std::uint32_t slot) {
+    for (auto& index : indexes) {
+        index->erase(fields, slot);
+    }
+}
+
+void SecondaryIndexes::update(const EmployeeFields& before, const EmployeeFields& after, std::uint32_t slot) {
+    for (auto& index : indexes) {
+        index->update(before, after, slot);
+    }
+}
+
+void SecondaryIndexes::clear() {
+    for (auto& index : indexes) {
+        index->clear();
+    }
+}
+
+size_t SecondaryIndexes::rebuild(size_t rows, const std::function<EmployeeFields(size_t)>& fieldsAt,
+                                 const ChunkedColumn<std::uint32_t>& slotOfRow) {
+    size_t skipped = 0;
+    for (auto& index : indexes) {
+        skipped += index->rebuild(rows, fieldsAt, slotOfRow);
+    }
+    return skipped;
+}
+
+std::optional<std::pair<const SecondaryIndexBase*, std::uint32_t>>
+SecondaryIndexes::uniqueHolder(const EmployeeFields& fields) const {
+    for (const auto& index : indexes) {
+        if (auto slot = index->holderOf(fields)) {
+            return std::make_pair(index.get(), *slot);
+        }
+    }
+    return std::nullopt;
+}
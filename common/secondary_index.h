@@ -0,0 +1,406 @@
+#ifndef SECONDARY_INDEX_H
+#define SECONDARY_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "chunked_column.h"
+#include "hash_slots.h"
+#include "index_tree.h"
+#include "prefix_dictionary.h"
+
+// Column value for a salary or age that does not parse as an integer
+constexpr std::int32_t kNotNumeric = std::numeric_limits<std::int32_t>::min();
+
+// The indexable values of one record, viewed in place: either a table row or
+// an Employee about to be written, with salary and age already parsed
+struct EmployeeFields {
+    std::string_view name;
+    std::string_view title;
+    std::string_view email;
+    std::int32_t salary = kNotNumeric;
+    std::int32_t age = kNotNumeric;
+};
+
+enum class IndexKind {
+    Hash,     // equality lookups in O(1)
+    Ordered,  // equality, ranges and ranks in O(log n)
+    Unique,   // equality in O(1), at most one record per key
+    Prefix    // string keys starting with a prefix in O(log n + K), compressed
+};
+
+// What every secondary index looks like to the table that maintains it. An
+// index is declared against a Field, a type naming the index and turning a
+// record's fields into its key, or nothing to leave the record out:
+//
+//     struct AgeField {
+//         using Key = std::int32_t;
+//         static constexpr const char* kName = "age";
+//         static std::optional<Key> keyOf(const EmployeeFields& fields);
+//     };
+//
+// A prefix index may instead declare every key of a record at once, such as
+// each word of a name:
+//
+//     static std::vector<std::string> keysOf(const EmployeeFields& fields);
+//
+// Entries are keyed by handle slot, which rows keep when they move.
+class SecondaryIndexBase {
+public:
+    virtual ~SecondaryIndexBase() = default;
+
+    virtual std::unique_ptr<SecondaryIndexBase> clone() const = 0;
+    virtual const char* name() const = 0;
+    virtual IndexKind kind() const = 0;
+    virtual size_t size() const = 0;
+
+    virtual void insert(const EmployeeFields& fields, std::uint32_t slot) = 0;
+    virtual void erase(const EmployeeFields& fields, std::uint32_t slot) = 0;
+    // Move slot from its old key to its new one, if the key changed
+    virtual void update(const EmployeeFields& before, const EmployeeFields& after, std::uint32_t slot) = 0;
+    virtual void clear() = 0;
+
+    // Replace the contents with the given rows in one pass. Returns how many a
+    // unique index left out because an earlier row already had their key.
+    virtual size_t rebuild(size_t rows, const std::function<EmployeeFields(size_t)>& fieldsAt,
+                           const ChunkedColumn<std::uint32_t>& slotOfRow) = 0;
+
+    // For unique indexes, the slot already holding the key of fields
+    virtual std::optional<std::uint32_t> holderOf(const EmployeeFields& fields) const {
+        (void) fields;
+        return std::nullopt;
+    }
+};
+
+template <typename Field, IndexKind Kind>
+class SecondaryIndex;
+
+// Ordered index over an IndexTree, for ranges, ranks and top-K
+template <typename Field>
+class SecondaryIndex<Field, IndexKind::Ordered> final : public SecondaryIndexBase {
+public:
+    using Key = typename Field::Key;
+    using Tree = IndexTree<Key>;
+
+private:
+    Tree tree;
+
+public:
+    std::unique_ptr<SecondaryIndexBase> clone() const override {
+        return std::make_unique<SecondaryIndex>(*this);
+    }
+
+    const char* name() const override {
+        return Field::kName;
+    }
+
+    IndexKind kind() const override {
+        return IndexKind::Ordered;
+    }
+
+    size_t size() const override {
+        return tree.size();
+    }
+
+    void insert(const EmployeeFields& fields, std::uint32_t slot) override {
+        if (auto key = Field::keyOf(fields)) {
+            tree.insert(*key, slot);
+        }
+    }
+
+    void erase(const EmployeeFields& fields, std::uint32_t slot) override {
+        if (auto key = Field::keyOf(fields)) {
+            tree.erase(*key, slot);
+        }
+    }
+
+    void update(const EmployeeFields& before, const EmployeeFields& after, std::uint32_t slot) override {
+        auto oldKey = Field::keyOf(before);
+        auto newKey = Field::keyOf(after);
+        if (oldKey != newKey) {
+            if (oldKey) {
+                tree.erase(*oldKey, slot);
+            }
+            if (newKey) {
+                tree.insert(*newKey, slot);
+            }
+        }
+    }
+
+    void clear() override {
+        tree.clear();
+    }
+
+    size_t rebuild(size_t rows, const std::function<EmployeeFields(size_t)>& fieldsAt,
+                   const ChunkedColumn<std::uint32_t>& slotOfRow) override {
+        std::vector<typename Tree::Entry> entries;
+        entries.reserve(rows);
+        for (size_t row = 0; row < rows; row++) {
+            if (auto key = Field::keyOf(fieldsAt(row))) {
+                entries.push_back(typename Tree::Entry{std::move(*key), slotOfRow[row]});
+            }
+        }
+        tree.assign(std::move(entries));
+        return 0;
+    }
+
+    const Tree& entries() const {
+        return tree;
+    }
+};
+
+// Whether a Field gives several keys per record through keysOf
+template <typename Field, typename = void>
+struct HasKeysOf : std::false_type {};
+template <typename Field>
+struct HasKeysOf<Field, std::void_t<decltype(Field::keysOf(std::declval<const EmployeeFields&>()))>>
+    : std::true_type {};
+
+// Prefix index over a PrefixDictionary, for autocomplete and fuzzy search;
+// Field::Key must be std::string
+template <typename Field>
+class SecondaryIndex<Field, IndexKind::Prefix> final : public SecondaryIndexBase {
+private:
+    PrefixDictionary dictionary;
+
+    static std::vector<std::string> keysOf(const EmployeeFields& fields) {
+        if constexpr (HasKeysOf<Field>::value) {
+            return Field::keysOf(fields);
+        } else {
+            auto key = Field::keyOf(fields);
+            return key ? std::vector<std::string>{std::move(*key)} : std::vector<std::string>{};
+        }
+    }
+
+public:
+    std::unique_ptr<SecondaryIndexBase> clone() const override {
+        return std::make_unique<SecondaryIndex>(*this);
+    }
+
+    const char* name() const override {
+        return Field::kName;
+    }
+
+    IndexKind kind() const override {
+        return IndexKind::Prefix;
+    }
+
+    size_t size() const override {
+        return dictionary.size();
+    }
+
+    void insert(const EmployeeFields& fields, std::uint32_t slot) override {
+        for (const auto& key : keysOf(fields)) {
+            dictionary.insert(key, slot);
+        }
+    }
+
+    void erase(const EmployeeFields& fields, std::uint32_t slot) override {
+        for (const auto& key : keysOf(fields)) {
+            dictionary.erase(key, slot);
+        }
+    }
+
+    void update(const EmployeeFields& before, const EmployeeFields& after, std::uint32_t slot) override {
+        auto oldKeys = keysOf(before);
+        auto newKeys = keysOf(after);
+        if (oldKeys != newKeys) {
+            for (const auto& key : oldKeys) {
+                dictionary.erase(key, slot);
+            }
+            for (const auto& key : newKeys) {
+                dictionary.insert(key, slot);
+            }
+        }
+    }
+
+    void clear() override {
+        dictionary.clear();
+    }
+
+    size_t rebuild(size_t rows, const std::function<EmployeeFields(size_t)>& fieldsAt,
+                   const ChunkedColumn<std::uint32_t>& slotOfRow) override {
+        std::vector<PrefixDictionary::Entry> entries;
+        entries.reserve(rows);
+        for (size_t row = 0; row < rows; row++) {
+            for (auto& key : keysOf(fieldsAt(row))) {
+                entries.push_back(PrefixDictionary::Entry{std::move(key), slotOfRow[row]});
+            }
+        }
+        dictionary.assign(std::move(entries));
+        return 0;
+    }
+
+    const PrefixDictionary& entries() const {
+        return dictionary;
+    }
+};
+
+// Hash and unique indexes share their storage; a unique one keeps only the
+// first slot per key
+template <typename Field, IndexKind Kind>
+class HashedSecondaryIndex : public SecondaryIndexBase {
+public:
+    using Key = typename Field::Key;
+    static constexpr bool kUnique = Kind == IndexKind::Unique;
+
+private:
+    HashSlots<Key> slots;
+
+    void add(const Key& key, std::uint32_t slot) {
+        if (!kUnique || !slots.findAny(key)) {
+            slots.insert(key, slot);
+        }
+    }
+
+public:
+    std::unique_ptr<SecondaryIndexBase> clone() const override {
+        return std::make_unique<SecondaryIndex<Field, Kind>>(static_cast<const SecondaryIndex<Field, Kind>&>(*this));
+    }
+
+    const char* name() const override {
+        return Field::kName;
+    }
+
+    IndexKind kind() const override {
+        return Kind;
+    }
+
+    size_t size() const override {
+        return slots.size();
+    }
+
+    void insert(const EmployeeFields& fields, std::uint32_t slot) override {
+        if (auto key = Field::keyOf(fields)) {
+            add(*key, slot);
+        }
+    }
+
+    void erase(const EmployeeFields& fields, std::uint32_t slot) override {
+        if (auto key = Field::keyOf(fields)) {
+            slots.erase(*key, slot);
+        }
+    }
+
+    void update(const EmployeeFields& before, const EmployeeFields& after, std::uint32_t slot) override {
+        auto oldKey = Field::keyOf(before);
+        auto newKey = Field::keyOf(after);
+        if (oldKey != newKey) {
+            if (oldKey) {
+                slots.erase(*oldKey, slot);
+            }
+            if (newKey) {
+                add(*newKey, slot);
+            }
+        }
+    }
+
+    void clear() override {
+        slots.clear();
+    }
+
+    size_t rebuild(size_t rows, const std::function<EmployeeFields(size_t)>& fieldsAt,
+                   const ChunkedColumn<std::uint32_t>& slotOfRow) override {
+        slots.clear();
+        slots.reserve(rows);
+        size_t skipped = 0;
+        for (size_t row = 0; row < rows; row++) {
+            if (auto key = Field::keyOf(fieldsAt(row))) {
+                if (kUnique && slots.findAny(*key)) {
+                    skipped++;
+                } else {
+                    slots.insert(*key, slotOfRow[row]);
+                }
+            }
+        }
+        return skipped;
+    }
+
+    std::optional<std::uint32_t> holderOf(const EmployeeFields& fields) const override {
+        if (!kUnique) {
+            return std::nullopt;
+        }
+        auto key = Field::keyOf(fields);
+        return key ? slots.findAny(*key) : std::nullopt;
+    }
+
+    const HashSlots<Key>& entries() const {
+        return slots;
+    }
+};
+
+template <typename Field>
+class SecondaryIndex<Field, IndexKind::Hash> final : public HashedSecondaryIndex<Field, IndexKind::Hash> {};
+
+template <typename Field>
+class SecondaryIndex<Field, IndexKind::Unique> final : public HashedSecondaryIndex<Field, IndexKind::Unique> {};
+
+template <typename Field>
+using HashIndex = SecondaryIndex<Field, IndexKind::Hash>;
+template <typename Field>
+using OrderedIndex = SecondaryIndex<Field, IndexKind::Ordered>;
+template <typename Field>
+using UniqueIndex = SecondaryIndex<Field, IndexKind::Unique>;
+template <typename Field>
+using PrefixIndex = SecondaryIndex<Field, IndexKind::Prefix>;
+
+// The secondary indexes of one table. Copies clone every index, which shares
+// its storage with the original until either is written.
+class SecondaryIndexes {
+private:
+    std::vector<std::unique_ptr<SecondaryIndexBase>> indexes;
+
+public:
+    SecondaryIndexes() = default;
+    SecondaryIndexes(const SecondaryIndexes& other);
+    SecondaryIndexes& operator=(const SecondaryIndexes& other);
+    SecondaryIndexes(SecondaryIndexes&&) = default;
+    SecondaryIndexes& operator=(SecondaryIndexes&&) = default;
+
+    // Add an empty index of the given type, unless there already is one;
+    // true if it was added and needs building
+    template <typename Index>
+    bool declare() {
+        if (find<Index>()) {
+            return false;
+        }
+        indexes.push_back(std::make_unique<Index>());
+        return true;
+    }
+
+    template <typename Index>
+    const Index* find() const {
+        for (const auto& index : indexes) {
+            if (auto* typed = dynamic_cast<const Index*>(index.get())) {
+                return typed;
+            }
+        }
+        return nullptr;
+    }
+
+    const SecondaryIndexBase* find(std::string_view name) const;
+    const std::vector<std::unique_ptr<SecondaryIndexBase>>& all() const;
+
+    void insert(const EmployeeFields& fields, std::uint32_t slot);
+    void erase(const EmployeeFields& fields, std::uint32_t slot);
+    void update(const EmployeeFields& before, const EmployeeFields& after, std::uint32_t slot);
+    void clear();
+
+    // Rebuild every index; returns the rows unique indexes left out
+    size_t rebuild(size_t rows, const std::function<EmployeeFields(size_t)>& fieldsAt,
+                   const ChunkedColumn<std::uint32_t>& slotOfRow);
+
+    // First unique index holding one of the keys of fields, and the slot
+    // holding it
+    std::optional<std::pair<const SecondaryIndexBase*, std::uint32_t>> uniqueHolder(const EmployeeFields& fields) const;
+};
+
+#endif // SECONDARY_INDEX_H
@@ -0,0 +1,763 @@
+#include "snapshot.h"
+#include "logger.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+const char kBinaryMagic[8] = {'E', 'M', 'P', 'S', 'N', 'A', 'P', '\0'};
+
+// Streams a snapshot into a temporary file that is fsynced and renamed over
+// the real one, so a crash never leaves a half-written snapshot behind. It
+// never logs because it also runs inside forked snapshot children.
+class SnapshotFile {
+private:
+    std::string path;
+    std::string tempPath;
+    int fd;
+    std::string buffer;
+    std::string error;
+
+    bool writeAll(const char* data, size_t size, off_t offset, bool positioned) {
+        while (size > 0) {
+            ssize_t written = positioned ? ::pwrite(fd, data, size, offset) : ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error = "Failed writing " + tempPath + ": " + std::strerror(errno);
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += written;
+        }
+        return true;
+    }
+
+    bool flushBuffer() {
+        bool ok = writeAll(buffer.data(), buffer.size(), 0, false);
+        buffer.clear();
+        return ok;
+    }
+
+public:
+    explicit SnapshotFile(const std::string& path) : path(path), tempPath(path + ".tmp") {
+        fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            error = "Could not open file for writing: " + tempPath;
+        }
+    }
+
+    ~SnapshotFile() {
+        if (fd >= 0) {
+            ::close(fd);
+            ::unlink(tempPath.c_str());
+        }
+    }
+
+    // Buffered append at the current position
+    bool write(const char* data, size_t size) {
+        if (fd < 0) {
+            return false;
+        }
+        buffer.append(data, size);
+        return buffer.size() < (1 << 20) || flushBuffer();
+    }
+
+    bool write(const std::string& data) {
+        return write(data.data(), data.size());
+    }
+
+    // Move the append position; pending buffered data is written first
+    bool seek(std::uint64_t offset) {
+        if (fd < 0 || !flushBuffer()) {
+            return false;
+        }
+        if (::lseek(fd, static_cast<off_t>(offset), SEEK_SET) < 0) {
+            error = "Could not seek in " + tempPath + ": " + std::strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    // Unbuffered write at an absolute offset
+    bool writeAt(std::uint64_t offset, const void* data, size_t size) {
+        return fd >= 0 && writeAll(static_cast<const char*>(data), size, static_cast<off_t>(offset), true);
+    }
+
+    bool commit() {
+        if (fd < 0 || !flushBuffer()) {
+            return false;
+        }
+        bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+        fd = -1;
+        if (!synced || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+            error = "Could not replace " + path + ": " + std::strerror(errno);
+            ::unlink(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    const std::string& lastError() const {
+        return error;
+    }
+};
+
+// Read-only private mapping of a whole file
+class MappedFile {
+private:
+    void* data;
+    size_t size;
+
+public:
+    MappedFile() : data(nullptr), size(0) {}
+
+    ~MappedFile() {
+        if (data != nullptr) {
+            ::munmap(data, size);
+        }
+    }
+
+    bool map(const std::string& path, std::string& error) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "Could not open file: " + path;
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            error = "Could not read size of " + path;
+            return false;
+        }
+
+        size = static_cast<size_t>(st.st_size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            error = "Could not map " + path + ": " + std::strerror(errno);
+            return false;
+        }
+
+        data = mapped;
+        ::madvise(data, size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    const char* bytes() const {
+        return static_cast<const char*>(data);
+    }
+
+    size_t length() const {
+        return size;
+    }
+};
+
+// Integer form of a salary or age, or kBinaryNotNumeric when the text would
+// not survive a round trip through std::to_string
+std::int32_t canonicalInt(const std::string& text) {
+    std::int32_t value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size() ||
+        value == kBinaryNotNumeric || std::to_string(value) != text) {
+        return kBinaryNotNumeric;
+    }
+    return value;
+}
+
+// SAX consumer for {"data": [ {...}, ... ]} that assembles one Employee at a
+// time and hands it on, so loading never materializes the document. Records
+// with missing or mistyped fields are skipped with a warning.
+class EmployeeSaxHandler : public nlohmann::json_sax<json> {
+private:
+    enum Field { Id, Name, Salary, Age, Title, Email, FieldCount, Unknown };
+
+    static constexpr int kTopLevel = 1;  // inside the document object
+    static constexpr int kArray = 2;     // inside the "data" array
+    static constexpr int kRecord = 3;    // inside one employee object
+
+    const EmployeeVisitor& onEmployee;
+    int depth;
+    bool inDataArray;
+    bool dataKeyPending;
+    Field field;
+    std::array<std::string, FieldCount> values;
+    std::array<bool, FieldCount> present;
+    std::string recordError;
+    size_t records;
+    std::string lastParseError;
+
+    static const char* fieldName(int index) {
+        static const char* names[] = {"id", "employee_name", "employee_salary", "employee_age",
+                                      "employee_title", "employee_email"};
+        return names[index];
+    }
+
+    bool inRecordField() const {
+        return inDataArray && depth == kRecord && field != Unknown;
+    }
+
+    void mistyped(const char* type) {
+        if (inRecordField() && recordError.empty()) {
+            recordError = std::string("type must be ") + (field == Salary || field == Age ? "string or number" : "string") +
+                          ", but is " + type + " for '" + fieldName(field) + "'";
+        }
+    }
+
+    // Salary and age may be numeric in the source; they are kept as text
+    bool number(long long value, const char* type) {
+        if (inRecordField()) {
+            if (field == Salary || field == Age) {
+                values[field] = std::to_string(static_cast<int>(value));
+                present[field] = true;
+            } else {
+                mistyped(type);
+            }
+        }
+        return true;
+    }
+
+    bool enter() {
+        if (inRecordField()) {
+            mistyped("a structure");
+        }
+        depth++;
+        dataKeyPending = false;
+        return true;
+    }
+
+public:
+    explicit EmployeeSaxHandler(const EmployeeVisitor& onEmployee)
+        : onEmployee(onEmployee), depth(0), inDataArray(false), dataKeyPending(false), field(Unknown),
+          records(0) {}
+
+    size_t recordCount() const {
+        return records;
+    }
+
+    const std::string& parseError() const {
+        return lastParseError;
+    }
+
+    bool null() override {
+        mistyped("null");
+        return true;
+    }
+
+    bool boolean(bool) override {
+        mistyped("boolean");
+        return true;
+    }
+
+    bool number_integer(number_integer_t value) override {
+        return number(value, "number");
+    }
+
+    bool number_unsigned(number_unsigned_t value) override {
+        return number(static_cast<long long>(value), "number");
+    }
+
+    bool number_float(number_float_t value, const string_t&) override {
+        return number(static_cast<long long>(value), "number");
+    }
+
+    bool string(string_t& value) override {
+        if (inRecordField()) {
+            values[field] = std::move(value);
+            present[field] = true;
+        }
+        return true;
+    }
+
+    bool binary(binary_t&) override {
+        mistyped("binary");
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        if (inDataArray && depth == kArray) {
+            present.fill(false);
+            recordError.clear();
+            field = Unknown;
+            depth++;
+            return true;
+        }
+        return enter();
+    }
+
+    bool end_object() override {
+        depth--;
+        if (inDataArray && depth == kArray) {
+            for (int i = 0; i < FieldCount && recordError.empty(); i++) {
+                if (!present[i]) {
+                    recordError = std::string("missing field '") + fieldName(i) + "'";
+                }
+            }
+            if (recordError.empty()) {
+                onEmployee(Employee(values[Id], values[Name], values[Salary], values[Age], values[Title], values[Email]));
+                records++;
+            } else {
+                Logger::get()->warn("Failed to parse employee record: {}", recordError);
+            }
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (dataKeyPending && depth == kTopLevel) {
+            inDataArray = true;
+            dataKeyPending = false;
+            depth++;
+            return true;
+        }
+        return enter();
+    }
+
+    bool end_array() override {
+        depth--;
+        if (inDataArray && depth == kTopLevel) {
+            inDataArray = false;
+        }
+        return true;
+    }
+
+    bool key(string_t& name) override {
+        if (depth == kTopLevel) {
+            dataKeyPending = name == "data";
+        } else if (inDataArray && depth == kRecord) {
+            field = Unknown;
+            for (int i = 0; i < FieldCount; i++) {
+                if (name == fieldName(i)) {
+                    field = static_cast<Field>(i);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        lastParseError = ex.what();
+        return false;
+    }
+};
+
+std::uint64_t alignTo8(std::uint64_t offset) {
+    return (offset + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+std::uint32_t headerChecksum(const BinarySnapshotHeader& header) {
+    return Snapshot::crc32(&header, offsetof(BinarySnapshotHeader, headerChecksum));
+}
+
+} // namespace
+
+SnapshotFormat Snapshot::formatForPath(const std::string& path) {
+    auto endsWith = [&path](const std::string& suffix) {
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (endsWith(".bin")) {
+        return SnapshotFormat::Binary;
+    }
+    return endsWith(".jsonl") ? SnapshotFormat::JsonLines : SnapshotFormat::Json;
+}
+
+bool Snapshot::read(const std::string& path, const EmployeeVisitor& onEmployee, std::string& error) {
+    switch (formatForPath(path)) {
+        case SnapshotFormat::Binary:
+            return readBinary(path, onEmployee, error);
+        case SnapshotFormat::JsonLines:
+            return readJsonLines(path, onEmployee, error);
+        case SnapshotFormat::Json:
+        default:
+            return readJson(path, onEmployee, error);
+    }
+}
+
+bool Snapshot::write(const std::string& path, std::size_t count, const EmployeeSource& source, std::string& error) {
+    switch (formatForPath(path)) {
+        case SnapshotFormat::Binary:
+            return writeBinary(path, count, source, error);
+        case SnapshotFormat::JsonLines:
+            return writeJsonLines(path, source, error);
+        case SnapshotFormat::Json:
+        default:
+            return writeJson(path, source, error);
+    }
+}
+
+json Snapshot::employeeToJson(const Employee& emp) {
+    json employeeObj;
+    employeeObj["id"] = emp.getId();
+    employeeObj["employee_name"] = emp.getName();
+    employeeObj["employee_salary"] = emp.getSalary();
+    employeeObj["employee_age"] = emp.getAge();
+    employeeObj["employee_title"] = emp.getTitle();
+    employeeObj["employee_email"] = emp.getEmail();
+    return employeeObj;
+}
+
+// Throws on a missing or mistyped field with the same message the SAX loader
+// logs, so every loader can report a bad record and carry on
+Employee Snapshot::employeeFromJson(const json& item) {
+    static const char* fields[] = {"id", "employee_name", "employee_salary", "employee_age",
+                                   "employee_title", "employee_email"};
+    for (const char* field : fields) {
+        if (!item.contains(field)) {
+            throw std::runtime_error(std::string("missing field '") + field + "'");
+        }
+    }
+    auto text = [&item](const char* field) { return item.at(field).get<std::string>(); };
+    auto textOrNumber = [&item](const char* field) {
+        const json& value = item.at(field);
+        return value.is_string() ? value.get<std::string>() : std::to_string(value.get<int>());
+    };
+    Employee emp;
+    emp.setId(text("id"));
+    emp.setName(text("employee_name"));
+    emp.setSalary(textOrNumber("employee_salary"));
+    emp.setAge(textOrNumber("employee_age"));
+    emp.setTitle(text("employee_title"));
+    emp.setEmail(text("employee_email"));
+    return emp;
+}
+
+bool Snapshot::readJson(const std::string& path, const EmployeeVisitor& onEmployee, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "Could not open file: " + path;
+        return false;
+    }
+
+    // Stream the document: only the record being parsed is held in memory
+    EmployeeSaxHandler handler(onEmployee);
+    try {
+        if (!json::sax_parse(file, &handler)) {
+            error = handler.parseError();
+            return false;
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+
+    Logger::get()->debug("Streamed {} employee records from JSON", handler.recordCount());
+    return true;
+}
+
+// Serialize employees one record at a time, laid out like a document-level
+// dump(4) so the snapshot stays readable without building the whole DOM
+bool Snapshot::writeJson(const std::string& path, const EmployeeSource& source, std::string& error) {
+    SnapshotFile file(path);
+    bool ok = file.write("{\n    \"data\": [");
+    bool first = true;
+    source([&](const Employee& emp) {
+        std::string record;
+        try {
+            record = employeeToJson(emp).dump(4);
+        } catch (const std::exception& e) {
+            error = e.what();
+            ok = false;
+            return;
+        }
+        std::string indented = first ? "\n        " : ",\n        ";
+        for (char c : record) {
+            indented += c;
+            if (c == '\n') {
+                indented += "        ";
+            }
+        }
+        ok = ok && file.write(indented);
+        first = false;
+    });
+    ok = ok && file.write(first ? "]\n}" : "\n    ]\n}") && file.commit();
+    if (!ok && error.empty()) {
+        error = file.lastError();
+    }
+    return ok;
+}
+
+bool Snapshot::readJsonLines(const std::string& path, const EmployeeVisitor& onEmployee, std::string& error,
+                             unsigned threads) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        error = "Could not open file: " + path;
+        return false;
+    }
+    if (st.st_size == 0) {
+        return true;
+    }
+
+    MappedFile file;
+    if (!file.map(path, error)) {
+        return false;
+    }
+    const char* base = file.bytes();
+    const size_t fileSize = file.length();
+
+    // Ranges below this size are not worth a thread
+    const size_t kMinRangeBytes = 256 * 1024;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t rangeCount = std::max<size_t>(1, std::min<size_t>(threads, fileSize / kMinRangeBytes));
+
+    // Every range after the first starts just past a newline
+    std::vector<size_t> bounds = {0};
+    for (size_t i = 1; i < rangeCount; i++) {
+        size_t start = std::max(bounds.back(), fileSize / rangeCount * i);
+        const void* newline = std::memchr(base + start, '\n', fileSize - start);
+        start = newline ? static_cast<const char*>(newline) - base + 1 : fileSize;
+        if (start > bounds.back() && start < fileSize) {
+            bounds.push_back(start);
+        }
+    }
+    bounds.push_back(fileSize);
+
+    // Workers never log; their warnings are reported here in file order
+    struct ParsedRange {
+        std::vector<Employee> employees;
+        std::vector<std::string> warnings;
+    };
+    auto parseRange = [base](size_t begin, size_t end) {
+        ParsedRange range;
+        while (begin < end) {
+            const void* newline = std::memchr(base + begin, '\n', end - begin);
+            size_t lineEnd = newline ? static_cast<const char*>(newline) - base : end;
+            if (lineEnd > begin) {
+                json item = json::parse(base + begin, base + lineEnd, nullptr, false);
+                if (item.is_discarded()) {
+                    range.warnings.push_back("invalid JSON at byte " + std::to_string(begin));
+                } else {
+                    try {
+                        range.employees.push_back(employeeFromJson(item));
+                    } catch (const std::exception& e) {
+                        range.warnings.push_back(e.what());
+                    }
+                }
+            }
+            begin = lineEnd + 1;
+        }
+        return range;
+    };
+
+    std::vector<std::future<ParsedRange>> pending;
+    for (size_t i = 0; i + 1 < bounds.size(); i++) {
+        pending.push_back(std::async(std::launch::async, parseRange, bounds[i], bounds[i + 1]));
+    }
+
+    // Merge each range as soon as it is ready; later ranges keep parsing meanwhile
+    size_t records = 0;
+    for (auto& future : pending) {
+        ParsedRange range = future.get();
+        for (const auto& warning : range.warnings) {
+            Logger::get()->warn("Failed to parse employee record: {}", warning);
+        }
+        for (const auto& emp : range.employees) {
+            onEmployee(emp);
+        }
+        records += range.employees.size();
+    }
+
+    Logger::get()->debug("Parsed {} employee records from JSONL using {} ranges", records, pending.size());
+    return true;
+}
+
+bool Snapshot::writeJsonLines(const std::string& path, const EmployeeSource& source, std::string& error) {
+    SnapshotFile file(path);
+    bool ok = true;
+    source([&](const Employee& emp) {
+        try {
+            ok = ok && file.write(employeeToJson(emp).dump() + "\n");
+        } catch (const std::exception& e) {
+            error = e.what();
+            ok = false;
+        }
+    });
+    ok = ok && file.commit();
+    if (!ok && error.empty()) {
+        error = file.lastError();
+    }
+    return ok;
+}
+
+bool Snapshot::readBinary(const std::string& path, const EmployeeVisitor& onEmployee, std::string& error) {
+    MappedFile file;
+    if (!file.map(path, error)) {
+        return false;
+    }
+
+    const char* base = file.bytes();
+    const size_t fileSize = file.length();
+    BinarySnapshotHeader header;
+    if (fileSize < sizeof(header)) {
+        error = "Binary snapshot is truncated: " + path;
+        return false;
+    }
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) != 0) {
+        error = "Not a binary employee snapshot: " + path;
+        return false;
+    }
+    if (header.version != kBinarySnapshotVersion || header.headerSize != sizeof(header)) {
+        error = "Unsupported binary snapshot version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.headerChecksum != headerChecksum(header)) {
+        error = "Binary snapshot header checksum mismatch: " + path;
+        return false;
+    }
+
+    const std::uint64_t rows = header.rowCount;
+    const std::uint64_t offsetCount = rows * kBinaryFieldsPerRow + 1;
+    if (header.salaryOffset != sizeof(header) ||
+        header.ageOffset != header.salaryOffset + rows * sizeof(std::int32_t) ||
+        header.stringOffsetsOffset != alignTo8(header.ageOffset + rows * sizeof(std::int32_t)) ||
+        header.heapOffset != header.stringOffsetsOffset + offsetCount * sizeof(std::uint64_t) ||
+        header.heapOffset + header.heapSize != fileSize) {
+        error = "Binary snapshot layout does not match its size: " + path;
+        return false;
+    }
+
+    if (crc32(base + header.salaryOffset, header.heapOffset - header.salaryOffset) != header.columnsChecksum ||
+        crc32(base + header.heapOffset, header.heapSize) != header.heapChecksum) {
+        error = "Binary snapshot checksum mismatch: " + path;
+        return false;
+    }
+
+    const std::int32_t* salaries = reinterpret_cast<const std::int32_t*>(base + header.salaryOffset);
+    const std::int32_t* ages = reinterpret_cast<const std::int32_t*>(base + header.ageOffset);
+    const std::uint64_t* offsets = reinterpret_cast<const std::uint64_t*>(base + header.stringOffsetsOffset);
+    const char* heap = base + header.heapOffset;
+
+    if (offsets[0] != 0 || offsets[offsetCount - 1] != header.heapSize) {
+        error = "Binary snapshot string offsets are out of range: " + path;
+        return false;
+    }
+    for (std::uint64_t i = 1; i < offsetCount; i++) {
+        if (offsets[i] < offsets[i - 1]) {
+            error = "Binary snapshot string offsets are out of range: " + path;
+            return false;
+        }
+    }
+
+    auto field = [&](std::uint64_t row, size_t index) {
+        std::uint64_t slot = row * kBinaryFieldsPerRow + index;
+        return std::string(heap + offsets[slot], heap + offsets[slot + 1]);
+    };
+
+    Logger::get()->debug("Mapping {} employee records from binary snapshot", rows);
+    for (std::uint64_t row = 0; row < rows; row++) {
+        onEmployee(Employee(field(row, 0), field(row, 1),
+                            salaries[row] == kBinaryNotNumeric ? field(row, 4) : std::to_string(salaries[row]),
+                            ages[row] == kBinaryNotNumeric ? field(row, 5) : std::to_string(ages[row]),
+                            field(row, 2), field(row, 3)));
+    }
+    return true;
+}
+
+bool Snapshot::writeBinary(const std::string& path, std::size_t count, const EmployeeSource& source, std::string& error) {
+    BinarySnapshotHeader header{};
+    std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+    header.version = kBinarySnapshotVersion;
+    header.headerSize = sizeof(header);
+    header.rowCount = count;
+    header.salaryOffset = sizeof(header);
+    header.ageOffset = header.salaryOffset + count * sizeof(std::int32_t);
+    header.stringOffsetsOffset = alignTo8(header.ageOffset + count * sizeof(std::int32_t));
+    header.heapOffset = header.stringOffsetsOffset + (count * kBinaryFieldsPerRow + 1) * sizeof(std::uint64_t);
+
+    // The numeric columns and offsets are small and kept in memory; the string
+    // heap is streamed straight to its final position in the file
+    std::vector<char> columns(header.heapOffset - header.salaryOffset, 0);
+    std::int32_t* salaries = reinterpret_cast<std::int32_t*>(columns.data());
+    std::int32_t* ages = reinterpret_cast<std::int32_t*>(columns.data() + (header.ageOffset - header.salaryOffset));
+    std::uint64_t* offsets = reinterpret_cast<std::uint64_t*>(
+        columns.data() + (header.stringOffsetsOffset - header.salaryOffset));
+
+    SnapshotFile file(path);
+    bool ok = file.seek(header.heapOffset);
+    std::uint64_t heapSize = 0;
+    std::uint32_t heapCrc = 0;
+    std::size_t row = 0;
+    offsets[0] = 0;
+
+    source([&](const Employee& emp) {
+        if (!ok || row >= count) {
+            ok = false;
+            return;
+        }
+        salaries[row] = canonicalInt(emp.getSalary());
+        ages[row] = canonicalInt(emp.getAge());
+
+        const std::array<std::string, kBinaryFieldsPerRow> fields = {
+            emp.getId(), emp.getName(), emp.getTitle(), emp.getEmail(),
+            salaries[row] == kBinaryNotNumeric ? emp.getSalary() : std::string(),
+            ages[row] == kBinaryNotNumeric ? emp.getAge() : std::string()};
+        for (size_t i = 0; i < fields.size(); i++) {
+            ok = ok && file.write(fields[i]);
+            heapCrc = crc32(fields[i].data(), fields[i].size(), heapCrc);
+            heapSize += fields[i].size();
+            offsets[row * kBinaryFieldsPerRow + i + 1] = heapSize;
+        }
+        row++;
+    });
+
+    if (ok && row != count) {
+        ok = false;
+        error = "Expected " + std::to_string(count) + " employees but got " + std::to_string(row);
+        return false;
+    }
+
+    header.heapSize = heapSize;
+    header.heapChecksum = heapCrc;
+    header.columnsChecksum = crc32(columns.data(), columns.size());
+    header.headerChecksum = headerChecksum(header);
+
+    ok = ok && file.writeAt(0, &header, sizeof(header)) &&
+         file.writeAt(header.salaryOffset, columns.data(), columns.size()) && file.commit();
+    if (!ok && error.empty()) {
+        error = file.lastError();
+    }
+    return ok;
+}
+
+std::uint32_t Snapshot::crc32(const void* data, std::size_t size, std::uint32_t crc) {
+    static const std::array<std::uint32_t, 256> table = []() {
+        std::array<std::uint32_t, 256> entries{};
+        for (std::uint32_t i = 0; i < entries.size(); i++) {
+            std::uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
@@ -0,0 +1,85 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include "employee.h"
+#include "nlohmann/json.hpp"
+
+// On-disk snapshot formats, chosen by file extension
+enum class SnapshotFormat {
+    Json,       // {"data": [...]} document (default)
+    JsonLines,  // one employee object per line, parsed in parallel (.jsonl)
+    Binary      // memory-mappable columns, see BinarySnapshotHeader (.bin)
+};
+
+// Receives every employee read from or written to a snapshot
+using EmployeeVisitor = std::function<void(const Employee&)>;
+using EmployeeSource = std::function<void(const EmployeeVisitor&)>;
+
+// Binary snapshot layout (version 1, little-endian):
+//
+//   [header][int32 salary x N][int32 age x N][pad to 8]
+//   [uint64 string offsets x (6N + 1)][string heap]
+//
+// Field k of row r is heap[offsets[6r + k], offsets[6r + k + 1]) with fields
+// ordered id, name, title, email, salary text, age text. Salary and age are
+// stored as integers; the text fields are empty unless the original value is
+// not a canonical integer, in which case the column holds kBinaryNotNumeric.
+struct BinarySnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint64_t rowCount;
+    std::uint64_t salaryOffset;
+    std::uint64_t ageOffset;
+    std::uint64_t stringOffsetsOffset;
+    std::uint64_t heapOffset;
+    std::uint64_t heapSize;
+    std::uint32_t columnsChecksum;  // CRC32 of the numeric columns and offset table
+    std::uint32_t heapChecksum;     // CRC32 of the string heap
+    std::uint32_t headerChecksum;   // CRC32 of the header up to this field
+    std::uint32_t reserved;
+};
+
+constexpr std::uint32_t kBinarySnapshotVersion = 1;
+constexpr std::int32_t kBinaryNotNumeric = std::numeric_limits<std::int32_t>::min();
+constexpr std::size_t kBinaryFieldsPerRow = 6;
+
+class Snapshot {
+public:
+    static SnapshotFormat formatForPath(const std::string& path);
+
+    // Read every employee in the snapshot. Malformed records are skipped with a
+    // warning; a missing or corrupt file returns false with the reason in error.
+    static bool read(const std::string& path, const EmployeeVisitor& onEmployee, std::string& error);
+
+    // Write count employees produced by source to a temp file, fsync it and rename
+    // it over path. Never logs, so it is safe to call from a forked child.
+    static bool write(const std::string& path, std::size_t count, const EmployeeSource& source, std::string& error);
+
+    static bool readJson(const std::string& path, const EmployeeVisitor& onEmployee, std::string& error);
+    static bool writeJson(const std::string& path, const EmployeeSource& source, std::string& error);
+
+    // Split the file into byte ranges at newline boundaries and parse them on
+    // threads workers (0 = one per core). onEmployee is called on the calling
+    // thread, in file order, so later lines still replace earlier ones.
+    static bool readJsonLines(const std::string& path, const EmployeeVisitor& onEmployee, std::string& error,
+                              unsigned threads = 0);
+    static bool writeJsonLines(const std::string& path, const EmployeeSource& source, std::string& error);
+
+    // The binary reader maps the file and builds records straight from the mapped
+    // columns; no per-record parsing takes place
+    static bool readBinary(const std::string& path, const EmployeeVisitor& onEmployee, std::string& error);
+    static bool writeBinary(const std::string& path, std::size_t count, const EmployeeSource& source, std::string& error);
+
+    static nlohmann::json employeeToJson(const Employee& emp);
+    static Employee employeeFromJson(const nlohmann::json& item);
+
+    static std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t crc = 0);
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,134 @@
+#include "substring_search.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SUBSTRING_SEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+size_t findScalar(std::string_view text, std::string_view needle, size_t from) {
+    return text.find(needle, from);
+}
+
+#ifdef SUBSTRING_SEARCH_X86
+
+// Both kernels need a needle of at least two bytes and room for it after from.
+// A block starting at i tests the positions i to i + width - 1: one load for
+// their first bytes and one, needle.size() - 1 further on, for their last.
+
+size_t findSse2(std::string_view text, std::string_view needle, size_t from) {
+    const char* data = text.data();
+    const size_t length = needle.size();
+    const __m128i first = _mm_set1_epi8(needle.front());
+    const __m128i last = _mm_set1_epi8(needle.back());
+    size_t i = from;
+    for (; i + length - 1 + 16 <= text.size(); i += 16) {
+        __m128i firsts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i lasts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + length - 1));
+        auto mask = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, firsts), _mm_cmpeq_epi8(last, lasts))));
+        while (mask != 0) {
+            size_t at = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (std::memcmp(data + at + 1, needle.data() + 1, length - 2) == 0) {
+                return at;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(text, needle, i);
+}
+
+__attribute__((target("avx2")))
+size_t findAvx2(std::string_view text, std::string_view needle, size_t from) {
+    const char* data = text.data();
+    const size_t length = needle.size();
+    const __m256i first = _mm256_set1_epi8(needle.front());
+    const __m256i last = _mm256_set1_epi8(needle.back());
+    size_t i = from;
+    for (; i + length - 1 + 32 <= text.size(); i += 32) {
+        __m256i firsts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i lasts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + length - 1));
+        auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, firsts), _mm256_cmpeq_epi8(last, lasts))));
+        while (mask != 0) {
+            size_t at = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (std::memcmp(data + at + 1, needle.data() + 1, length - 2) == 0) {
+                return at;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(text, needle, i);
+}
+
+#endif // SUBSTRING_SEARCH_X86
+
+SearchKernel detectKernel() {
+#ifdef SUBSTRING_SEARCH_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? SearchKernel::Avx2 : SearchKernel::Sse2;
+#else
+    return SearchKernel::Scalar;
+#endif
+}
+
+} // namespace
+
+SearchKernel bestSearchKernel() {
+    static const SearchKernel best = detectKernel();
+    return best;
+}
+
+bool searchKernelSupported(SearchKernel kernel) {
+    switch (kernel) {
+        case SearchKernel::Scalar:
+            return true;
+        case SearchKernel::Sse2:
+            return bestSearchKernel() != SearchKernel::Scalar;
+        case SearchKernel::Avx2:
+            return bestSearchKernel() == SearchKernel::Avx2;
+    }
+    return false;
+}
+
+const char* searchKernelName(SearchKernel kernel) {
+    switch (kernel) {
+        case SearchKernel::Scalar:
+            return "scalar";
+        case SearchKernel::Sse2:
+            return "sse2";
+        case SearchKernel::Avx2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+size_t findSubstring(std::string_view text, std::string_view needle, size_t from) {
+    return findSubstring(bestSearchKernel(), text, needle, from);
+}
+
+size_t findSubstring(SearchKernel kernel, std::string_view text, std::string_view needle, size_t from) {
+    // Single bytes go to memchr, which is vectorized already
+    if (needle.size() < 2 || from >= text.size() || text.size() - from < needle.size()) {
+        return findScalar(text, needle, from);
+    }
+#ifdef SUBSTRING_SEARCH_X86
+    if (!searchKernelSupported(kernel)) {
+        kernel = bestSearchKernel();
+    }
+    switch (kernel) {
+        case SearchKernel::Avx2:
+            return findAvx2(text, needle, from);
+        case SearchKernel::Sse2:
+            return findSse2(text, needle, from);
+        case SearchKernel::Scalar:
+            break;
+    }
+#else
+    (void) kernel;
+#endif
+    return findScalar(text, needle, from);
+}
@@ -0,0 +1,27 @@
+#ifndef SUBSTRING_SEARCH_H
+#define SUBSTRING_SEARCH_H
+
+#include <cstddef>
+#include <string_view>
+
+// Exact substring search over a long buffer of packed text. The vector
+// kernels compare a whole block of positions against the first and last byte
+// of the needle at once and only check the middle of the positions where both
+// match, which on text skips almost every position in one step.
+enum class SearchKernel {
+    Scalar,  // std::string_view::find, on any CPU
+    Sse2,    // 16 positions per step, on every x86-64 CPU
+    Avx2     // 32 positions per step, when the CPU has AVX2
+};
+
+// Fastest kernel the CPU running us supports, checked once
+SearchKernel bestSearchKernel();
+bool searchKernelSupported(SearchKernel kernel);
+const char* searchKernelName(SearchKernel kernel);
+
+// Offset of the first occurrence of needle in text at or after from, or
+// std::string_view::npos. An empty needle matches at from.
+size_t findSubstring(std::string_view text, std::string_view needle, size_t from = 0);
+size_t findSubstring(SearchKernel kernel, std::string_view text, std::string_view needle, size_t from = 0);
+
+#endif // SUBSTRING_SEARCH_H
@@ -0,0 +1,77 @@
+#include "text_column.h"
+
+TextColumn::Chunk& TextColumn::writableChunk(size_t index) {
+    // Chunks are only shared with other copies of the column, which are made
+    // while no one writes to this one, so use_count() is stable here
+    if (chunks[index].use_count() > 1) {
+        chunks[index] = std::make_shared<Chunk>(*chunks[index]);
+    }
+    return *chunks[index];
+}
+
+TextColumn::Chunk& TextColumn::appendChunk() {
+    if (count % kChunkSize == 0) {
+        chunks.push_back(std::make_shared<Chunk>());
+        chunks.back()->ends.reserve(kChunkSize);
+    }
+    return writableChunk(chunks.size() - 1);
+}
+
+size_t TextColumn::size() const {
+    return count;
+}
+
+std::string_view TextColumn::operator[](size_t row) const {
+    const Chunk& chunk = *chunks[row / kChunkSize];
+    size_t index = row % kChunkSize;
+    size_t start = index == 0 ? 0 : chunk.ends[index - 1];
+    return std::string_view(chunk.text).substr(start, chunk.ends[index] - start);
+}
+
+void TextColumn::push_back(std::string_view text) {
+    Chunk& chunk = appendChunk();
+    chunk.text.append(text.data(), text.size());
+    chunk.ends.push_back(static_cast<std::uint32_t>(chunk.text.size()));
+    count++;
+}
+
+void TextColumn::pop_back() {
+    Chunk& chunk = writableChunk(chunks.size() - 1);
+    chunk.ends.pop_back();
+    chunk.text.resize(chunk.ends.empty() ? 0 : chunk.ends.back());
+    count--;
+    if (count % kChunkSize == 0) {
+        chunks.pop_back();
+    }
+}
+
+void TextColumn::set(size_t row, std::string_view text) {
+    Chunk& chunk = writableChunk(row / kChunkSize);
+    size_t index = row % kChunkSize;
+    size_t start = index == 0 ? 0 : chunk.ends[index - 1];
+    size_t oldLength = chunk.ends[index] - start;
+    // replace() copes with text pointing into chunk.text itself
+    chunk.text.replace(start, oldLength, text.data(), text.size());
+    // Unsigned wraparound gives the right offsets whichever way the row changed
+    auto shift = static_cast<std::uint32_t>(text.size() - oldLength);
+    for (size_t i = index; i < chunk.ends.size(); i++) {
+        chunk.ends[i] += shift;
+    }
+}
+
+void TextColumn::clear() {
+    chunks.clear();
+    count = 0;
+}
+
+void TextColumn::reserve(size_t rows) {
+    chunks.reserve((rows + kChunkSize - 1) / kChunkSize);
+}
+
+size_t TextColumn::textBytes() const {
+    size_t bytes = 0;
+    for (const auto& chunk : chunks) {
+        bytes += chunk->text.size();
+    }
+    return bytes;
+}
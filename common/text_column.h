@@ -0,0 +1,49 @@
+#ifndef TEXT_COLUMN_H
+#define TEXT_COLUMN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Column of strings packed back to back per chunk of rows, with the end offset
+// of every row alongside. Chunks are shared between copies like those of
+// ChunkedColumn, but cloning one copies two flat buffers instead of allocating
+// a string per row, so a write to a chunk that is no longer in cache stays cheap.
+class TextColumn {
+protected:
+    static constexpr size_t kChunkSize = 1024;
+
+    struct Chunk {
+        std::string text;                 // values back to back
+        std::vector<std::uint32_t> ends;  // offset in text just past each row
+    };
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    size_t count = 0;
+
+    Chunk& writableChunk(size_t index);
+
+    // Writable chunk the next row goes into, started if the last one is full
+    Chunk& appendChunk();
+
+public:
+    size_t size() const;
+
+    // Text of a row, valid until the next write
+    std::string_view operator[](size_t row) const;
+
+    void push_back(std::string_view text);
+    void pop_back();
+    // text may be another row of this column
+    void set(size_t row, std::string_view text);
+    void clear();
+    void reserve(size_t rows);
+
+    // Bytes of packed text, which is what a scan reads
+    size_t textBytes() const;
+};
+
+#endif // TEXT_COLUMN_H
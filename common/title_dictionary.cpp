@@ -0,0 +1,91 @@
+#include "title_dictionary.h"
+#include "trigram_index.h"
+
+std::uint32_t& TitleDictionary::positionOf(size_t row) {
+    while (slotOfRow.size() <= row) {
+        slotOfRow.push_back(0);
+    }
+    return slotOfRow.mutableAt(row);
+}
+
+std::uint32_t TitleDictionary::add(const std::string& title, size_t row) {
+    std::uint32_t code;
+    if (auto found = codeByTitle.findAny(title)) {
+        code = *found;
+    } else {
+        if (!freeCodes.empty()) {
+            code = freeCodes.back();
+            freeCodes.pop_back();
+        } else {
+            code = static_cast<std::uint32_t>(entries.size());
+            entries.push_back(Entry());
+            foldedTitles.push_back(std::string_view());
+        }
+        entries.mutableAt(code).title = title;
+        foldedTitles.set(code, title);
+        codeByTitle.insert(title, code);
+    }
+
+    auto& postings = entries.mutableAt(code).rows;
+    positionOf(row) = static_cast<std::uint32_t>(postings.size());
+    postings.push_back(static_cast<std::uint32_t>(row));
+    return code;
+}
+
+void TitleDictionary::remove(std::uint32_t code, size_t row) {
+    // Swap the last posting into the removed slot
+    Entry& entry = entries.mutableAt(code);
+    std::uint32_t slot = slotOfRow[row];
+    std::uint32_t moved = entry.rows.back();
+    entry.rows.mutableAt(slot) = moved;
+    slotOfRow.mutableAt(moved) = slot;
+    entry.rows.pop_back();
+
+    if (entry.rows.empty()) {
+        codeByTitle.erase(entry.title, code);
+        entry.title.clear();
+        foldedTitles.set(code, std::string_view());
+        freeCodes.push_back(code);
+    }
+}
+
+void TitleDictionary::moveRow(std::uint32_t code, size_t from, size_t to) {
+    std::uint32_t slot = slotOfRow[from];
+    entries.mutableAt(code).rows.mutableAt(slot) = static_cast<std::uint32_t>(to);
+    positionOf(to) = slot;
+}
+
+void TitleDictionary::clear() {
+    entries.clear();
+    foldedTitles.clear();
+    codeByTitle.clear();
+    freeCodes.clear();
+    slotOfRow.clear();
+}
+
+const std::string& TitleDictionary::title(std::uint32_t code) const {
+    return entries[code].title;
+}
+
+const ChunkedColumn<std::uint32_t>& TitleDictionary::rows(std::uint32_t code) const {
+    return entries[code].rows;
+}
+
+size_t TitleDictionary::distinctCount() const {
+    return codeByTitle.size();
+}
+
+std::vector<std::uint32_t> TitleDictionary::codesContaining(const std::string& needle) const {
+    std::vector<std::uint32_t> codes;
+    foldedTitles.forEachContaining(TrigramIndex::fold(needle),
+                                   [&codes](size_t code) { codes.push_back(static_cast<std::uint32_t>(code)); });
+    return codes;
+}
+
+std::vector<std::uint32_t> TitleDictionary::rowsContaining(const std::string& needle) const {
+    std::vector<std::uint32_t> result;
+    foldedTitles.forEachContaining(TrigramIndex::fold(needle), [this, &result](size_t code) {
+        entries[code].rows.forEach([&result](std::uint32_t row) { result.push_back(row); });
+    });
+    return result;
+}
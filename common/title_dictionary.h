@@ -0,0 +1,62 @@
+#ifndef TITLE_DICTIONARY_H
+#define TITLE_DICTIONARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "chunked_column.h"
+#include "folded_text_column.h"
+#include "hash_slots.h"
+
+// Interns job titles into integer codes and keeps a posting list of table rows
+// per distinct title. Each title string is stored once (plus a case-folded
+// copy, packed with the others for searching) however many employees share
+// it. Codes of titles nobody holds any more are reused. Titles, posting lists
+// and the position of every row are chunked and shared with copies of the
+// dictionary, so a copy costs a pointer per chunk and a write clones the
+// chunks it touches.
+class TitleDictionary {
+private:
+    struct Entry {
+        std::string title;
+        ChunkedColumn<std::uint32_t> rows;
+    };
+
+    ChunkedColumn<Entry> entries;
+    FoldedTextColumn foldedTitles;  // by code, empty for free codes
+    HashSlots<std::string> codeByTitle;
+    ChunkedColumn<std::uint32_t> freeCodes;
+    ChunkedColumn<std::uint32_t> slotOfRow;  // position of each row inside its posting list
+
+    // Position of a row, growing the column up to it first
+    std::uint32_t& positionOf(size_t row);
+
+public:
+    // Record that row holds title; returns the title's code
+    std::uint32_t add(const std::string& title, size_t row);
+
+    // Drop row from the posting list of code
+    void remove(std::uint32_t code, size_t row);
+
+    // Row from has been renumbered to; it keeps its title
+    void moveRow(std::uint32_t code, size_t from, size_t to);
+
+    void clear();
+
+    const std::string& title(std::uint32_t code) const;
+    const ChunkedColumn<std::uint32_t>& rows(std::uint32_t code) const;
+
+    // Number of titles currently held by at least one row
+    size_t distinctCount() const;
+
+    // Rows whose title contains needle, ignoring case. Only the distinct titles
+    // are compared; matching postings are then expanded.
+    std::vector<std::uint32_t> rowsContaining(const std::string& needle) const;
+
+    // Codes of the titles containing needle, ignoring case, so callers can
+    // size or filter the postings before expanding them
+    std::vector<std::uint32_t> codesContaining(const std::string& needle) const;
+};
+
+#endif // TITLE_DICTIONARY_H
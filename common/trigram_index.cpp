@@ -0,0 +1,266 @@
+#include "trigram_index.h"
+#include <algorithm>
+#include <iterator>
+
+std::string TrigramIndex::fold(std::string_view text) {
+    std::string folded(text);
+    for (char& c : folded) {
+        c = fold(c);
+    }
+    return folded;
+}
+
+std::vector<std::uint32_t> TrigramIndex::trigramsOf(std::string_view folded) {
+    std::vector<std::uint32_t> trigrams;
+    if (folded.size() < kMinQueryLength) {
+        return trigrams;
+    }
+    trigrams.reserve(folded.size() - 2);
+    for (size_t i = 0; i + 2 < folded.size(); i++) {
+        trigrams.push_back(static_cast<std::uint32_t>(static_cast<unsigned char>(folded[i])) << 16 |
+                           static_cast<std::uint32_t>(static_cast<unsigned char>(folded[i + 1])) << 8 |
+                           static_cast<std::uint32_t>(static_cast<unsigned char>(folded[i + 2])));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+// Slice of one posting list. Blocks are only shared with copies of the
+// index, which are made while no one writes to this one, so use_count() is
+// stable when deciding whether to clone.
+struct TrigramIndex::Block {
+    std::vector<std::uint32_t> slots;  // sorted
+};
+
+// Sorted slots of one trigram as a run of blocks; firsts[i] is the smallest
+// slot in blocks[i]
+struct TrigramIndex::PostingList {
+    static constexpr size_t kBlockSize = 1024;  // blocks split when they reach twice this
+
+    std::vector<std::shared_ptr<Block>> blocks;
+    std::vector<std::uint32_t> firsts;
+    size_t count = 0;
+
+    // Block that holds slot, or would hold it
+    size_t blockFor(std::uint32_t slot) const {
+        auto after = std::upper_bound(firsts.begin(), firsts.end(), slot);
+        return after == firsts.begin() ? 0 : static_cast<size_t>(after - firsts.begin()) - 1;
+    }
+
+    std::vector<std::uint32_t>& writableBlock(size_t index) {
+        if (blocks[index].use_count() > 1) {
+            blocks[index] = std::make_shared<Block>(*blocks[index]);
+        }
+        return blocks[index]->slots;
+    }
+
+    void insert(std::uint32_t slot) {
+        if (blocks.empty()) {
+            blocks.push_back(std::make_shared<Block>());
+            firsts.push_back(slot);
+        }
+        size_t index = blockFor(slot);
+        auto& slots = writableBlock(index);
+        auto at = std::lower_bound(slots.begin(), slots.end(), slot);
+        if (at != slots.end() && *at == slot) {
+            return;
+        }
+        slots.insert(at, slot);
+        firsts[index] = slots.front();
+        count++;
+
+        if (slots.size() >= 2 * kBlockSize) {
+            auto upper = std::make_shared<Block>();
+            upper->slots.assign(slots.begin() + kBlockSize, slots.end());
+            slots.resize(kBlockSize);
+            firsts.insert(firsts.begin() + index + 1, upper->slots.front());
+            blocks.insert(blocks.begin() + index + 1, std::move(upper));
+        }
+    }
+
+    void erase(std::uint32_t slot) {
+        if (blocks.empty()) {
+            return;
+        }
+        size_t index = blockFor(slot);
+        const auto& shared = blocks[index]->slots;
+        auto found = std::lower_bound(shared.begin(), shared.end(), slot);
+        if (found == shared.end() || *found != slot) {
+            return;  // not here, so nothing to clone
+        }
+        auto offset = found - shared.begin();
+        auto& slots = writableBlock(index);
+        slots.erase(slots.begin() + offset);
+        count--;
+        if (slots.empty()) {
+            blocks.erase(blocks.begin() + index);
+            firsts.erase(firsts.begin() + index);
+        } else {
+            firsts[index] = slots.front();
+        }
+    }
+
+    // Whether slot is in the list; cursor carries the block position between
+    // calls made with ascending slots
+    bool contains(std::uint32_t slot, size_t& cursor) const {
+        auto after = std::upper_bound(firsts.begin() + cursor, firsts.end(), slot);
+        if (after == firsts.begin() + cursor) {
+            return false;  // below the cursor block's first slot
+        }
+        cursor = static_cast<size_t>(after - firsts.begin()) - 1;
+        const auto& slots = blocks[cursor]->slots;
+        return std::binary_search(slots.begin(), slots.end(), slot);
+    }
+
+    std::vector<std::uint32_t> flatten() const {
+        std::vector<std::uint32_t> all;
+        all.reserve(count);
+        for (const auto& block : blocks) {
+            all.insert(all.end(), block->slots.begin(), block->slots.end());
+        }
+        return all;
+    }
+};
+
+size_t TrigramIndex::bucketOf(std::uint32_t trigram) {
+    return static_cast<size_t>((trigram * 2654435761u) >> 24);
+}
+
+TrigramIndex::Bucket& TrigramIndex::writableBucket(std::uint32_t trigram) {
+    auto& bucket = buckets[bucketOf(trigram)];
+    if (!bucket) {
+        bucket = std::make_shared<Bucket>();
+    } else if (bucket.use_count() > 1) {
+        bucket = std::make_shared<Bucket>(*bucket);
+    }
+    return *bucket;
+}
+
+TrigramIndex::PostingList& TrigramIndex::writable(Posting& posting) {
+    if (posting.list.use_count() > 1) {
+        posting.list = std::make_shared<PostingList>(*posting.list);
+    }
+    return *posting.list;
+}
+
+bool TrigramIndex::trigramBefore(const Posting& posting, std::uint32_t trigram) {
+    return posting.trigram < trigram;
+}
+
+void TrigramIndex::insert(std::uint32_t trigram, std::uint32_t slot) {
+    auto& postings = writableBucket(trigram).postings;
+    auto at = std::lower_bound(postings.begin(), postings.end(), trigram, trigramBefore);
+    if (at == postings.end() || at->trigram != trigram) {
+        at = postings.insert(at, Posting{trigram, std::make_shared<PostingList>()});
+        trigrams++;
+    }
+    writable(*at).insert(slot);
+}
+
+void TrigramIndex::erase(std::uint32_t trigram, std::uint32_t slot) {
+    const PostingList* existing = find(trigram);
+    if (!existing) {
+        return;
+    }
+    auto& postings = writableBucket(trigram).postings;
+    auto at = std::lower_bound(postings.begin(), postings.end(), trigram, trigramBefore);
+    PostingList& list = writable(*at);
+    list.erase(slot);
+    if (list.count == 0) {
+        postings.erase(at);
+        trigrams--;
+    }
+}
+
+const TrigramIndex::PostingList* TrigramIndex::find(std::uint32_t trigram) const {
+    const auto& bucket = buckets[bucketOf(trigram)];
+    if (!bucket) {
+        return nullptr;
+    }
+    auto at = std::lower_bound(bucket->postings.begin(), bucket->postings.end(), trigram, trigramBefore);
+    if (at == bucket->postings.end() || at->trigram != trigram) {
+        return nullptr;
+    }
+    return at->list.get();
+}
+
+void TrigramIndex::add(std::uint32_t slot, std::string_view text) {
+    for (std::uint32_t trigram : trigramsOf(fold(text))) {
+        insert(trigram, slot);
+    }
+}
+
+void TrigramIndex::remove(std::uint32_t slot, std::string_view text) {
+    for (std::uint32_t trigram : trigramsOf(fold(text))) {
+        erase(trigram, slot);
+    }
+}
+
+void TrigramIndex::update(std::uint32_t slot, std::string_view oldText, std::string_view newText) {
+    std::vector<std::uint32_t> before = trigramsOf(fold(oldText));
+    std::vector<std::uint32_t> after = trigramsOf(fold(newText));
+    std::vector<std::uint32_t> gone, added;
+    std::set_difference(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(gone));
+    std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(added));
+    for (std::uint32_t trigram : gone) {
+        erase(trigram, slot);
+    }
+    for (std::uint32_t trigram : added) {
+        insert(trigram, slot);
+    }
+}
+
+void TrigramIndex::clear() {
+    buckets.fill(nullptr);
+    trigrams = 0;
+}
+
+std::vector<std::uint32_t> TrigramIndex::candidates(std::string_view foldedNeedle) const {
+    std::vector<const PostingList*> lists;
+    for (std::uint32_t trigram : trigramsOf(foldedNeedle)) {
+        const PostingList* list = find(trigram);
+        if (!list) {
+            return {};  // some trigram occurs nowhere
+        }
+        lists.push_back(list);
+    }
+    if (lists.empty()) {
+        return {};
+    }
+
+    // Start from the rarest trigram and narrow it down with the others, probing
+    // each list in ascending order. Once few candidates are left, checking them
+    // against the text is cheaper than searching the remaining, longer lists.
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->count < b->count; });
+    std::vector<std::uint32_t> result = lists.front()->flatten();
+    for (size_t i = 1; i < lists.size() && result.size() > kVerifyDirectly; i++) {
+        size_t cursor = 0;
+        size_t kept = 0;
+        for (std::uint32_t slot : result) {
+            if (lists[i]->contains(slot, cursor)) {
+                result[kept++] = slot;
+            }
+        }
+        result.resize(kept);
+    }
+    return result;
+}
+
+size_t TrigramIndex::estimate(std::string_view foldedNeedle) const {
+    size_t fewest = 0;
+    bool first = true;
+    for (std::uint32_t trigram : trigramsOf(foldedNeedle)) {
+        const PostingList* list = find(trigram);
+        if (!list) {
+            return 0;
+        }
+        fewest = first ? list->count : std::min<size_t>(fewest, list->count);
+        first = false;
+    }
+    return fewest;
+}
+
+size_t TrigramIndex::trigramCount() const {
+    return trigrams;
+}
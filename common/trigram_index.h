@@ -0,0 +1,82 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Inverted index from the case-folded trigrams of a text column to the handle
+// slots of the rows containing them. Slots do not change when rows move, so
+// erasing a row only touches the erased row's own trigrams. A substring query
+// of three or more characters intersects the posting lists of its trigrams;
+// the survivors only might match and still need checking against the text.
+// Copies share everything down to the blocks of each posting list: trigrams
+// are hashed into buckets of postings, and each list is split into sorted
+// blocks, so changing a copy clones one bucket, one list's block table and
+// one block rather than the whole list of a common trigram like "an".
+class TrigramIndex {
+private:
+    struct Block;
+    struct PostingList;
+
+    struct Posting {
+        std::uint32_t trigram;
+        std::shared_ptr<PostingList> list;
+    };
+
+    struct Bucket {
+        std::vector<Posting> postings;  // sorted by trigram
+    };
+
+    static constexpr size_t kBuckets = 256;
+    std::array<std::shared_ptr<Bucket>, kBuckets> buckets;  // null while empty
+    size_t trigrams = 0;
+
+    // Candidate count below which the remaining posting lists are not searched
+    static constexpr size_t kVerifyDirectly = 64;
+
+    // Distinct trigrams of already folded text, sorted
+    static std::vector<std::uint32_t> trigramsOf(std::string_view folded);
+
+    static size_t bucketOf(std::uint32_t trigram);
+    static bool trigramBefore(const Posting& posting, std::uint32_t trigram);
+    Bucket& writableBucket(std::uint32_t trigram);
+    static PostingList& writable(Posting& posting);
+    void insert(std::uint32_t trigram, std::uint32_t slot);
+    void erase(std::uint32_t trigram, std::uint32_t slot);
+    const PostingList* find(std::uint32_t trigram) const;
+
+public:
+    static constexpr size_t kMinQueryLength = 3;
+
+    // ASCII case folding used for both indexed text and queries
+    static char fold(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    static std::string fold(std::string_view text);
+
+    void add(std::uint32_t slot, std::string_view text);
+    void remove(std::uint32_t slot, std::string_view text);
+
+    // Reindex a slot whose text changed, touching only the trigrams that differ
+    void update(std::uint32_t slot, std::string_view oldText, std::string_view newText);
+
+    void clear();
+
+    // Sorted slots that may contain the folded needle, which must be at least
+    // kMinQueryLength long: every slot with all of its trigrams, and possibly
+    // a few without
+    std::vector<std::uint32_t> candidates(std::string_view foldedNeedle) const;
+
+    // Upper bound on the candidates of a folded needle without producing
+    // them: the length of its rarest trigram's posting list
+    size_t estimate(std::string_view foldedNeedle) const;
+
+    size_t trigramCount() const;
+};
+
+#endif // TRIGRAM_INDEX_H
@@ -0,0 +1,197 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <utility>
+#include "logger.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Bounded ring of task pointers. Submitters fill it at the bottom, one at a
+// time; the owning worker and thieves take from the top with a CAS, oldest
+// first, so connections are served in arrival order. top and bottom only grow,
+// so a CAS on top cannot succeed on a slot that has since been refilled.
+struct WorkStealingPool::Deque {
+    alignas(64) std::atomic<std::uint64_t> top{0};
+    alignas(64) std::atomic<std::uint64_t> bottom{0};
+    std::atomic_flag filling = ATOMIC_FLAG_INIT;
+    std::unique_ptr<std::atomic<std::function<void()>*>[]> slots;
+    std::uint64_t mask;
+
+    alignas(64) std::atomic<std::uint64_t> completed{0};
+    std::atomic<std::uint64_t> steals{0};
+
+    explicit Deque(size_t capacity)
+        : slots(new std::atomic<std::function<void()>*>[capacity]), mask(capacity - 1) {
+        for (size_t slot = 0; slot < capacity; slot++) {
+            slots[slot].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(std::function<void()>* task) {
+        while (filling.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        std::uint64_t b = bottom.load(std::memory_order_relaxed);
+        bool full = b - top.load(std::memory_order_acquire) > mask;
+        if (!full) {
+            slots[b & mask].store(task, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_release);
+        }
+        filling.clear(std::memory_order_release);
+        return !full;
+    }
+
+    std::function<void()>* pop() {
+        std::uint64_t t = top.load(std::memory_order_acquire);
+        while (t < bottom.load(std::memory_order_acquire)) {
+            std::function<void()>* task = slots[t & mask].load(std::memory_order_relaxed);
+            if (top.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    std::uint64_t size() const {
+        std::uint64_t t = top.load(std::memory_order_acquire);
+        std::uint64_t b = bottom.load(std::memory_order_acquire);
+        return b > t ? b - t : 0;
+    }
+};
+
+WorkStealingPool::WorkStealingPool(size_t workers, size_t capacityPerWorker, bool pinWorkers) {
+    workers = std::max<size_t>(workers, 1);
+    size_t capacity = 1;
+    while (capacity < capacityPerWorker) {
+        capacity <<= 1;
+    }
+    for (size_t worker = 0; worker < workers; worker++) {
+        deques.push_back(std::make_unique<Deque>(capacity));
+    }
+
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t worker = 0; worker < workers; worker++) {
+        threads.emplace_back(&WorkStealingPool::run, this, worker);
+        if (!pinWorkers) {
+            continue;
+        }
+#ifdef __linux__
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(worker % cpus, &cpuset);
+        if (pthread_setaffinity_np(threads.back().native_handle(), sizeof(cpuset), &cpuset) != 0) {
+            Logger::warn("Could not pin worker {} to CPU {}", worker, worker % cpus);
+        }
+#else
+        (void) cpus;
+        Logger::warn("Worker CPU pinning is only supported on Linux");
+        pinWorkers = false;
+#endif
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    shutdown();
+    // Only tasks that raced with shutdown can be left
+    for (auto& deque : deques) {
+        while (auto* task = deque->pop()) {
+            delete task;
+        }
+    }
+}
+
+bool WorkStealingPool::enqueue(std::function<void()> task) {
+    if (stopping.load()) {
+        return false;
+    }
+
+    // Counted before it is visible, so a worker that takes it never sees
+    // queued drop below zero
+    queued.fetch_add(1);
+    auto* boxed = new std::function<void()>(std::move(task));
+    size_t first = nextDeque.fetch_add(1, std::memory_order_relaxed) % deques.size();
+    bool pushed = false;
+    for (size_t offset = 0; offset < deques.size() && !pushed; offset++) {
+        pushed = deques[(first + offset) % deques.size()]->push(boxed);
+    }
+    if (!pushed) {
+        queued.fetch_sub(1);
+        delete boxed;
+        rejectedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    enqueuedCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Pairs with the sleepers increment in run(): either the worker sees the
+    // task before waiting or this sees the sleeper and wakes it
+    if (sleepers.load() > 0) {
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wake.notify_one();
+    }
+    return true;
+}
+
+std::function<void()>* WorkStealingPool::take(size_t worker) {
+    if (auto* task = deques[worker]->pop()) {
+        return task;
+    }
+    for (size_t offset = 1; offset < deques.size(); offset++) {
+        if (auto* task = deques[(worker + offset) % deques.size()]->pop()) {
+            deques[worker]->steals.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void WorkStealingPool::run(size_t worker) {
+    while (true) {
+        if (auto* task = take(worker)) {
+            queued.fetch_sub(1);
+            (*task)();
+            delete task;
+            deques[worker]->completed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers.fetch_add(1);
+        wake.wait(lock, [&]() { return queued.load() > 0 || stopping.load(); });
+        sleepers.fetch_sub(1);
+        if (stopping.load() && queued.load() == 0) {
+            break;
+        }
+    }
+}
+
+void WorkStealingPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (stopping.exchange(true)) {
+            return;
+        }
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+size_t WorkStealingPool::workerCount() const {
+    return deques.size();
+}
+
+TaskPoolStats WorkStealingPool::stats() const {
+    TaskPoolStats snapshot;
+    snapshot.workers = deques.size();
+    snapshot.enqueued = enqueuedCount.load(std::memory_order_relaxed);
+    snapshot.rejected = rejectedCount.load(std::memory_order_relaxed);
+    for (const auto& deque : deques) {
+        snapshot.depth += deque->size();
+        snapshot.completed += deque->completed.load(std::memory_order_relaxed);
+        snapshot.steals += deque->steals.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
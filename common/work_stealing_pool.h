@@ -0,0 +1,66 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct TaskPoolStats {
+    std::uint64_t workers = 0;
+    std::uint64_t depth = 0;      // tasks queued and not yet started
+    std::uint64_t enqueued = 0;
+    std::uint64_t completed = 0;
+    std::uint64_t steals = 0;     // tasks a worker took from another worker's deque
+    std::uint64_t rejected = 0;   // tasks refused because every deque was full
+};
+
+// Thread pool with one bounded deque per worker. Submitted tasks are spread
+// over the deques round robin; a worker runs tasks from its own deque and,
+// once that is empty, steals from the others. Taking a task is a single CAS,
+// so workers never share a lock, and submitters only contend with each other
+// on the deque they are filling. Idle workers sleep until a task arrives.
+class WorkStealingPool {
+private:
+    struct Deque;
+
+    std::vector<std::unique_ptr<Deque>> deques;
+    std::vector<std::thread> threads;
+    std::atomic<std::uint64_t> nextDeque{0};
+    std::atomic<std::uint64_t> queued{0};
+    std::atomic<std::uint64_t> enqueuedCount{0};
+    std::atomic<std::uint64_t> rejectedCount{0};
+    std::atomic<bool> stopping{false};
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> sleepers{0};
+
+    void run(size_t worker);
+    std::function<void()>* take(size_t worker);
+
+public:
+    // capacityPerWorker is rounded up to a power of two; pinWorkers binds
+    // worker i to CPU i modulo the CPU count (Linux only)
+    WorkStealingPool(size_t workers, size_t capacityPerWorker = 4096, bool pinWorkers = false);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Queue a task; false if the pool is shutting down or every deque is full
+    bool enqueue(std::function<void()> task);
+
+    // Run everything already queued, then stop and join the workers
+    void shutdown();
+
+    size_t workerCount() const;
+    TaskPoolStats stats() const;
+};
+
+#endif // WORK_STEALING_POOL_H
@@ -4,6 +4,10 @@
 #include <string>
 #include <vector>
 #include "employee.h"
+#include "employee_api.h"
+#include "journal_writer.h"
+#include "request_lanes.h"
+#include "work_stealing_pool.h"
 #include "nlohmann/json.hpp"
 
 using json = nlohmann::json;
@@ -52,6 +56,100 @@ public:
         json data = formatEmployee(employee);
         return formatApiResponse(data, status);
     }
+
+    // Format the journal writer counters, with averages derived per batch
+    static json formatPersistenceStats(const PersistenceStats& stats) {
+        json j;
+        j["mode"] = durabilityModeName(stats.mode);
+        j["batches"] = stats.batches;
+        j["records"] = stats.records;
+        j["failed_batches"] = stats.failedBatches;
+        j["pending_records"] = stats.pendingRecords;
+        j["max_batch_size"] = stats.maxBatchSize;
+        j["avg_batch_size"] = stats.batches ? static_cast<double>(stats.records) / stats.batches : 0.0;
+        j["last_commit_us"] = stats.lastCommitMicros;
+        j["max_commit_us"] = stats.maxCommitMicros;
+        j["avg_commit_us"] = stats.batches ? stats.totalCommitMicros / stats.batches : 0;
+        return j;
+    }
+
+    // Format the writer thread's batch counters
+    static json formatMutationStats(const MutationStats& stats) {
+        json j;
+        j["batches"] = stats.batches;
+        j["mutations"] = stats.mutations;
+        j["pending"] = stats.pending;
+        j["max_batch_size"] = stats.maxBatchSize;
+        j["avg_batch_size"] = stats.batches ? static_cast<double>(stats.mutations) / stats.batches : 0.0;
+        return j;
+    }
+
+    // Format the request worker pool counters
+    static json formatTaskPoolStats(const TaskPoolStats& stats) {
+        json j;
+        j["workers"] = stats.workers;
+        j["depth"] = stats.depth;
+        j["enqueued"] = stats.enqueued;
+        j["completed"] = stats.completed;
+        j["steals"] = stats.steals;
+        j["rejected"] = stats.rejected;
+        return j;
+    }
+
+    // Format one access path the query planner costed
+    static json formatAccessPlan(const AccessPlan& access) {
+        json j;
+        j["access"] = accessPathName(access.path);
+        j["predicate"] = access.predicate ? json(access.predicate->describe()) : json(nullptr);
+        j["estimated_rows"] = access.estimatedRows;
+        j["cost"] = access.cost;
+        return j;
+    }
+
+    // Format the plan of a query and what running it took
+    static json formatQueryPlan(const QueryResult& result) {
+        json j;
+        j["driver"] = formatAccessPlan(result.plan.driver);
+        j["considered"] = json::array();
+        for (const auto& access : result.plan.considered) {
+            j["considered"].push_back(formatAccessPlan(access));
+        }
+        j["residual"] = json::array();
+        for (const Filter* conjunct : result.plan.residual.conjuncts()) {
+            j["residual"].push_back(conjunct->describe());
+        }
+        j["rows_examined"] = result.rowsExamined;
+        j["rows_matched"] = result.total;
+        return j;
+    }
+
+    // Format one request lane's counters and latency percentiles
+    static json formatLaneStats(const LaneStats& stats) {
+        json j;
+        j["workers"] = stats.workers;
+        j["depth"] = stats.depth;
+        j["completed"] = stats.completed;
+        j["rejected"] = stats.rejected;
+        j["wait_p50_us"] = stats.waitP50Micros;
+        j["wait_p99_us"] = stats.waitP99Micros;
+        j["service_p50_us"] = stats.serviceP50Micros;
+        j["service_p99_us"] = stats.serviceP99Micros;
+        j["max_us"] = stats.maxMicros;
+        return j;
+    }
+
+    // Format the background snapshot counters
+    static json formatSnapshotStats(const SnapshotStats& stats) {
+        json j;
+        j["running"] = stats.running;
+        j["completed"] = stats.completed;
+        j["failed"] = stats.failed;
+        j["last_duration_ms"] = stats.lastDurationMillis;
+        j["last_child_rss_growth_kb"] = stats.lastRssGrowthKb;
+        j["last_copy_on_write_kb"] = stats.lastCopyOnWriteKb;
+        j["last_success_unix"] = stats.lastSuccessUnix;
+        return j;
+    }
 };
 
 #endif // API_FORMATTER_H
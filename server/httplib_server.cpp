@@ -1,11 +1,26 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include "employee_api.h"
 #include "httplib.h"
 #include "nlohmann/json.hpp"
 #include "api_formatter.h"
+#include "levenshtein_automaton.h"
 #include "logger.h"
+#include "request_lanes.h"
 #include "timer.h"
+#include "work_stealing_pool.h"
 
 using json = nlohmann::json;
 
@@ -21,16 +36,156 @@ json employeeToJson(const Employee& emp) {
     return j;
 }
 
+// Persistence settings come from the environment, falling back to the defaults:
+//   EMPLOYEE_DATA_FILE       snapshot path; a .bin extension selects the binary format
+//   EMPLOYEE_DURABILITY      sync | group | async
+//   EMPLOYEE_GROUP_COMMIT_MS batch window for group commit
+//   EMPLOYEE_ASYNC_FLUSH_MS  flush deadline for async mode
+//   EMPLOYEE_SHARDS          number of independently locked store shards
+//   EMPLOYEE_WORKERS         connection threads; they hand each request to its lane
+//   EMPLOYEE_PIN_WORKERS     1 to pin each worker thread to its own CPU
+//   EMPLOYEE_TASK_QUEUE      stealing (default) | threadpool for httplib's own pool
+//   EMPLOYEE_<LANE>_WORKERS  worker threads of a lane (POINT, SCAN or MUTATION)
+//   EMPLOYEE_<LANE>_QUEUE    requests a lane queues before answering 503
+PersistenceOptions persistenceOptionsFromEnv() {
+    PersistenceOptions options;
+    if (const char* mode = std::getenv("EMPLOYEE_DURABILITY")) {
+        if (!parseDurabilityMode(mode, options.durability)) {
+            Logger::warn("Unknown EMPLOYEE_DURABILITY '{}', using {}", mode, durabilityModeName(options.durability));
+        }
+    }
+    if (const char* window = std::getenv("EMPLOYEE_GROUP_COMMIT_MS")) {
+        options.groupCommitWindow = std::chrono::milliseconds(std::atoi(window));
+    }
+    if (const char* interval = std::getenv("EMPLOYEE_ASYNC_FLUSH_MS")) {
+        options.asyncFlushInterval = std::chrono::milliseconds(std::atoi(interval));
+    }
+    return options;
+}
+
+size_t shardCountFromEnv() {
+    const char* shards = std::getenv("EMPLOYEE_SHARDS");
+    int count = shards ? std::atoi(shards) : 0;
+    return count > 0 ? static_cast<size_t>(count) : kDefaultShardCount;
+}
+
+// Connection threads mostly wait for their request's lane, so there are more
+// of them than cores; the scan lane can hold at most its workers plus its
+// queue, which leaves the rest free for point reads
+constexpr size_t kDefaultConnectionWorkers = 64;
+
+size_t countFromEnv(const char* name, size_t fallback) {
+    const char* value = std::getenv(name);
+    int count = value ? std::atoi(value) : 0;
+    return count > 0 ? static_cast<size_t>(count) : fallback;
+}
+
+size_t workerCountFromEnv() {
+    return countFromEnv("EMPLOYEE_WORKERS", std::max<size_t>(kDefaultConnectionWorkers, CPPHTTPLIB_THREAD_POOL_COUNT));
+}
+
+std::array<LaneOptions, kLaneCount> laneOptionsFromEnv() {
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::array<LaneOptions, kLaneCount> options;
+    LaneOptions& point = options[static_cast<size_t>(Lane::PointRead)];
+    point.workers = countFromEnv("EMPLOYEE_POINT_WORKERS", std::max<size_t>(cores, 2));
+    point.queueCapacity = countFromEnv("EMPLOYEE_POINT_QUEUE", 1024);
+    LaneOptions& scan = options[static_cast<size_t>(Lane::Scan)];
+    scan.workers = countFromEnv("EMPLOYEE_SCAN_WORKERS", std::max<size_t>(cores / 4, 1));
+    scan.queueCapacity = countFromEnv("EMPLOYEE_SCAN_QUEUE", 16);
+    // Mutation workers only wait on the writer thread; more of them in flight
+    // means bigger batches
+    LaneOptions& mutation = options[static_cast<size_t>(Lane::Mutation)];
+    mutation.workers = countFromEnv("EMPLOYEE_MUTATION_WORKERS", 8);
+    mutation.queueCapacity = countFromEnv("EMPLOYEE_MUTATION_QUEUE", 1024);
+    return options;
+}
+
+// Whole decimal number in [low, high], nothing for anything else
+std::optional<long long> parseInteger(const std::string& text, long long low, long long high) {
+    if (text.empty() || (!std::isdigit(static_cast<unsigned char>(text[0])) && text[0] != '-')) {
+        return std::nullopt;
+    }
+    errno = 0;
+    char* end = nullptr;
+    long long value = std::strtoll(text.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || end == text.c_str() || value < low || value > high) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+void badRequest(httplib::Response& res, const std::string& message) {
+    json error;
+    error["status"] = "error";
+    error["message"] = message;
+    res.status = 400;
+    res.set_content(error.dump(), "application/json");
+}
+
+// Run a route handler on its lane's pool; a full lane answers 503 at once
+httplib::Server::Handler inLane(RequestLanes& lanes, Lane lane, httplib::Server::Handler handler) {
+    return [&lanes, lane, handler](const httplib::Request& req, httplib::Response& res) {
+        if (!lanes.run(lane, [&]() { handler(req, res); })) {
+            Logger::warn("{} {} - {} lane is full", req.method, req.path, laneName(lane));
+            json error;
+            error["status"] = "error";
+            error["message"] = std::string("Server busy, ") + laneName(lane) + " queue is full";
+            res.status = 503;
+            res.set_header("Retry-After", "1");
+            res.set_content(error.dump(), "application/json");
+        }
+    };
+}
+
+bool pinWorkersFromEnv() {
+    const char* pin = std::getenv("EMPLOYEE_PIN_WORKERS");
+    return pin && std::string_view(pin) == "1";
+}
+
+bool useWorkStealingFromEnv() {
+    const char* queue = std::getenv("EMPLOYEE_TASK_QUEUE");
+    return !queue || std::string_view(queue) != "threadpool";
+}
+
+// Hands httplib's connection tasks to the work-stealing pool. Each accepted
+// connection is one task that serves requests until the connection closes.
+class StealingTaskQueue : public httplib::TaskQueue {
+private:
+    std::shared_ptr<WorkStealingPool> pool;
+
+public:
+    explicit StealingTaskQueue(std::shared_ptr<WorkStealingPool> pool) : pool(std::move(pool)) {}
+
+    bool enqueue(std::function<void()> fn) override {
+        return pool->enqueue(std::move(fn));
+    }
+
+    void shutdown() override {
+        pool->shutdown();
+    }
+};
+
 int main() {
     // Initialize logger for the server component
     Logger::initForComponent(LogComponent::SERVER);
     Logger::info("Initializing Employee Management HTTP Server");
     
     // Initialize Employee API
-    EmployeeAPI api("common/employees.json");
+    const char* dataFile = std::getenv("EMPLOYEE_DATA_FILE");
+    EmployeeAPI api(dataFile ? dataFile : "common/employees.json", persistenceOptionsFromEnv(), shardCountFromEnv());
+    RequestLanes lanes(laneOptionsFromEnv());
     
     // Create a server instance
     httplib::Server svr;
+
+    // Request workers; httplib's default pool shares one locked job list
+    std::shared_ptr<WorkStealingPool> workers;
+    if (useWorkStealingFromEnv()) {
+        workers = std::make_shared<WorkStealingPool>(workerCountFromEnv(), 4096, pinWorkersFromEnv());
+        svr.new_task_queue = [workers]() { return new StealingTaskQueue(workers); };
+        Logger::info("Serving requests with {} work-stealing workers", workers->workerCount());
+    }
     
     Logger::info("Setting up server routes and CORS");
     
@@ -50,7 +205,7 @@ int main() {
     });
 
     // GET /api/employees - Get all employees
-    svr.Get("/api/employees", [&api](const httplib::Request& req, httplib::Response& res) {
+    svr.Get("/api/employees", inLane(lanes, Lane::Scan, [&api](const httplib::Request& req, httplib::Response& res) {
         (void) req;
         Logger::debug("GET /api/employees - Request for all employees");
         
@@ -60,14 +215,43 @@ int main() {
         std::string responseStr = ApiFormatter::formatEmployeeListResponse(employees);
         
         res.set_content(responseStr, "application/json");
-    });
+    }));
     
     // Note: GET /api/employees/id/{id} endpoint is now defined at the bottom of the file using ApiFormatter
     
     // GET /api/employees/search/name/{name} - Get employees by name
-    svr.Get(R"(/api/employees/search/name/(.+))", [&api](const httplib::Request& req, httplib::Response& res) {
+    // With ?fuzzy=1&maxEdits=N, names with words within N edits of the query's, closest first
+    svr.Get(R"(/api/employees/search/name/(.+))", inLane(lanes, Lane::Scan, [&api](const httplib::Request& req, httplib::Response& res) {
         auto name = req.matches[1];
         Logger::debug("GET /api/employees/search/name/{} - Searching employees by name", name.str());
+
+        if (req.get_param_value("fuzzy") == "1") {
+            auto maxEdits = req.has_param("maxEdits")
+                                ? parseInteger(req.get_param_value("maxEdits"), 0, LevenshteinAutomaton::kMaxEdits)
+                                : std::optional<long long>(LevenshteinAutomaton::kMaxEdits);
+            if (!maxEdits) {
+                badRequest(res, "maxEdits must be an integer from 0 to " + std::to_string(LevenshteinAutomaton::kMaxEdits));
+                return;
+            }
+
+            Timer timer("searchEmployeesByNameFuzzy", LogComponent::SERVER);
+            auto matches = api.getEmployeesByNameFuzzy(name.str(), static_cast<int>(*maxEdits));
+            json data = json::array();
+            for (const auto& match : matches) {
+                json employee = ApiFormatter::formatEmployee(match.employee);
+                employee["edits"] = match.edits;
+                data.push_back(std::move(employee));
+            }
+            if (matches.empty()) {
+                res.status = 404;
+                res.set_content(ApiFormatter::formatApiResponse(data, "No employees found with the given name"), "application/json");
+                return;
+            }
+            res.set_content(ApiFormatter::formatApiResponse(data, "Successfully retrieved employees"), "application/json");
+            Logger::info("GET /api/employees/search/name/{} - Found {} employees within {} edits",
+                         name.str(), matches.size(), *maxEdits);
+            return;
+        }
         
         // Start timing the operation
         Timer timer("searchEmployeesByName", LogComponent::SERVER);
@@ -90,10 +274,37 @@ int main() {
             res.status = 404;
             res.set_content(response.dump(4), "application/json");
         }
-    });
-    
+    }));
+
+    // GET /api/employees/autocomplete?prefix=..&limit=.. - Names and emails starting with a prefix.
+    // The limit is capped, so it costs an index walk of bounded length like any other point read.
+    svr.Get("/api/employees/autocomplete", inLane(lanes, Lane::PointRead, [&api](const httplib::Request& req, httplib::Response& res) {
+        const std::string prefix = req.get_param_value("prefix");
+        Logger::debug("GET /api/employees/autocomplete - Completions for '{}'", prefix);
+
+        constexpr long long kMaxCompletions = 100;
+        if (prefix.empty()) {
+            badRequest(res, "prefix must not be empty");
+            return;
+        }
+        auto limit = req.has_param("limit") ? parseInteger(req.get_param_value("limit"), 1, kMaxCompletions)
+                                            : std::optional<long long>(10);
+        if (!limit) {
+            badRequest(res, "limit must be an integer from 1 to " + std::to_string(kMaxCompletions));
+            return;
+        }
+
+        auto completions = api.getCompletions(prefix, static_cast<size_t>(*limit));
+        json data = json::array();
+        for (const auto& completion : completions) {
+            data.push_back({{"value", completion.value}, {"field", completion.field}, {"id", completion.id}});
+        }
+        res.set_content(ApiFormatter::formatApiResponse(data, "Successfully retrieved completions"), "application/json");
+        Logger::info("GET /api/employees/autocomplete - {} completions for '{}'", completions.size(), prefix);
+    }));
+
     // POST /api/employees - Add new employee
-    svr.Post("/api/employees", [&api](const httplib::Request& req, httplib::Response& res) {
+    svr.Post("/api/employees", inLane(lanes, Lane::Mutation, [&api](const httplib::Request& req, httplib::Response& res) {
         Logger::debug("POST /api/employees - Request to add a new employee");
         
         try {
@@ -116,23 +327,13 @@ int main() {
             // Create a new employee
             Employee emp;
             
-            // Auto-generate ID by finding max ID and incrementing
-            Logger::debug("POST /api/employees - Auto-generating employee ID");
-            auto employees = api.getAllEmployees();
-            int maxId = 0;
-            for (const auto& e : employees) {
-                try {
-                    int id = std::stoi(e.getId());
-                    if (id > maxId) maxId = id;
-                } catch (const std::exception& ex) {
-                    Logger::debug("POST /api/employees - Skipping non-numeric ID: {}", e.getId());
-                    // Skip non-numeric IDs
-                }
+            // Keep a client-supplied id (e.g. a UUID from the upstream API),
+            // otherwise the next numeric one is assigned when adding
+            bool idSupplied = bodyJson.contains("id");
+            if (idSupplied) {
+                emp.setId(bodyJson["id"].get<std::string>());
             }
             
-            Logger::debug("POST /api/employees - Generated new ID: {}", maxId + 1);
-            
-            emp.setId(std::to_string(maxId + 1));
             emp.setName(bodyJson["employee_name"].get<std::string>());
             emp.setSalary(bodyJson["employee_salary"].is_string() ? 
                 bodyJson["employee_salary"].get<std::string>() : 
@@ -147,13 +348,31 @@ int main() {
             Logger::info("POST /api/employees - Adding new employee: Name={}, Title={}", 
                           emp.getName(), emp.getTitle());
                           
-            if (api.addEmployee(emp)) {
+            // The writer thread applies the add; wait for its outcome
+            MutationResult result = api.submit(idSupplied ? Mutation::add(emp) : Mutation::addWithNextId(emp)).get();
+            emp.setId(result.id);
+            if (result.status == MutationStatus::Ok) {
                 Logger::info("POST /api/employees - Successfully added employee with ID: {}", emp.getId());
                 std::string responseStr = ApiFormatter::formatSingleEmployeeResponse(
                     emp, "Employee added successfully");
                 
                 res.status = 201; // Created
                 res.set_content(responseStr, "application/json");
+            } else if (result.status == MutationStatus::AlreadyExists) {
+                Logger::warn("POST /api/employees - Employee with ID {} already exists", emp.getId());
+                json error;
+                error["status"] = "error";
+                error["message"] = "Employee with this ID already exists";
+                res.status = 409;
+                res.set_content(error.dump(), "application/json");
+            } else if (result.status == MutationStatus::Conflict) {
+                Logger::warn("POST /api/employees - Another employee already has the {} of employee {}: {}",
+                             result.conflict, emp.getId(), emp.getEmail());
+                json error;
+                error["status"] = "error";
+                error["message"] = "Another employee already has this " + result.conflict;
+                res.status = 409;
+                res.set_content(error.dump(), "application/json");
             } else {
                 Logger::error("POST /api/employees - Failed to add employee with ID: {}", emp.getId());
                 json error;
@@ -170,15 +389,16 @@ int main() {
             res.status = 400;
             res.set_content(error.dump(), "application/json");
         }
-    });
+    }));
     
     // PUT /api/employees/{id} - Update employee
-    svr.Put(R"(/api/employees/update/([^/]+))", [&api](const httplib::Request& req, httplib::Response& res) {
+    svr.Put(R"(/api/employees/update/([^/]+))", inLane(lanes, Lane::Mutation, [&api](const httplib::Request& req, httplib::Response& res) {
         auto id = req.matches[1];
         
-        // Check if employee exists
-        Employee* emp = api.getEmployeeById(id);
-        if (emp == nullptr) {
+        // Check if employee exists; the handle notices if it is deleted meanwhile
+        std::optional<EmployeeHandle> handle = api.findEmployee(id.str());
+        std::optional<Employee> emp = handle ? api.getEmployee(*handle) : std::nullopt;
+        if (!emp) {
             json error;
             error["status"] = "error";
             error["message"] = "Employee not found";
@@ -216,11 +436,26 @@ int main() {
             }
             
             // Update employee
-            if (api.updateEmployee(*emp)) {
+            MutationResult result = api.submit(Mutation::update(*handle, *emp)).get();
+            if (result.status == MutationStatus::Ok) {
                 std::string responseStr = ApiFormatter::formatSingleEmployeeResponse(
                     *emp, "Employee updated successfully");
                 
                 res.set_content(responseStr, "application/json");
+            } else if (result.status == MutationStatus::NotFound) {
+                json error;
+                error["status"] = "error";
+                error["message"] = "Employee was deleted during the update";
+                res.status = 409;
+                res.set_content(error.dump(), "application/json");
+            } else if (result.status == MutationStatus::Conflict) {
+                Logger::warn("PUT /api/employees/update/{} - Another employee already has its {}: {}",
+                             emp->getId(), result.conflict, emp->getEmail());
+                json error;
+                error["status"] = "error";
+                error["message"] = "Another employee already has this " + result.conflict;
+                res.status = 409;
+                res.set_content(error.dump(), "application/json");
             } else {
                 json error;
                 error["status"] = "error";
@@ -235,15 +470,15 @@ int main() {
             res.status = 400;
             res.set_content(error.dump(), "application/json");
         }
-    });
+    }));
     
     // DELETE /api/employees/{id} - Delete employee
-    svr.Delete(R"(/api/employees/id/([^/]+))", [&api](const httplib::Request& req, httplib::Response& res) {
+    svr.Delete(R"(/api/employees/id/([^/]+))", inLane(lanes, Lane::Mutation, [&api](const httplib::Request& req, httplib::Response& res) {
         auto id = req.matches[1];
         
         // Check if employee exists
-        Employee* emp = api.getEmployeeById(id);
-        if (emp == nullptr) {
+        std::optional<EmployeeHandle> handle = api.findEmployee(id.str());
+        if (!handle) {
             json error;
             error["status"] = "error";
             error["message"] = "Employee not found";
@@ -253,12 +488,19 @@ int main() {
         }
         
         // Delete employee
-        if (api.deleteEmployee(id)) {
+        MutationResult result = api.submit(Mutation::remove(*handle)).get();
+        if (result.status == MutationStatus::Ok) {
             json data = {{
                 "message", "Employee deleted successfully"
             }};
             std::string responseStr = ApiFormatter::formatApiResponse(data, "Success");
             res.set_content(responseStr, "application/json");
+        } else if (result.status == MutationStatus::NotFound) {
+            json error;
+            error["status"] = "error";
+            error["message"] = "Employee not found";
+            res.status = 404;
+            res.set_content(error.dump(), "application/json");
         } else {
             json error;
             error["status"] = "error";
@@ -266,10 +508,10 @@ int main() {
             res.status = 500;
             res.set_content(error.dump(), "application/json");
         }
-    });
+    }));
     
     // GET /api/employees/highestSalary - Get highest salary amongst all employees
-    svr.Get("/api/employees/highestSalary", [&api](const httplib::Request& req, httplib::Response& res) {
+    svr.Get("/api/employees/highestSalary", inLane(lanes, Lane::PointRead, [&api](const httplib::Request& req, httplib::Response& res) {
         (void) req;
         Logger::debug("GET /api/employees/highestSalary - Request for highest salary");
         
@@ -287,18 +529,27 @@ int main() {
         
         res.set_content(responseStr, "application/json");
         Logger::info("GET /api/employees/highestSalary - Returned highest salary: {}", highestSalary);
-    });
+    }));
     
-    // GET /api/employees/topEarners - Get top 10 highest earning employees
-    svr.Get("/api/employees/topEarners", [&api](const httplib::Request& req, httplib::Response& res) {
-        (void) req;
+    // GET /api/employees/topEarners?k=N - Get the N highest earning employees (10 by default)
+    svr.Get("/api/employees/topEarners", inLane(lanes, Lane::Scan, [&api](const httplib::Request& req, httplib::Response& res) {
         Logger::debug("GET /api/employees/topEarners - Request for top earning employees");
+
+        size_t k = 10;
+        if (req.has_param("k")) {
+            auto parsed = parseInteger(req.get_param_value("k"), 1, std::numeric_limits<long long>::max());
+            if (!parsed) {
+                badRequest(res, "k must be a positive integer");
+                return;
+            }
+            k = static_cast<size_t>(*parsed);
+        }
         
         // Start timing the operation
-        Timer timer("getTop10HighestEarningEmployees", LogComponent::SERVER);
+        Timer timer("getTopEarners", LogComponent::SERVER);
         
         // Execute the API call
-        auto topEmployees = api.getTop10HighestEarningEmployees();
+        auto topEmployees = api.getTopEarners(k);
         
         // Format the response
         std::string responseStr = ApiFormatter::formatEmployeeListResponse(topEmployees, "Successfully retrieved top earners");
@@ -307,10 +558,153 @@ int main() {
         
         res.set_content(responseStr, "application/json");
         Logger::info("GET /api/employees/topEarners - Returned {} top earning employees", topEmployees.size());
-    });
+    }));
+
+    // GET /api/employees/salaryRank/{id} - Where an employee's salary ranks, 1 being the highest
+    svr.Get(R"(/api/employees/salaryRank/([^/]+))", inLane(lanes, Lane::PointRead, [&api](const httplib::Request& req, httplib::Response& res) {
+        auto id = req.matches[1].str();
+        Logger::debug("GET /api/employees/salaryRank/{} - Request for salary rank", id);
+
+        auto rank = api.getSalaryRank(id);
+        if (!rank) {
+            json error;
+            error["status"] = "error";
+            error["message"] = api.getEmployeeById(id) ? "Employee salary is not numeric" : "Employee not found";
+            res.status = 404;
+            res.set_content(error.dump(), "application/json");
+            return;
+        }
+
+        json data;
+        data["id"] = id;
+        data["salary"] = rank->salary;
+        data["rank"] = rank->rank;
+        data["total"] = rank->total;
+        res.set_content(ApiFormatter::formatApiResponse(data, "Successfully retrieved salary rank"), "application/json");
+        Logger::info("GET /api/employees/salaryRank/{} - Rank {} of {}", id, rank->rank, rank->total);
+    }));
+
+    // GET /api/employees/salaryPercentile/{p} - Nearest-rank salary percentile, p from 0 to 100
+    svr.Get(R"(/api/employees/salaryPercentile/([^/]+))", inLane(lanes, Lane::PointRead, [&api](const httplib::Request& req, httplib::Response& res) {
+        const std::string text = req.matches[1].str();
+        Logger::debug("GET /api/employees/salaryPercentile/{} - Request for salary percentile", text);
+
+        char* end = nullptr;
+        double percentile = std::strtod(text.c_str(), &end);
+        if (text.empty() || *end != '\0' || !(percentile >= 0.0 && percentile <= 100.0)) {
+            badRequest(res, "Percentile must be a number from 0 to 100");
+            return;
+        }
+
+        auto salary = api.getSalaryAtPercentile(percentile);
+        if (!salary) {
+            json error;
+            error["status"] = "error";
+            error["message"] = "No employees with a numeric salary";
+            res.status = 404;
+            res.set_content(error.dump(), "application/json");
+            return;
+        }
+
+        json data;
+        data["percentile"] = percentile;
+        data["salary"] = *salary;
+        res.set_content(ApiFormatter::formatApiResponse(data, "Successfully retrieved salary percentile"), "application/json");
+        Logger::info("GET /api/employees/salaryPercentile/{} - Salary {}", text, *salary);
+    }));
+
+    // GET /api/employees/range?field=salary|age&min=..&max=..&limit=.. - Employees with the
+    // field in [min, max], lowest first, served from the field's ordered index
+    svr.Get("/api/employees/range", inLane(lanes, Lane::Scan, [&api](const httplib::Request& req, httplib::Response& res) {
+        const std::string field = req.get_param_value("field");
+        Logger::debug("GET /api/employees/range - Request for {} range", field);
+
+        const long long lowest = std::numeric_limits<std::int32_t>::min() + 1;  // below is kNotNumeric
+        const long long highest = std::numeric_limits<std::int32_t>::max();
+        auto bound = [&req](const char* name, long long fallback, long long low, long long high) {
+            return req.has_param(name) ? parseInteger(req.get_param_value(name), low, high)
+                                       : std::optional<long long>(fallback);
+        };
+        auto min = bound("min", lowest, lowest, highest);
+        auto max = bound("max", highest, lowest, highest);
+        auto limit = bound("limit", 100, 1, std::numeric_limits<long long>::max());
+        if (!min || !max) {
+            badRequest(res, "min and max must be 32-bit integers");
+            return;
+        }
+        if (*min > *max) {
+            badRequest(res, "min must not be greater than max");
+            return;
+        }
+        if (!limit) {
+            badRequest(res, "limit must be a positive integer");
+            return;
+        }
+
+        Timer timer("getEmployeesInRange", LogComponent::SERVER);
+        auto result = api.getEmployeesInRange(field, static_cast<std::int32_t>(*min), static_cast<std::int32_t>(*max),
+                                              static_cast<size_t>(*limit));
+        if (!result) {
+            badRequest(res, "field must be salary or age");
+            return;
+        }
+
+        json response;
+        response["data"] = ApiFormatter::formatEmployees(result->employees);
+        response["total"] = result->total;
+        response["status"] = "Successfully retrieved employees in range";
+        res.set_content(response.dump(4), "application/json");
+        Logger::info("GET /api/employees/range - Returned {} of {} employees with {} in [{}, {}]",
+                     result->employees.size(), result->total, field, *min, *max);
+    }));
+
+    // POST /api/employees/query - Employees passing a filter tree such as
+    // {"filter": {"and": [{"field": "title", "op": "contains", "value": "Engineer"},
+    //                     {"field": "salary", "op": ">", "value": 150000}]}, "limit": 100, "explain": true}
+    // The planner drives it from the cheapest index or a scan; explain adds the plan
+    svr.Post("/api/employees/query", inLane(lanes, Lane::Scan, [&api](const httplib::Request& req, httplib::Response& res) {
+        Logger::debug("POST /api/employees/query - Request to run a query");
+
+        json body = json::parse(req.body, nullptr, false);
+        if (body.is_discarded() || !body.is_object()) {
+            badRequest(res, "Request body must be a JSON object");
+            return;
+        }
+        std::string error;
+        auto filter = body.contains("filter") ? Filter::fromJson(body["filter"], error) : std::optional<Filter>(Filter());
+        if (!filter) {
+            badRequest(res, "Invalid filter: " + error);
+            return;
+        }
+        const json& limitJson = body.contains("limit") ? body["limit"] : json(100);
+        if (!limitJson.is_number_integer() || limitJson.get<long long>() < 1) {
+            badRequest(res, "limit must be a positive integer");
+            return;
+        }
+        const json& explainJson = body.contains("explain") ? body["explain"] : json(false);
+        if (!explainJson.is_boolean()) {
+            badRequest(res, "explain must be true or false");
+            return;
+        }
+
+        Timer timer("queryEmployees", LogComponent::SERVER);
+        auto result = api.query(*filter, static_cast<size_t>(limitJson.get<long long>()));
+
+        json response;
+        response["data"] = ApiFormatter::formatEmployees(result.employees);
+        response["total"] = result.total;
+        if (explainJson.get<bool>()) {
+            response["explain"] = ApiFormatter::formatQueryPlan(result);
+        }
+        response["status"] = "Successfully ran query";
+        res.set_content(response.dump(4), "application/json");
+        Logger::info("POST /api/employees/query - {} of {} employees matched {} via {}, {} rows examined",
+                     result.employees.size(), result.total, filter->describe(),
+                     accessPathName(result.plan.driver.path), result.rowsExamined);
+    }));
 
     // GET /api/employees/getEmployeesbyTitle - Get employees by title
-    svr.Get(R"(/api/employees/getEmployeesbyTitle/([^/]+))", [&api](const httplib::Request& req, httplib::Response& res) {
+    svr.Get(R"(/api/employees/getEmployeesbyTitle/([^/]+))", inLane(lanes, Lane::Scan, [&api](const httplib::Request& req, httplib::Response& res) {
         auto title = req.matches[1];
         Logger::debug("GET /api/employees/getEmployeesbyTitle/{} - Searching employees by title", title.str());
         
@@ -335,26 +729,84 @@ int main() {
             response["status"] = "No employees found with the given title";
             res.set_content(response.dump(4), "application/json");
         }
-    });
+    }));
     
     // GET /api/employees/{id} - Get employee by ID
-    svr.Get(R"(/api/employees/id/(.+))", [&api](const httplib::Request& req, httplib::Response& res) {
-        auto id = req.matches[1];
-        Logger::debug("GET /api/employees/id/{} - Request for employee by ID", id.str());
+    svr.Get(R"(/api/employees/id/(.+))", inLane(lanes, Lane::PointRead, [&api](const httplib::Request& req, httplib::Response& res) {
+        // View into the request path; the lookup itself does not allocate
+        std::string_view id(&*req.matches[1].first, static_cast<size_t>(req.matches[1].length()));
+        Logger::debug("GET /api/employees/id/{} - Request for employee by ID", id);
         
-        auto employee = api.getEmployeeById(id.str());
+        auto employee = api.getEmployeeById(id);
         
         if (employee) {
-            Logger::info("GET /api/employees/id/{} - Employee found: {}", id.str(), employee->getName());
+            Logger::info("GET /api/employees/id/{} - Employee found: {}", id, employee->getName());
             std::string responseStr = ApiFormatter::formatSingleEmployeeResponse(*employee);
             res.set_content(responseStr, "application/json");
         } else {
-            Logger::warn("GET /api/employees/id/{} - Employee not found", id.str());
+            Logger::warn("GET /api/employees/id/{} - Employee not found", id);
+            json response;
+            response["data"] = json::object();
+            response["status"] = "Error: Employee not found";
+            res.set_content(response.dump(4), "application/json");
+        }
+    }));
+    
+    // GET /api/employees/email/{email} - Get employee by email, ignoring case, from the unique email index
+    svr.Get(R"(/api/employees/email/(.+))", inLane(lanes, Lane::PointRead, [&api](const httplib::Request& req, httplib::Response& res) {
+        std::string_view email(&*req.matches[1].first, static_cast<size_t>(req.matches[1].length()));
+        Logger::debug("GET /api/employees/email/{} - Request for employee by email", email);
+
+        auto employee = api.getEmployeeByEmail(email);
+        if (employee) {
+            Logger::info("GET /api/employees/email/{} - Employee found: {}", email, employee->getId());
+            res.set_content(ApiFormatter::formatSingleEmployeeResponse(*employee), "application/json");
+        } else {
+            Logger::warn("GET /api/employees/email/{} - Employee not found", email);
             json response;
             response["data"] = json::object();
             response["status"] = "Error: Employee not found";
+            res.status = 404;
             res.set_content(response.dump(4), "application/json");
         }
+    }));
+
+    // POST /api/snapshot - Start a background snapshot (BGSAVE)
+    svr.Post("/api/snapshot", inLane(lanes, Lane::Mutation, [&api](const httplib::Request& req, httplib::Response& res) {
+        (void) req;
+        Logger::debug("POST /api/snapshot - Request for a background snapshot");
+        
+        if (api.compactJournal()) {
+            Logger::info("POST /api/snapshot - Background snapshot started");
+            res.status = 202; // Accepted
+            res.set_content(ApiFormatter::formatApiResponse(json::object(), "Background snapshot started"), "application/json");
+        } else {
+            json error;
+            error["status"] = "error";
+            error["message"] = "A snapshot is already in progress";
+            res.status = 409;
+            res.set_content(error.dump(), "application/json");
+        }
+    }));
+    
+    // GET /api/stats - Persistence and snapshot counters for tuning
+    // Served on the connection thread, so it answers even when every lane is full
+    svr.Get("/api/stats", [&api, &lanes, workers](const httplib::Request& req, httplib::Response& res) {
+        (void) req;
+        Logger::debug("GET /api/stats - Request for server statistics");
+        
+        json data;
+        data["persistence"] = ApiFormatter::formatPersistenceStats(api.getPersistenceStats());
+        data["snapshot"] = ApiFormatter::formatSnapshotStats(api.getSnapshotStats());
+        data["mutations"] = ApiFormatter::formatMutationStats(api.getMutationStats());
+        if (workers) {
+            data["workers"] = ApiFormatter::formatTaskPoolStats(workers->stats());
+        }
+        for (Lane lane : {Lane::PointRead, Lane::Scan, Lane::Mutation}) {
+            data["lanes"][laneName(lane)] = ApiFormatter::formatLaneStats(lanes.stats(lane));
+        }
+        
+        res.set_content(ApiFormatter::formatApiResponse(data, "Successfully retrieved statistics"), "application/json");
     });
     
     // Display API information and log it
@@ -365,13 +817,22 @@ int main() {
     std::cout << "Available endpoints:\n";
     std::cout << "GET    /api/employees                   - Get all employees\n";
     std::cout << "GET    /api/employees/id/{id}            - Get employee by ID\n";
+    std::cout << "GET    /api/employees/email/{email}     - Get employee by email (case-insensitive)\n";
     std::cout << "GET    /api/employees/search/name/{name} - Get employees by name\n";
+    std::cout << "GET    /api/employees/search/name/{name}?fuzzy=1&maxEdits=N - Get employees whose names are within N typos (0 to 2)\n";
     std::cout << "GET    /api/employees/highestSalary     - Get highest salary amongst all employees\n";
-    std::cout << "GET    /api/employees/topEarners        - Get top 10 highest earning employees\n";
+    std::cout << "GET    /api/employees/topEarners?k=N    - Get the N highest earning employees (10 by default)\n";
+    std::cout << "GET    /api/employees/salaryRank/{id}   - Get an employee's salary rank (1 is the highest)\n";
+    std::cout << "GET    /api/employees/salaryPercentile/{p} - Get the salary at percentile p (0 to 100)\n";
+    std::cout << "GET    /api/employees/range?field=salary|age&min=A&max=B&limit=N - Get employees with salary or age in [A, B], lowest first\n";
+    std::cout << "GET    /api/employees/autocomplete?prefix=P&limit=N - Get names and emails starting with P (10 by default)\n";
+    std::cout << "POST   /api/employees/query             - Get employees matching a filter, optionally with the plan\n";
     std::cout << "POST   /api/employees                   - Add new employee\n";
     std::cout << "PUT    /api/employees/update/{id}       - Update employee\n";
     std::cout << "DELETE /api/employees/id/{id}           - Delete employee\n";
     std::cout << "GET    /api/employees/getEmployeesbyTitle/{title} - Get employees by title\n";
+    std::cout << "POST   /api/snapshot                    - Start a background snapshot\n";
+    std::cout << "GET    /api/stats                       - Persistence statistics\n";
     std::cout << "----------------------------------------\n";
     
     Logger::info("Starting server on port 8112");
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "employee.h"
+#include "logger.h"
+#include "snapshot.h"
+#include "timer.h"
+
+// Convert an employee snapshot between formats; the format of each side is
+// taken from its file extension (.bin for binary, JSON otherwise).
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input snapshot> <output snapshot>\n"
+                  << "  e.g. " << argv[0] << " common/employees.json common/employees.bin\n"
+                  << "       " << argv[0] << " common/employees.bin common/employees.json\n";
+        return 1;
+    }
+
+    const std::string input = argv[1];
+    const std::string output = argv[2];
+    Timer timer("convertSnapshot");
+
+    std::vector<Employee> employees;
+    std::string error;
+    if (!Snapshot::read(input, [&employees](const Employee& emp) { employees.push_back(emp); }, error)) {
+        Logger::error("Could not read {}: {}", input, error);
+        std::cerr << "Could not read " << input << ": " << error << std::endl;
+        return 1;
+    }
+
+    bool ok = Snapshot::write(output, employees.size(), [&employees](const EmployeeVisitor& visit) {
+        for (const auto& emp : employees) {
+            visit(emp);
+        }
+    }, error);
+    if (!ok) {
+        Logger::error("Could not write {}: {}", output, error);
+        std::cerr << "Could not write " << output << ": " << error << std::endl;
+        return 1;
+    }
+
+    Logger::info("Converted {} employees from {} to {}", employees.size(), input, output);
+    std::cout << "Converted " << employees.size() << " employees from " << input << " to " << output << std::endl;
+    return 0;
+}